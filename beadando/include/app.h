@@ -3,6 +3,12 @@
 
 #include "camera.h"
 #include "scene.h"
+#include "cluster.h"
+#include "benchmark.h"
+#include "headless.h"
+#include "pacing.h"
+#include "occlusion.h"
+#include "hot_reload.h"
 #include <ode/ode.h>
 #include <SDL2/SDL.h>
 #include <GL/gl.h>
@@ -26,6 +32,33 @@ typedef struct Manual {
     bool prev_cam_orbital;
 } Manual;
 
+/**
+ * Options given on the command line.
+ */
+typedef struct AppOptions {
+    bool use_clustered;
+    int light_bench_count;
+    bool is_headless;
+    int width;
+    int height;
+    int bench_frames;
+    const char* bench_report_path;
+    const char* screenshot_path;
+    FramePacing pacing;
+    int fps_limit;
+    bool no_idle_throttle;
+    bool no_occlusion;
+    bool bake;
+    const char* obj_bench_path;
+    const char* config_bench_path;
+    int load_threads;
+    int stream_budget_mb;
+    const char* trace_path;
+    int trace_frames;
+    bool no_hot_reload;
+    bool packed_vertices;
+} AppOptions;
+
 /**
  * Main application state container.
  */
@@ -35,8 +68,10 @@ typedef struct App {
     int window_height;
     SDL_GLContext gl_context;
     bool is_running;
+    bool is_headless;
     bool is_fullscreen;
     bool is_dragging;
+    bool use_clustered;
     
     float drag_distance;
     float drag_offset_x;
@@ -45,12 +80,24 @@ typedef struct App {
     Manual manual;
     Camera camera;
     Scene scene;
+    ClusteredRenderer clustered;
+    LightBenchmark light_benchmark;
+    FrameBenchmark frame_benchmark;
+    HeadlessContext headless;
+    FramePacer pacer;
+    OcclusionCuller occlusion;
+    ConfigWatcher config_watcher;
 } App;
 
+/**
+ * Parse the command line options.
+ */
+void parse_app_options(AppOptions* options, int argc, char* argv[]);
+
 /**
  * Initialize the application.
  */
-void init_app(App* app, int width, int height);
+void init_app(App* app, int width, int height, const AppOptions* options);
 
 /**
  * Initialize the OpenGL context.
@@ -67,6 +114,16 @@ void reshape(App* app, GLsizei width, GLsizei height);
  */
 void handle_app_events(App* app);
 
+/**
+ * Check whether the scene is static, so that the next frame would look the same as the last one.
+ */
+bool is_app_idle(App* app);
+
+/**
+ * Wait for input instead of redrawing a static scene.
+ */
+void idle_app(App* app);
+
 /**
  * Update the application.
  */
@@ -0,0 +1,76 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Block size of the scene arena, a larger allocation gets a block of its own.
+#define SCENE_ARENA_BLOCK_SIZE (1024 * 1024)
+
+// Starting size of the frame arena, it grows to the largest frame seen.
+#define FRAME_ARENA_SIZE (256 * 1024)
+
+/**
+ * A block of the arena, the allocations follow the header.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t capacity;
+    size_t used;
+} ArenaBlock;
+
+/**
+ * Linear allocator handing out memory from blocks that are only freed together.
+ * The newest block is the first, the older blocks are not revisited.
+ */
+typedef struct Arena {
+    ArenaBlock* blocks;
+    size_t block_size;
+    size_t used;
+    size_t peak;
+    int block_count;
+} Arena;
+
+/**
+ * Transient memory of the main thread, valid until the end of the frame.
+ */
+extern Arena frame_arena;
+
+/**
+ * Allocate a zeroed array of count elements of the type from the arena.
+ */
+#define ARENA_ARRAY(arena, type, count) ((type*)arena_calloc(arena, (size_t)(count) * sizeof(type), _Alignof(type)))
+
+/**
+ * Create an empty arena, the first block is allocated on the first allocation.
+ */
+void init_arena(Arena* arena, size_t block_size);
+
+/**
+ * Allocate uninitialized memory with the given power of two alignment.
+ */
+void* arena_alloc(Arena* arena, size_t size, size_t alignment);
+
+/**
+ * Allocate zeroed memory with the given power of two alignment.
+ */
+void* arena_calloc(Arena* arena, size_t size, size_t alignment);
+
+/**
+ * Release every allocation at once. When the arena needed more than one block,
+ * they are replaced by a single block large enough for all of them, so the next round allocates nothing.
+ */
+void reset_arena(Arena* arena);
+
+/**
+ * Free the blocks of the arena.
+ */
+void free_arena(Arena* arena);
+
+/**
+ * Count of the heap allocations made by the calling thread, or -1 when they are not counted.
+ * They are only counted on glibc by the profiling build, which defines COUNT_ALLOCATIONS.
+ */
+long get_thread_heap_allocations(void);
+
+#endif /* ARENA_H */
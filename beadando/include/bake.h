@@ -0,0 +1,92 @@
+#ifndef BAKE_H
+#define BAKE_H
+
+#include "config.h"
+#include "lod.h"
+#include "texture.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BAKED_MESH_DIRECTORY "assets/baked"
+
+// "LMSH" read as a little endian integer.
+#define BAKED_MESH_MAGIC 0x48534D4Cu
+
+// Bump when the layout or the mesh processing changes, so every cached file is rebaked.
+#define BAKED_MESH_VERSION 4
+
+// "LTEX" read as a little endian integer, marks the DDS files baked from an image file.
+#define BAKED_TEXTURE_MAGIC 0x5845544Cu
+
+// Bump when the encoder changes, so every baked texture is rebaked.
+#define BAKED_TEXTURE_VERSION 1
+
+/**
+ * Byte offsets and counts of the vertex and index arrays of one level of detail.
+ */
+typedef struct BakedMeshLevel {
+    uint32_t vertex_offset;
+    uint32_t vertex_count;
+    uint32_t index_offset;
+    uint32_t index_count;
+} BakedMeshLevel;
+
+/**
+ * Header of a baked mesh file, followed by the interleaved MeshVertex and GLuint index arrays of each level.
+ */
+typedef struct BakedMeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t config_hash;
+    int64_t source_size;
+    int64_t source_mtime;
+    float aabb_min[3];
+    float aabb_max[3];
+    float radius;
+    uint32_t level_count;
+    BakedMeshLevel levels[MAX_LOD_LEVELS];
+} BakedMeshHeader;
+
+/**
+ * Create the directory of the baked files.
+ */
+void make_baked_directory(void);
+
+/**
+ * Move the written temporary file over the baked file, or remove it when writing it failed.
+ */
+bool replace_baked_file(const char* temp_path, const char* path, bool is_written);
+
+/**
+ * Map the baked mesh of the object when it is up to date with the OBJ file and the config entry.
+ */
+bool load_baked_mesh(const ObjectConfig* config, LodChain* lod, Vec3* aabb_min, Vec3* aabb_max);
+
+/**
+ * Write the prepared levels of detail of the object to its baked mesh file.
+ */
+bool save_baked_mesh(const ObjectConfig* config, const LodChain* lod, Vec3 aabb_min, Vec3 aabb_max);
+
+/**
+ * Rebake the mesh of every object in the config file, returns false if any of them failed.
+ */
+bool bake_object_meshes(const char* config_path);
+
+/**
+ * Read the baked compressed texture of the image file when it is up to date with the image.
+ */
+bool load_baked_texture(const char* source_path, TextureImage* image);
+
+/**
+ * Write the compressed image to the baked texture file of the image file.
+ */
+bool save_baked_texture(const char* source_path, const TextureImage* image);
+
+/**
+ * Compress every room and object texture in the config files, returns false if any of them failed.
+ */
+bool bake_textures(const char* room_config_path, const char* object_config_path);
+
+#endif /* BAKE_H */
@@ -0,0 +1,83 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "gl_loader.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Scene Scene;
+
+/**
+ * Compact vertex of the static world, half the size of MeshVertex. Positions are quantized to 16 bits over
+ * the bounds of the batch with one step on every axis, texture coordinates to 16 bits over their range,
+ * normals to signed bytes. The fixed-function pipeline reads the integers directly, the dequantization
+ * is done by the modelview and the texture matrix.
+ */
+typedef struct PackedVertex {
+    GLshort position[4];
+    GLbyte normal[4];
+    GLshort uv[2];
+} PackedVertex;
+
+/**
+ * Room faces and static props sharing a texture, in one vertex and index buffer.
+ */
+typedef struct StaticBatch {
+    GLuint texture;
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    bool is_packed;
+    float position_offset[3];
+    float position_step;
+    float uv_offset[2];
+    float uv_step[2];
+    bool is_dirty;
+    size_t vertex_bytes;
+    int* room_ids;
+    GLuint* room_first_index;
+    GLsizei* room_index_counts;
+    int room_count;
+    int* object_ids;
+    int object_count;
+    GLsizei* draw_counts;
+    const GLvoid** draw_offsets;
+} StaticBatch;
+
+/**
+ * The static part of the scene, drawn with one call per texture.
+ */
+typedef struct StaticWorld {
+    bool is_ready;
+    StaticBatch* batches;
+    int batch_count;
+    int dirty_count;
+    size_t vertex_bytes;
+} StaticWorld;
+
+/**
+ * Merge the room geometry and every level of the static props into per texture buffers,
+ * with packed vertices when the scene asks for them.
+ */
+bool build_static_world(StaticWorld* world, Scene* scene);
+
+/**
+ * Mark the batches whose resident rooms or static props changed, they are uploaded again by update_static_world.
+ */
+void invalidate_static_world(StaticWorld* world, Scene* scene);
+
+/**
+ * Upload the marked batches until budget_ms is spent, at least one per call. A budget of 0 uploads all of them.
+ */
+void update_static_world(StaticWorld* world, Scene* scene, int budget_ms);
+
+/**
+ * Draw the rooms and the visible static props at their current level of detail.
+ */
+void draw_static_world(const StaticWorld* world, const Scene* scene);
+
+/**
+ * Release the buffers of the batches.
+ */
+void destroy_static_world(StaticWorld* world);
+
+#endif /* BATCH_H */
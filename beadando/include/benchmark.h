@@ -0,0 +1,110 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "utils.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Loads of each OBJ loader, the fastest one is reported.
+#define OBJ_BENCHMARK_RUNS 5
+
+// Size of the object config generated for the config benchmark when its file is missing.
+#define CONFIG_BENCHMARK_SIZE_MB 100
+
+// Frames of the frame benchmark before its heap allocations are counted, the scene is still streaming in.
+#define BENCHMARK_STEADY_FRAME 60
+
+// Simulated time per frame while the frame benchmark runs.
+#define BENCHMARK_TIME_STEP (1.0 / 60.0)
+
+typedef struct App App;
+typedef struct Scene Scene;
+
+/**
+ * Compare the fixed-function and the clustered lighting path on a scene with many lights.
+ */
+typedef struct LightBenchmark {
+    bool enabled;
+    int light_count;
+    int warmup_frames;
+    int measured_frames;
+    int frame;
+    int path;
+    Uint64 path_start;
+    double path_ms[2];
+} LightBenchmark;
+
+/**
+ * Render a fixed number of frames along a scripted camera path and report frame time percentiles.
+ */
+typedef struct FrameBenchmark {
+    bool enabled;
+    int frame_count;
+    int frame;
+    double* frame_ms;
+    Uint64 frame_start;
+    long steady_allocations;
+    int allocating_frames;
+    const char* screenshot_path;
+    const char* report_path;
+    Vec3* path;
+    int path_length;
+    float path_total;
+} FrameBenchmark;
+
+/**
+ * Append randomly placed spotlights to the rooms of the scene.
+ */
+void add_benchmark_lights(Scene* scene, int count);
+
+/**
+ * Start the light benchmark with the fixed-function path.
+ */
+void start_light_benchmark(App* app, int light_count);
+
+/**
+ * Advance the light benchmark after a rendered frame, switching paths and reporting when done.
+ */
+void step_light_benchmark(App* app);
+
+/**
+ * Build the camera path through the rooms and start the frame benchmark.
+ */
+void start_frame_benchmark(App* app, int frame_count, const char* screenshot_path, const char* report_path);
+
+/**
+ * Move the camera to the current frame's point of the scripted path.
+ */
+void update_benchmark_camera(App* app);
+
+/**
+ * Save the final frame of the benchmark before it is presented.
+ */
+void capture_benchmark_frame(App* app);
+
+/**
+ * Record the frame time, and report and stop the application after the last frame.
+ */
+void step_frame_benchmark(App* app);
+
+/**
+ * Release the recorded frame times.
+ */
+void free_frame_benchmark(FrameBenchmark* bench);
+
+/**
+ * Save the current color buffer as a PNG file.
+ */
+bool save_framebuffer_png(const char* filename, int width, int height);
+
+/**
+ * Time libobj with mesh_from_model against load_obj_mesh on the same file.
+ */
+void run_obj_benchmark(const char* path);
+
+/**
+ * Compare the streaming object config reader with the json-c tree on the file, generating it when it is missing.
+ */
+void run_config_benchmark(const char* path);
+
+#endif /* BENCHMARK_H */
@@ -2,9 +2,13 @@
 #define CAMERA_H
 
 #include "utils.h"
+#include "matrix.h"
 #include <stdbool.h>
 #include <physics.h>
 
+#define CAMERA_NEAR_PLANE 0.1f
+#define CAMERA_FAR_PLANE 100.0f
+
 /**
  * Orientation of the camera.
  */
@@ -58,10 +62,25 @@ void init_camera_physics(PhysicsWorld* pw, Camera* cam);
 void update_camera(Camera* camera, double time);
 
 /**
- * Apply the camera settings to the view transformation.
+ * Load the view matrix of the camera as the modelview matrix.
  */
 void set_view(const Camera* camera);
 
+/**
+ * Load the perspective projection of the camera as the projection matrix.
+ */
+void set_projection(const Camera* camera);
+
+/**
+ * View matrix of the camera, computed on the CPU.
+ */
+void get_view_matrix(const Camera* camera, Mat4* view);
+
+/**
+ * Perspective projection matrix of the camera, computed on the CPU.
+ */
+void get_projection_matrix(const Camera* camera, Mat4* projection);
+
 /**
  * Set the horizontal and vertical rotation of the view angle.
  */
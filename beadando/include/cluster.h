@@ -0,0 +1,66 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "gl_loader.h"
+#include "camera.h"
+#include <stdbool.h>
+
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// Number of RGBA32F texels describing one light in the light buffer.
+#define CLUSTER_LIGHT_TEXELS 5
+
+typedef struct Scene Scene;
+
+/**
+ * Forward renderer shading each pixel with the lights of its view frustum cluster (froxel).
+ */
+typedef struct ClusteredRenderer {
+    bool is_ready;
+    GLuint program;
+
+    GLuint light_buffer;
+    GLuint light_texture;
+    GLuint grid_buffer;
+    GLuint grid_texture;
+    GLuint index_buffer;
+    GLuint index_texture;
+
+    GLint grid_size_location;
+    GLint viewport_size_location;
+    GLint near_plane_location;
+    GLint far_plane_location;
+    GLint global_light_count_location;
+
+    float* light_data;
+    GLuint* grid;
+    GLuint* indices;
+    int index_count;
+    int global_light_count;
+} ClusteredRenderer;
+
+/**
+ * Compile the cluster shaders and create the light buffers.
+ * Leaves is_ready false if the OpenGL context does not support them.
+ */
+bool init_clustered_renderer(ClusteredRenderer* renderer);
+
+/**
+ * Bin the scene lights into the froxel grid of the current view and upload the light lists.
+ */
+void update_light_clusters(ClusteredRenderer* renderer, const Scene* scene, const Camera* camera, const Mat4* view);
+
+/**
+ * Render the scene with per pixel clustered lighting.
+ */
+void render_scene_clustered(const Scene* scene, ClusteredRenderer* renderer, const Camera* camera);
+
+/**
+ * Release the shader program and the light buffers.
+ */
+void destroy_clustered_renderer(ClusteredRenderer* renderer);
+
+#endif /* CLUSTER_H */
@@ -34,20 +34,51 @@ typedef struct RoomConfig {
     int connection_count;
 } RoomConfig;
 
+/**
+ * The config files, each with its own schema.
+ */
+typedef enum ConfigKind {
+    CONFIG_ROOMS,
+    CONFIG_OBJECTS,
+    CONFIG_LIGHTS
+} ConfigKind;
+
+/**
+ * Check the field names, types, array lengths and string lengths of every entry against the schema of the file.
+ * Prints each problem and returns false if there was any.
+ */
+bool validate_config(const char* filename, ConfigKind kind);
+
 /**
  * Read the configuration file for lights.
  */
 void read_light_config(const char* filename, Lighting* light_config, int* light_config_count);
 
 /**
- * Read the configuration file for rooms.
+ * Read the configuration file for rooms into an array sized for the file, which the caller frees.
+ */
+RoomConfig* read_room_config(const char* filename, int* room_config_count);
+
+/**
+ * Receives each object config entry, returning false stops the reading.
+ */
+typedef bool (*ObjectConfigHandler)(const ObjectConfig* config, void* user_data);
+
+/**
+ * Read the configuration file for objects by streaming it into a growing array, which the caller frees.
+ */
+ObjectConfig* read_object_config(const char* filename, int* obj_config_count);
+
+/**
+ * Pass the object entries to the handler as they are tokenized, the memory use does not depend on the file size.
+ * Returns false when the file cannot be opened or has a syntax error, the entries before the error are passed.
  */
-void read_room_config(const char* filename, RoomConfig* room_config, int* room_config_count);
+bool stream_object_config(const char* filename, ObjectConfigHandler handler, void* user_data);
 
 /**
- * Read the configuration file for objects.
+ * Pass the object entries to the handler after building the json-c tree of the whole file.
  */
-void read_object_config(const char* filename, ObjectConfig* obj_config, int* obj_config_count);
+bool parse_object_config_tree(const char* filename, ObjectConfigHandler handler, void* user_data);
 
 /**
  * Read the manual file and format it for rendering.
@@ -0,0 +1,120 @@
+#ifndef CONFIG_BUNDLE_H
+#define CONFIG_BUNDLE_H
+
+#include "config.h"
+#include "filemap.h"
+#include "lighting.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CONFIG_BUNDLE_PATH "assets/baked/config.bin"
+
+// "LCFG" read as a little endian integer.
+#define CONFIG_BUNDLE_MAGIC 0x4746434Cu
+
+// Bump when a record layout changes, so the bundle is recompiled.
+#define CONFIG_BUNDLE_VERSION 1
+
+/**
+ * Size and modification time of a JSON file the bundle was compiled from.
+ */
+typedef struct BundleSource {
+    int64_t size;
+    int64_t mtime;
+} BundleSource;
+
+/**
+ * Header of the bundle, followed by the room, object and light records and the string table.
+ * The strings are offsets into the table, offset 0 is the empty string.
+ */
+typedef struct BundleHeader {
+    uint32_t magic;
+    uint32_t version;
+    BundleSource sources[3];
+    uint32_t room_offset;
+    uint32_t room_count;
+    uint32_t object_offset;
+    uint32_t object_count;
+    uint32_t light_offset;
+    uint32_t light_count;
+    uint32_t string_offset;
+    uint32_t string_size;
+} BundleHeader;
+
+typedef struct BundledRoom {
+    uint32_t name;
+    uint32_t floor_tex_path;
+    uint32_t ceiling_tex_path;
+    uint32_t wall_tex_path;
+    uint32_t connections[DIR_COUNT];
+    int32_t connection_count;
+    float dimension[3];
+} BundledRoom;
+
+typedef struct BundledObject {
+    uint32_t name;
+    uint32_t model_path;
+    uint32_t texture_path;
+    uint32_t room_name;
+    float offset[3];
+    float rotation[3];
+    float scale[3];
+    float mass;
+    int32_t value;
+    uint32_t is_static;
+} BundledObject;
+
+typedef struct BundledLight {
+    uint32_t name;
+    uint32_t room_name;
+    float ambient[4];
+    float diffuse[4];
+    float specular[4];
+    float position[4];
+    float direction[3];
+    float cutoff;
+    float exponent;
+    float brightness;
+    float range;
+    uint32_t is_spotlight;
+} BundledLight;
+
+/**
+ * A mapped bundle, the records point into the mapping.
+ */
+typedef struct ConfigBundle {
+    MappedFile file;
+    const BundleHeader* header;
+    const BundledRoom* rooms;
+    const BundledObject* objects;
+    const BundledLight* lights;
+    const char* strings;
+} ConfigBundle;
+
+/**
+ * Validate the config files against their schemas and the references between them,
+ * then write them to the bundle. Nothing is written when any of them is invalid.
+ */
+bool compile_config_bundle(const char* room_config_path, const char* object_config_path, const char* light_config_path);
+
+/**
+ * Map the bundle when it was compiled from the current config files.
+ * A config file that is missing does not make the bundle stale.
+ */
+bool open_config_bundle(ConfigBundle* bundle, const char* room_config_path, const char* object_config_path,
+    const char* light_config_path);
+
+/**
+ * Copy the records of the bundle into the config arrays, the counts are set like by the JSON readers.
+ * The room and object arrays have to hold the counts of the bundle header.
+ */
+void read_bundled_room_config(const ConfigBundle* bundle, RoomConfig* room_configs, int* room_count);
+void read_bundled_object_config(const ConfigBundle* bundle, ObjectConfig* object_configs, int* object_count);
+void read_bundled_light_config(const ConfigBundle* bundle, Lighting* light_configs, int* light_count);
+
+/**
+ * Unmap the bundle.
+ */
+void close_config_bundle(ConfigBundle* bundle);
+
+#endif /* CONFIG_BUNDLE_H */
@@ -0,0 +1,50 @@
+#ifndef DDS_H
+#define DDS_H
+
+#include "texture.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Words of the reserved header field, writers are free to put their own data there.
+#define DDS_TAG_WORDS 11
+
+/**
+ * Pixel format of a DDS file, only the FourCC of a block compressed format is used.
+ */
+typedef struct DdsPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t four_cc;
+    uint32_t rgb_bit_count;
+    uint32_t bit_masks[4];
+} DdsPixelFormat;
+
+/**
+ * Header of a DDS file after the "DDS " magic, followed by the mipmap levels, the largest first.
+ */
+typedef struct DdsHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t linear_size;
+    uint32_t depth;
+    uint32_t mipmap_count;
+    uint32_t tag[DDS_TAG_WORDS];
+    DdsPixelFormat pixel_format;
+    uint32_t caps[4];
+    uint32_t reserved;
+} DdsHeader;
+
+/**
+ * Read a DXT1, DXT3 or DXT5 texture into a compressed image, the tag receives the reserved header words.
+ */
+bool read_dds(const char* path, TextureImage* image, uint32_t* tag);
+
+/**
+ * Write a compressed image with the given reserved header words.
+ */
+bool write_dds(FILE* file, const TextureImage* image, const uint32_t* tag);
+
+#endif /* DDS_H */
@@ -36,15 +36,20 @@ void draw_string(GLuint tex, const char* s, float start_x, float start_y, float
 void draw_textured_quad(float normal[3], float tex_coords[4][2], float vertices[4][3]);
 
 /**
- * Draw a room of the scene.
+ * Draw a room of the scene, returns the count of texture binds issued.
  */
-void draw_room(Room* room, Scene* scene);
+int draw_room(Room* room, Scene* scene);
 
 /**
  * Draw an outline around an object's bounding.
  */
 void draw_bounding_box(PhysicsBody* pb);
 
+/**
+ * Draw an untextured box standing on the position, in place of an object still loading.
+ */
+void draw_placeholder_box(Vec3 position, float half_size);
+
 /**
  * Draw the origin of the world coordinate system.
  */
@@ -0,0 +1,19 @@
+#ifndef DXT_H
+#define DXT_H
+
+#include "texture.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Bytes of one mipmap level of an S3TC texture, the levels below 4x4 pixels still take a whole block.
+ */
+size_t get_compressed_level_size(GLenum format, int width, int height);
+
+/**
+ * Build the mipmap chain of an RGB or RGBA image and compress every level,
+ * to DXT1 when the image is opaque and to DXT5 when it has alpha.
+ */
+bool compress_texture(const TextureImage* source, TextureImage* target);
+
+#endif /* DXT_H */
@@ -25,6 +25,11 @@ typedef struct Extraction {
  */
 void init_extraction(Scene* scene);
 
+/**
+ * Center the collection zone above the platform, again once the platform is placed by its model.
+ */
+void set_extraction_zone(Extraction* extraction, const Object* platform);
+
 /**
  * Update the extraction status based on objects in the collection zone.
  */
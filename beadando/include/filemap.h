@@ -0,0 +1,25 @@
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Read-only view of a whole file, memory mapped where the platform supports it.
+ */
+typedef struct MappedFile {
+    void* data;
+    size_t size;
+} MappedFile;
+
+/**
+ * Map the file at path, returns false when it is missing or empty.
+ */
+bool map_file(MappedFile* file, const char* path);
+
+/**
+ * Release the mapping.
+ */
+void unmap_file(MappedFile* file);
+
+#endif /* FILEMAP_H */
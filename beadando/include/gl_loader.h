@@ -0,0 +1,121 @@
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdbool.h>
+
+/**
+ * Function used to resolve an OpenGL entry point by name.
+ */
+typedef void* (*GLProcLoader)(const char* name);
+
+/**
+ * OpenGL entry points above the 1.1 baseline, resolved at runtime.
+ */
+#define GL_FUNCTION_LIST(X) \
+    X(PFNGLACTIVETEXTUREPROC, glActiveTexture) \
+    X(PFNGLCOMPRESSEDTEXIMAGE2DPROC, glCompressedTexImage2D) \
+    X(PFNGLMULTIDRAWELEMENTSPROC, glMultiDrawElements) \
+    X(PFNGLGENBUFFERSPROC, glGenBuffers) \
+    X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers) \
+    X(PFNGLBINDBUFFERPROC, glBindBuffer) \
+    X(PFNGLBUFFERDATAPROC, glBufferData) \
+    X(PFNGLBUFFERSUBDATAPROC, glBufferSubData) \
+    X(PFNGLMAPBUFFERPROC, glMapBuffer) \
+    X(PFNGLUNMAPBUFFERPROC, glUnmapBuffer) \
+    X(PFNGLTEXBUFFERPROC, glTexBuffer) \
+    X(PFNGLCREATESHADERPROC, glCreateShader) \
+    X(PFNGLSHADERSOURCEPROC, glShaderSource) \
+    X(PFNGLCOMPILESHADERPROC, glCompileShader) \
+    X(PFNGLGETSHADERIVPROC, glGetShaderiv) \
+    X(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog) \
+    X(PFNGLDELETESHADERPROC, glDeleteShader) \
+    X(PFNGLCREATEPROGRAMPROC, glCreateProgram) \
+    X(PFNGLATTACHSHADERPROC, glAttachShader) \
+    X(PFNGLLINKPROGRAMPROC, glLinkProgram) \
+    X(PFNGLGETPROGRAMIVPROC, glGetProgramiv) \
+    X(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog) \
+    X(PFNGLDELETEPROGRAMPROC, glDeleteProgram) \
+    X(PFNGLUSEPROGRAMPROC, glUseProgram) \
+    X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation) \
+    X(PFNGLUNIFORM1IPROC, glUniform1i) \
+    X(PFNGLUNIFORM1FPROC, glUniform1f) \
+    X(PFNGLUNIFORM2FPROC, glUniform2f) \
+    X(PFNGLUNIFORM3IPROC, glUniform3i) \
+    X(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers) \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers) \
+    X(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer) \
+    X(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers) \
+    X(PFNGLDELETERENDERBUFFERSPROC, glDeleteRenderbuffers) \
+    X(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer) \
+    X(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage) \
+    X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer) \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus) \
+    X(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap)
+
+#define GL_DECLARE_FUNCTION(type, name) extern type pfn_##name;
+GL_FUNCTION_LIST(GL_DECLARE_FUNCTION)
+#undef GL_DECLARE_FUNCTION
+
+#define glActiveTexture pfn_glActiveTexture
+#define glCompressedTexImage2D pfn_glCompressedTexImage2D
+#define glMultiDrawElements pfn_glMultiDrawElements
+#define glGenBuffers pfn_glGenBuffers
+#define glDeleteBuffers pfn_glDeleteBuffers
+#define glBindBuffer pfn_glBindBuffer
+#define glBufferData pfn_glBufferData
+#define glBufferSubData pfn_glBufferSubData
+#define glMapBuffer pfn_glMapBuffer
+#define glUnmapBuffer pfn_glUnmapBuffer
+#define glTexBuffer pfn_glTexBuffer
+#define glCreateShader pfn_glCreateShader
+#define glShaderSource pfn_glShaderSource
+#define glCompileShader pfn_glCompileShader
+#define glGetShaderiv pfn_glGetShaderiv
+#define glGetShaderInfoLog pfn_glGetShaderInfoLog
+#define glDeleteShader pfn_glDeleteShader
+#define glCreateProgram pfn_glCreateProgram
+#define glAttachShader pfn_glAttachShader
+#define glLinkProgram pfn_glLinkProgram
+#define glGetProgramiv pfn_glGetProgramiv
+#define glGetProgramInfoLog pfn_glGetProgramInfoLog
+#define glDeleteProgram pfn_glDeleteProgram
+#define glUseProgram pfn_glUseProgram
+#define glGetUniformLocation pfn_glGetUniformLocation
+#define glUniform1i pfn_glUniform1i
+#define glUniform1f pfn_glUniform1f
+#define glUniform2f pfn_glUniform2f
+#define glUniform3i pfn_glUniform3i
+#define glGenFramebuffers pfn_glGenFramebuffers
+#define glDeleteFramebuffers pfn_glDeleteFramebuffers
+#define glBindFramebuffer pfn_glBindFramebuffer
+#define glGenRenderbuffers pfn_glGenRenderbuffers
+#define glDeleteRenderbuffers pfn_glDeleteRenderbuffers
+#define glBindRenderbuffer pfn_glBindRenderbuffer
+#define glRenderbufferStorage pfn_glRenderbufferStorage
+#define glFramebufferRenderbuffer pfn_glFramebufferRenderbuffer
+#define glCheckFramebufferStatus pfn_glCheckFramebufferStatus
+#define glGenerateMipmap pfn_glGenerateMipmap
+
+/**
+ * Groups of optional features, set by load_gl_functions.
+ */
+typedef struct GLFeatures {
+    bool buffer_objects;
+    bool shaders;
+    bool texture_buffers;
+    bool framebuffers;
+    bool pixel_buffers;
+    bool generate_mipmap;
+    bool texture_compression;
+} GLFeatures;
+
+extern GLFeatures gl_features;
+
+/**
+ * Resolve the optional OpenGL entry points with the given loader.
+ */
+void load_gl_functions(GLProcLoader loader);
+
+#endif /* GL_LOADER_H */
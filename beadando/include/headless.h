@@ -0,0 +1,30 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "gl_loader.h"
+#include <stdbool.h>
+
+/**
+ * Window-less OpenGL context rendering into an offscreen framebuffer.
+ */
+typedef struct HeadlessContext {
+    void* display;
+    void* context;
+    GLuint framebuffer;
+    GLuint color_buffer;
+    GLuint depth_buffer;
+    int width;
+    int height;
+} HeadlessContext;
+
+/**
+ * Create a surfaceless EGL context, load the GL functions and bind a width x height framebuffer.
+ */
+bool init_headless_context(HeadlessContext* headless, int width, int height);
+
+/**
+ * Release the framebuffer and the EGL context.
+ */
+void destroy_headless_context(HeadlessContext* headless);
+
+#endif /* HEADLESS_H */
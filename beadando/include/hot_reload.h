@@ -0,0 +1,46 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct Scene Scene;
+
+#define CONFIG_DIRECTORY "config"
+#define LIGHT_CONFIG_FILE "light_config.json"
+#define OBJECT_CONFIG_FILE "object_config.json"
+
+// Where inotify is missing the modification times are checked this often.
+#define CONFIG_POLL_INTERVAL_MS 500
+
+/**
+ * Watches the light and object configs and applies their changes to the running scene.
+ */
+typedef struct ConfigWatcher {
+    bool is_enabled;
+    int inotify_fd;
+    bool is_light_changed;
+    bool is_object_changed;
+    Uint32 last_poll;
+    int64_t light_mtime;
+    int64_t object_mtime;
+} ConfigWatcher;
+
+/**
+ * Start watching the config directory.
+ */
+void init_config_watcher(ConfigWatcher* watcher);
+
+/**
+ * Reparse the changed configs and apply the differences to the scene by name.
+ * Waits while the scene is loading, the loader writes the objects.
+ */
+void update_config_watcher(ConfigWatcher* watcher, Scene* scene);
+
+/**
+ * Stop watching.
+ */
+void free_config_watcher(ConfigWatcher* watcher);
+
+#endif /* HOT_RELOAD_H */
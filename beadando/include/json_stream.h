@@ -0,0 +1,75 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Bytes read from the file at once.
+#define JSON_STREAM_BUFFER_SIZE 65536
+
+// Longer strings are truncated, config fields are far shorter.
+#define JSON_STREAM_MAX_STRING 1024
+
+// Arrays and objects open at once.
+#define JSON_STREAM_MAX_DEPTH 64
+
+typedef enum JsonToken {
+    JSON_TOKEN_ERROR,
+    JSON_TOKEN_END,
+    JSON_TOKEN_OBJECT_BEGIN,
+    JSON_TOKEN_OBJECT_END,
+    JSON_TOKEN_ARRAY_BEGIN,
+    JSON_TOKEN_ARRAY_END,
+    JSON_TOKEN_KEY,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_NUMBER,
+    JSON_TOKEN_TRUE,
+    JSON_TOKEN_FALSE,
+    JSON_TOKEN_NULL
+} JsonToken;
+
+/**
+ * Pull tokenizer reading a JSON file through a fixed buffer, so the memory use does not depend on the file size.
+ * The punctuation is checked against the open containers, keys are told apart from string values.
+ */
+typedef struct JsonStream {
+    FILE* file;
+    char buffer[JSON_STREAM_BUFFER_SIZE];
+    size_t position;
+    size_t length;
+    int line;
+    char containers[JSON_STREAM_MAX_DEPTH];
+    int depth;
+    bool has_value;
+    bool is_after_comma;
+    bool is_after_key;
+    bool is_done;
+    bool is_failed;
+    char text[JSON_STREAM_MAX_STRING];
+    size_t text_length;
+    double number;
+} JsonStream;
+
+/**
+ * Open the file for streaming, returns false when it cannot be opened.
+ */
+bool open_json_stream(JsonStream* stream, const char* filename);
+
+/**
+ * Read the next token. Keys and strings are in text, numbers in number.
+ * After an error or the end of the document every further call returns the same token.
+ */
+JsonToken next_json_token(JsonStream* stream);
+
+/**
+ * Skip the rest of a value whose first token was just read, returns false on a syntax error.
+ */
+bool skip_json_value(JsonStream* stream, JsonToken token);
+
+/**
+ * Close the file.
+ */
+void close_json_stream(JsonStream* stream);
+
+#endif /* JSON_STREAM_H */
@@ -22,6 +22,7 @@ typedef struct Lighting {
     float cutoff;
     float exponent;
     float brightness;
+    float range;
     char room_name[64];
     bool is_spotlight;
 } Lighting;
@@ -32,6 +33,11 @@ typedef struct Lighting {
  */
 void add_light(Scene* scene, Lighting* config);
 
+/**
+ * Replace the parameters of a light with a new config, keeping its slot.
+ */
+void update_light(Scene* scene, Lighting* light, const Lighting* config);
+
 /**
  * Enable/disable and upload one light to GL
  */
@@ -42,6 +48,11 @@ void set_lighting(int slot, const Lighting* light);
  */
 void update_lighting(Scene* scene, float elapsed_time);
 
+/**
+ * Check whether an enabled light changes over time.
+ */
+bool has_animated_lights(const Scene* scene);
+
 /**
  * Adjust the global brightness of the app.
  */
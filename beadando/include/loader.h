@@ -0,0 +1,95 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "config.h"
+#include "texture.h"
+#include <GL/gl.h>
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+#define MAX_LOADER_THREADS 16
+#define ASSET_PATH_LENGTH 256
+
+typedef struct Object Object;
+
+typedef enum AssetJobType {
+    ASSET_TEXTURE,
+    ASSET_MODEL
+} AssetJobType;
+
+/**
+ * A texture to decode or a model to parse on a worker, with the place of the result.
+ */
+typedef struct AssetJob {
+    AssetJobType type;
+    char path[ASSET_PATH_LENGTH];
+    GLuint* texture;
+    TextureImage image;
+    Object* object;
+    const ObjectConfig* config;
+    int thread;
+    double start_ms;
+    double end_ms;
+} AssetJob;
+
+/**
+ * Worker pool decoding textures and preparing models, the finished jobs are queued for the main thread.
+ */
+typedef struct AssetLoader {
+    AssetJob* jobs;
+    int job_count;
+    int job_capacity;
+    int next_job;
+    AssetJob** finished;
+    int finished_count;
+    int consumed_count;
+    SDL_mutex* mutex;
+    SDL_sem* ready;
+    SDL_Thread* threads[MAX_LOADER_THREADS];
+    int thread_count;
+    int worker_count;
+    Uint64 start;
+    double upload_ms;
+} AssetLoader;
+
+/**
+ * Prepare an empty loader, zero threads means one per core besides the main thread.
+ */
+void init_asset_loader(AssetLoader* loader, int thread_count);
+
+/**
+ * Queue a texture, its name is written to texture after the upload.
+ */
+void queue_texture_load(AssetLoader* loader, const char* path, GLuint* texture, Object* object);
+
+/**
+ * Queue the model of an object, its level of detail chain and bounds are filled in on the worker.
+ */
+void queue_model_load(AssetLoader* loader, const ObjectConfig* config, Object* object);
+
+/**
+ * Start the workers on the queued jobs: the room textures first, then the models as they take the longest.
+ */
+void start_asset_loader(AssetLoader* loader);
+
+/**
+ * Wait for the next finished job and upload its texture, returns NULL when every job was handed out.
+ */
+AssetJob* wait_for_asset(AssetLoader* loader);
+
+/**
+ * Take the next finished job without waiting, returns NULL when none is ready yet.
+ */
+AssetJob* poll_asset(AssetLoader* loader);
+
+/**
+ * Whether some queued jobs were not consumed by the main thread yet.
+ */
+bool has_pending_assets(const AssetLoader* loader);
+
+/**
+ * Drop the jobs not started yet, join the workers, print the startup timeline and release the jobs.
+ */
+void finish_asset_loader(AssetLoader* loader);
+
+#endif /* LOADER_H */
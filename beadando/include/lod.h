@@ -0,0 +1,72 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "mesh.h"
+#include "filemap.h"
+#include "camera.h"
+#include "utils.h"
+#include <GL/gl.h>
+
+// Relative margin around the switch sizes, keeps objects near a threshold from flickering between levels.
+#define LOD_HYSTERESIS 0.15f
+
+// Meshes with fewer triangles are not simplified further.
+#define LOD_MIN_TRIANGLES 64
+
+/**
+ * Levels of detail of a model, from the full mesh (level 0) to the coarsest one.
+ */
+typedef struct LodChain {
+    Mesh levels[MAX_LOD_LEVELS];
+    GLuint display_lists[MAX_LOD_LEVELS];
+    int triangle_counts[MAX_LOD_LEVELS];
+    GLuint first_index[MAX_LOD_LEVELS];
+    int level_count;
+    float radius;
+    int current;
+    MappedFile mapping;
+    size_t display_list_bytes;
+} LodChain;
+
+/**
+ * Take the mesh as the full level and build its simplified levels.
+ */
+void build_lod_chain(LodChain* lod, Mesh* mesh);
+
+/**
+ * Simplify a mesh to about target_triangles with quadric error metric edge collapses.
+ */
+void simplify_mesh(const Mesh* source, Mesh* result, int target_triangles);
+
+/**
+ * Fraction of the screen height covered by a bounding sphere.
+ */
+float projected_screen_size(const Camera* camera, Vec3 center, float radius);
+
+/**
+ * Select the level for the given screen size, changing the current level only outside the hysteresis band.
+ */
+int select_lod_level(LodChain* lod, float screen_size);
+
+/**
+ * Release the meshes and the display lists.
+ */
+void free_lod_chain(LodChain* lod);
+
+/**
+ * Bytes of mesh data held by the levels in CPU memory and by the display lists.
+ */
+size_t get_lod_chain_memory(const LodChain* lod);
+
+/**
+ * Bytes of vertex and index data the levels hold in CPU memory, zero once trimmed.
+ */
+size_t get_lod_chain_cpu_memory(const LodChain* lod);
+
+/**
+ * Release the vertices and indices of the levels once the display lists are compiled.
+ * The triangle counts, the radius and the display lists stay, returns the bytes released.
+ */
+size_t trim_lod_chain(LodChain* lod);
+
+#endif /* LOD_H */
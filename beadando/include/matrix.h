@@ -0,0 +1,94 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "utils.h"
+#include <stdbool.h>
+
+/**
+ * Column-major 4x4 matrix in the layout of OpenGL, aligned for SSE loads.
+ */
+typedef struct Mat4 {
+    _Alignas(16) float m[16];
+} Mat4;
+
+/**
+ * Rotation quaternion with the vector part in x, y, z.
+ */
+typedef struct Quat {
+    float x;
+    float y;
+    float z;
+    float w;
+} Quat;
+
+/**
+ * Set the matrix to identity.
+ */
+void mat4_identity(Mat4* out);
+
+/**
+ * Translation matrix.
+ */
+void mat4_translation(Mat4* out, Vec3 offset);
+
+/**
+ * Rotation by the quaternion followed by the translation, as glTranslatef then glMultMatrixf would build it.
+ */
+void mat4_from_quat(Mat4* out, Quat rotation, Vec3 translation);
+
+/**
+ * Perspective projection matching gluPerspective, fov is vertical and in degrees.
+ */
+void mat4_perspective(Mat4* out, float fov, float aspect_ratio, float near_plane, float far_plane);
+
+/**
+ * View matrix matching gluLookAt.
+ */
+void mat4_look_at(Mat4* out, Vec3 eye, Vec3 target, Vec3 up);
+
+/**
+ * Matrix product a * b, the output may alias any of the inputs.
+ */
+void mat4_multiply(Mat4* out, const Mat4* a, const Mat4* b);
+
+/**
+ * Products a * b[i] of count matrices in one pass, keeping a in registers.
+ */
+void mat4_multiply_batch(Mat4* out, const Mat4* a, const Mat4* b, int count);
+
+/**
+ * Transform a homogeneous vector.
+ */
+Vec4 mat4_transform(const Mat4* m, Vec4 v);
+
+/**
+ * Transform count points (w = 1) in one pass.
+ */
+void mat4_transform_points(const Mat4* m, const Vec3* points, Vec4* out, int count);
+
+/**
+ * General inverse, returns false and leaves the output untouched for a singular matrix.
+ */
+bool mat4_inverse(Mat4* out, const Mat4* m);
+
+/**
+ * Column-major inverse transpose of the upper 3x3 part, for transforming normals.
+ */
+bool mat4_normal_matrix(float out[9], const Mat4* m);
+
+/**
+ * Rotation by angle degrees around the unit axis.
+ */
+Quat quat_from_axis_angle(Vec3 axis, float angle);
+
+/**
+ * Quaternion product, applying b first and a second.
+ */
+Quat quat_multiply(Quat a, Quat b);
+
+/**
+ * Normalize the quaternion to a pure rotation.
+ */
+Quat quat_normalize(Quat q);
+
+#endif /* MATRIX_H */
@@ -0,0 +1,41 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <obj/model.h>
+#include <GL/gl.h>
+
+/**
+ * Interleaved vertex with position, normal and texture coordinates.
+ */
+typedef struct MeshVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+} MeshVertex;
+
+/**
+ * Indexed triangle mesh.
+ */
+typedef struct Mesh {
+    MeshVertex* vertices;
+    int vertex_count;
+    GLuint* indices;
+    int index_count;
+} Mesh;
+
+/**
+ * Build an indexed mesh from the triangles of a model, sharing the vertices of identical face points.
+ */
+void mesh_from_model(Mesh* mesh, const Model* model);
+
+/**
+ * Draw the mesh with immediate mode calls, for compiling into display lists.
+ */
+void draw_mesh(const Mesh* mesh);
+
+/**
+ * Release the vertex and index arrays.
+ */
+void free_mesh(Mesh* mesh);
+
+#endif /* MESH_H */
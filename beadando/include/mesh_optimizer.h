@@ -0,0 +1,48 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "mesh.h"
+
+// Size of the LRU cache the triangle order is optimized for.
+#define VERTEX_CACHE_SIZE 32
+
+// Size of the FIFO cache the ACMR is measured with, close to the post-transform cache of older GPUs.
+#define ACMR_CACHE_SIZE 16
+
+/**
+ * Vertex counts and average cache miss ratios (transformed vertices per triangle) before and after an optimization.
+ */
+typedef struct MeshOptimizationStats {
+    int vertex_count_before;
+    int vertex_count_after;
+    float acmr_before;
+    float acmr_after;
+} MeshOptimizationStats;
+
+/**
+ * Point the indices of vertices with identical position, normal and texture coordinates to the first of them.
+ * Returns the count of vertices no longer referenced, they are dropped by optimize_vertex_fetch.
+ */
+int weld_mesh_vertices(Mesh* mesh);
+
+/**
+ * Reorder the triangles for the post-transform vertex cache with Tom Forsyth's linear-speed algorithm.
+ */
+void optimize_vertex_cache(Mesh* mesh);
+
+/**
+ * Reorder the vertices in the order of their first use and drop the unreferenced ones.
+ */
+void optimize_vertex_fetch(Mesh* mesh);
+
+/**
+ * Average cache miss ratio of the triangle order with a FIFO cache of the given size.
+ */
+float calculate_acmr(const Mesh* mesh, int cache_size);
+
+/**
+ * Weld the vertices, then reorder the triangles and the vertices. The stats may be NULL.
+ */
+void optimize_mesh(Mesh* mesh, MeshOptimizationStats* stats);
+
+#endif /* MESH_OPTIMIZER_H */
@@ -2,7 +2,7 @@
 #define MODEL_H
 
 #include "utils.h"
-#include <obj/model.h>
+#include "mesh.h"
 
 /**
  * Material with ambient, diffuse, specular color specifications and shininess.
@@ -15,24 +15,11 @@ typedef struct Material {
 } Material;
 
 /**
- * Scale the vertices of a model.
+ * Center the mesh on the origin, scale it, then rotate it around the x, then y, then z axis, in degrees.
+ * The normals are scaled inversely and renormalized. The vertices are transformed in a single pass,
+ * four at a time, and the bounding box of the result is returned.
  */
-void scale_model(Model* model, Vec3 scale);
-
-/**
- * Rotate the vertices of a model.
- */
-void rotate_model(Model* model, Vec3 rotation);
-
-/**
- * Calculate the bounding box of a model.
- */
-void calculate_mesh_aabb(const Model* model, Vec3* out_min, Vec3* out_max);
-
-/**
- * Calculate the half extents of a model's mesh.
- */
-Vec3 mesh_half_extents(const Model* model);
+void transform_mesh(Mesh* mesh, Vec3 center, Vec3 scale, Vec3 rotation, Vec3* aabb_min, Vec3* aabb_max);
 
 /**
  * Set the current material.
@@ -0,0 +1,45 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdint.h>
+
+/**
+ * Slot of the index, an empty slot has no name.
+ */
+typedef struct NameIndexSlot {
+    const char* name;
+    uint32_t hash;
+    int value;
+} NameIndexSlot;
+
+/**
+ * Open addressing hash map from names to array indices, probed linearly.
+ * The names are not copied, they have to stay in place while the index is used.
+ */
+typedef struct NameIndex {
+    NameIndexSlot* slots;
+    int capacity;
+    int count;
+} NameIndex;
+
+/**
+ * Create an empty index with room for the expected number of names.
+ */
+void init_name_index(NameIndex* index, int expected_count);
+
+/**
+ * Map the name to the value, a name added earlier keeps its first value.
+ */
+void add_name(NameIndex* index, const char* name, int value);
+
+/**
+ * Value of the name, or -1 when it is not in the index.
+ */
+int find_name(const NameIndex* index, const char* name);
+
+/**
+ * Free the slots of the index.
+ */
+void free_name_index(NameIndex* index);
+
+#endif /* NAME_INDEX_H */
@@ -0,0 +1,20 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include "mesh.h"
+#include "utils.h"
+#include <stdbool.h>
+
+// Files smaller than this per thread are not worth splitting.
+#define OBJ_MIN_CHUNK_SIZE (256 * 1024)
+#define OBJ_MAX_THREADS 16
+
+/**
+ * Load a Wavefront OBJ file into an indexed mesh and compute the bounds of its positions.
+ *
+ * The file is mapped and split into line aligned chunks, which are parsed in parallel on at most max_threads threads.
+ * Polygons are triangulated as fans, relative (negative) indices are supported.
+ */
+bool load_obj_mesh(const char* path, int max_threads, Mesh* mesh, Vec3* aabb_min, Vec3* aabb_max);
+
+#endif /* OBJ_LOADER_H */
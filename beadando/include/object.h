@@ -6,9 +6,10 @@
 #include "physics.h"
 #include "utils.h"  
 #include "camera.h" 
+#include "lod.h"
+#include "loader.h"
 #include <GL/gl.h>  
 #include <stdbool.h>
-#include <obj/load.h>
 
 typedef struct Scene Scene;
 
@@ -22,31 +23,82 @@ typedef struct Object {
     bool is_static;
     bool is_interacted;
     bool in_extraction;
+    bool is_occluded;
+    bool is_loaded;
+    bool is_evicted;
+    bool is_removed;
+    int pending_assets;
+    int room_id;
+    Quat orientation;
+    size_t memory_bytes;
     int value;
-    Model model;
+    Vec3 aabb_min;
+    Vec3 aabb_max;
     Vec3 position;
     Vec3 rotation;
     Material material;
     PhysicsBody physics_body;
     GLuint texture_id;
-    GLuint display_list;
+    LodChain lod;
+    int static_batch;
 } Object;
 
 /**
- * Add an object to the scene.
+ * Add an object to the scene at its configured place, its assets are loaded with its room.
  */
 void add_object(Scene* scene, ObjectConfig* config);
 
 /**
- * Prepare the model of an object.
+ * Queue the model and texture of the object on the loader.
  */
-void load_and_prepare_model(Object* obj, ObjectConfig* config);
+void queue_object_assets(Object* obj, const ObjectConfig* config, AssetLoader* loader);
+
+/**
+ * Keep the transform of the object and release its body, meshes and texture until it is loaded again.
+ */
+void release_object_assets(Object* obj);
+
+/**
+ * Place the object in its room once its model is prepared.
+ */
+void place_object(Scene* scene, Object* obj, const ObjectConfig* config);
+
+/**
+ * Load the OBJ model of a config entry, center, scale and rotate it, then build its levels of detail and bounds.
+ * The OBJ is parsed on at most max_threads threads.
+ */
+void prepare_object_mesh(const ObjectConfig* config, int max_threads, LodChain* lod, Vec3* aabb_min, Vec3* aabb_max);
+
+/**
+ * Prepare the model of an object, from its baked mesh when that is up to date. Called by the loader workers.
+ */
+void load_and_prepare_model(Object* obj, const ObjectConfig* config);
+
+/**
+ * Half extents of the prepared mesh of the object.
+ */
+Vec3 object_half_extents(const Object* obj);
 
 /**
  * Sync the physics transformations for rendering.
  */
 void sync_physics_transforms(Scene* scene);
 
+/**
+ * Count the active dynamic objects whose bodies are not asleep.
+ */
+int count_awake_objects(const Scene* scene);
+
+/**
+ * Select the level of detail of each object from its size on the screen.
+ */
+void update_object_lods(Scene* scene, const Camera* camera);
+
+/**
+ * Compute the model matrices of the dynamic objects and the modelview matrices of every object in one batch.
+ */
+void update_object_matrices(Scene* scene, const Camera* camera);
+
 /**
  * Check if mouse coordinates intersect with an object
  * Returns object ID or -1 if no object was hit
@@ -0,0 +1,51 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "camera.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Resolution of the software depth buffer, the width is a multiple of the SSE lane count.
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+
+typedef struct Scene Scene;
+
+/**
+ * Software occlusion culler rasterizing the room walls into a low resolution depth buffer on a worker thread.
+ */
+typedef struct OcclusionCuller {
+    bool is_ready;
+    bool enabled;
+    float* depth;
+    float* occluders;
+    int occluder_count;
+    Mat4 view_projection;
+    SDL_Thread* thread;
+    SDL_sem* start;
+    SDL_sem* done;
+    bool is_pending;
+    bool is_quitting;
+} OcclusionCuller;
+
+/**
+ * Collect the wall quads of the scene as occluders and start the worker thread.
+ */
+bool init_occlusion_culler(OcclusionCuller* culler, const Scene* scene);
+
+/**
+ * Start rasterizing the occluders from the camera, while the rest of the frame is updated.
+ */
+void begin_occlusion_frame(OcclusionCuller* culler, const Camera* camera);
+
+/**
+ * Wait for the depth buffer and mark the objects hidden behind the walls.
+ */
+void cull_occluded_objects(OcclusionCuller* culler, Scene* scene);
+
+/**
+ * Stop the worker thread and release the buffers.
+ */
+void destroy_occlusion_culler(OcclusionCuller* culler);
+
+#endif /* OCCLUSION_H */
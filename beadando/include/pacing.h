@@ -0,0 +1,73 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Longest wait for events while idle, keeps window management responsive.
+#define IDLE_WAIT_MS 250
+
+/**
+ * How the main loop waits between frames.
+ */
+typedef enum FramePacing {
+    PACING_VSYNC,
+    PACING_ADAPTIVE_VSYNC,
+    PACING_UNCAPPED,
+    PACING_LIMITED,
+    PACING_MODE_COUNT
+} FramePacing;
+
+/**
+ * Frame pacing state of the main loop.
+ */
+typedef struct FramePacer {
+    FramePacing mode;
+    int target_fps;
+    Uint64 next_frame;
+    bool idle_throttle;
+    bool had_activity;
+    int quiet_frames;
+} FramePacer;
+
+/**
+ * Set up the pacer with vsync, a 60 fps limit for the limited mode and idle throttling.
+ */
+void init_frame_pacer(FramePacer* pacer);
+
+/**
+ * Parse a pacing mode name: vsync, adaptive, uncapped or limit.
+ */
+bool parse_frame_pacing(const char* name, FramePacing* mode);
+
+/**
+ * Name of the pacing mode.
+ */
+const char* frame_pacing_name(FramePacing mode);
+
+/**
+ * Set the swap interval of the mode, falling back to vsync if adaptive vsync is not supported.
+ */
+void apply_frame_pacing(FramePacer* pacer, bool has_window);
+
+/**
+ * Switch to the next pacing mode.
+ */
+void cycle_frame_pacing(FramePacer* pacer, bool has_window);
+
+/**
+ * Sleep until the next frame is due in the limited mode.
+ */
+void wait_for_next_frame(FramePacer* pacer);
+
+/**
+ * Note whether the last frame changed anything, return true if redrawing can be skipped.
+ */
+bool update_idle_state(FramePacer* pacer, bool is_active);
+
+/**
+ * Block until an event arrives or IDLE_WAIT_MS passes.
+ */
+void wait_while_idle(FramePacer* pacer);
+
+#endif /* PACING_H */
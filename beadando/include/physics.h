@@ -20,6 +20,7 @@ typedef struct PhysicsWorld {
     dReal surface_friction;
     dReal bounce;
     int quick_step_iterations;
+    int contact_count;
 } PhysicsWorld;
 
 /**
@@ -77,6 +78,11 @@ void physics_apply_config(PhysicsWorld* pw, PhysicsConfig* cfg);
  */
 void physics_create_box(PhysicsWorld* pw, PhysicsBody* pb, double mass, Vec3 pos, Vec3 half_extents);
 
+/**
+ * Remove the body and the geometry of a box from the world.
+ */
+void physics_destroy_body(PhysicsBody* pb);
+
 /**
  * Create a flat bounding wall.
  */
@@ -0,0 +1,103 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "trace.h"
+#include "utils.h"
+#include <SDL2/SDL.h>
+#include <GL/gl.h>
+#include <stdbool.h>
+
+// Number of frames in the rolling average / max window.
+#define PROFILER_HISTORY 120
+
+/**
+ * Timed subsystems of a frame.
+ */
+typedef enum ProfileSection {
+    PROFILE_EVENTS,
+    PROFILE_CAMERA,
+    PROFILE_PHYSICS,
+    PROFILE_SYNC,
+    PROFILE_EXTRACTION,
+    PROFILE_OCCLUSION,
+    PROFILE_RENDER,
+    PROFILE_SWAP,
+    PROFILE_SECTION_COUNT
+} ProfileSection;
+
+/**
+ * Counters collected while building a frame. Draw calls count the glCallList, glBegin and glDraw* calls issued,
+ * texture binds every glBindTexture, including the ones recorded in the display lists that were called.
+ */
+typedef struct FrameStats {
+    int draw_calls;
+    int texture_binds;
+    int awake_bodies;
+    int contacts;
+    int triangles;
+    int occlusion_tested;
+    int occlusion_culled;
+    int lod_objects[MAX_LOD_LEVELS];
+    long heap_allocations;
+} FrameStats;
+
+/**
+ * Rolling CPU timings of the frame and its sections, plus the frame counters.
+ */
+typedef struct Profiler {
+    bool hud_enabled;
+    double ticks_to_ms;
+    Uint64 frame_start;
+    Uint64 section_start[PROFILE_SECTION_COUNT];
+    double section_ms[PROFILE_SECTION_COUNT];
+    double frame_history[PROFILER_HISTORY];
+    double section_history[PROFILE_SECTION_COUNT][PROFILER_HISTORY];
+    int history_index;
+    int history_count;
+    double frame_average;
+    double frame_max;
+    double section_average[PROFILE_SECTION_COUNT];
+    double section_max[PROFILE_SECTION_COUNT];
+    FrameStats stats;
+    FrameStats last_stats;
+    long frame_allocations_start;
+} Profiler;
+
+extern Profiler profiler;
+
+/**
+ * Time a single statement as the given section.
+ */
+#define PROFILE(section, statement) \
+    do { \
+        profiler_begin(section); \
+        statement; \
+        profiler_end(section); \
+    } while (0)
+
+/**
+ * Reset the profiler and start the first frame.
+ */
+void init_profiler();
+
+/**
+ * Start timing a section.
+ */
+void profiler_begin(ProfileSection section);
+
+/**
+ * Stop timing a section, adding the time to the current frame.
+ */
+void profiler_end(ProfileSection section);
+
+/**
+ * Fold the finished frame into the rolling averages and start a new one.
+ */
+void profiler_end_frame();
+
+/**
+ * Draw the profiler HUD in the top left corner with the given charmap.
+ */
+void draw_profiler_hud(GLuint charmap, int width, int height);
+
+#endif /* PROFILER_H */
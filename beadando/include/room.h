@@ -2,13 +2,27 @@
 #define ROOM_H
 
 #include "config.h"
+#include "loader.h"
 #include "physics.h"
 #include "utils.h"
 #include <GL/gl.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct Scene Scene;
 
+// Floor, ceiling and at most three pieces of a connector wall per direction.
+#define MAX_ROOM_QUADS (2 + DIR_COUNT * 3)
+
+/**
+ * Whether the textures and props of a room are in memory.
+ */
+typedef enum RoomResidency {
+    ROOM_UNLOADED,
+    ROOM_LOADING,
+    ROOM_RESIDENT
+} RoomResidency;
+
 /**
  * Place the rooms in world-space.
  */
@@ -35,17 +49,47 @@ typedef struct Room {
     float door_width;
     float door_height;
     GLuint display_list;
+    int display_list_binds;
+    bool is_batched;
+    RoomResidency residency;
+    size_t memory_bytes;
 } Room;
 
 /**
- *  Add a room to the scene.
+ * Textured quad of the room geometry.
+ */
+typedef struct RoomQuad {
+    GLuint texture;
+    bool is_wall;
+    float normal[3];
+    float uv[4][2];
+    float vertices[4][3];
+} RoomQuad;
+
+/**
+ *  Add a room to the scene, its textures are loaded by the room streaming.
  */
 void add_room(Scene* scene, RoomConfig* config);
 
+/**
+ * Queue the floor, ceiling and wall textures of the room.
+ */
+void queue_room_textures(Room* room, const RoomConfig* config, AssetLoader* loader);
+
+/**
+ * Delete the textures and the display list of the room, its geometry and walls stay.
+ */
+void release_room_assets(Room* room);
+
+/**
+ * Index of the room containing the position on the floor plan, -1 between rooms.
+ */
+int find_room_at(const Scene* scene, Vec3 position);
+
 /**
  * Calculate the world position of an object within a room.
  */
-Vec3 calculate_world_position(Room* room, ObjectConfig* config);
+Vec3 calculate_world_position(Room* room, const ObjectConfig* config);
 
 /**
  * Calculate the position within a room.
@@ -53,13 +97,23 @@ Vec3 calculate_world_position(Room* room, ObjectConfig* config);
 Vec3 constrain_to_room(Vec3 position, Room* room, Vec3 mesh_half_ext);
 
 /**
- * Use BFS to place the rooms in world-space by connection.
+ * Use BFS to place the rooms in world-space by connection, and create their wall colliders.
  */
 void place_rooms_by_connections(Scene* scene);
 
+/**
+ * Compile the display list of each loaded room that has none yet, once its textures are uploaded.
+ */
+void compile_room_display_lists(Scene* scene);
+
 /**
  * Determine if two rooms need a connector wall.
  */
-bool needs_connector(Room* room, Room* neighbor, Direction dir);
+bool needs_connector(const Room* room, const Room* neighbor, Direction dir);
+
+/**
+ * Collect the floor, ceiling and wall quads of a room, grouped by texture.
+ */
+int build_room_quads(const Room* room, const Scene* scene, RoomQuad quads[MAX_ROOM_QUADS]);
 
 #endif /* ROOM_H */
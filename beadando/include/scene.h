@@ -1,19 +1,31 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include "arena.h"
 #include "config.h"
 #include "camera.h"
 #include "texture.h"
 #include "utils.h"
 #include "physics.h"
 #include "model.h"
-#include <obj/model.h>
 #include "room.h"
 #include "lighting.h"
 #include "object.h"
 #include "extraction.h"
+#include "batch.h"
+#include "streaming.h"
+#include "name_index.h"
 #include <limits.h>
 
+// Time spent on the GL uploads of the loaded assets in one frame.
+#define SCENE_LOADING_BUDGET_MS 4
+
+// Objects a reloaded config can add on top of the ones the scene started with.
+#define OBJECT_RELOAD_HEADROOM 64
+
+// Size of the box drawn in place of an object still loading.
+#define PLACEHOLDER_HALF_SIZE 0.25f
+
 /**
  * Scene containing light sources, rooms and objects.
  */
@@ -25,15 +37,45 @@ typedef struct Scene {
     int room_count;
     Object* objects;
     int object_count;
+    int object_capacity;
     int selected_object_id;
     PhysicsWorld physics_world;
     Extraction extraction;
+    StaticWorld static_world;
+    Mat4 view_matrix;
+    Mat4* model_matrices;
+    Mat4* modelview_matrices;
+    AssetLoader loader;
+    bool is_loading;
+    int load_threads;
+    bool use_packed_vertices;
+    RoomConfig* room_configs;
+    ObjectConfig* object_configs;
+    int object_config_count;
+    RoomStreamer streamer;
+    NameIndex room_index;
+    NameIndex light_index;
+    NameIndex object_index;
+    Arena arena;
 } Scene;
 
 /**
- * Initialize the scene by setting material, lights, rooms and objects.
+ * Initialize the scene by setting material, lights, rooms and objects, loading the assets on load_threads workers.
+ * Returns once the rooms around the start can be drawn, the objects keep loading in the background
+ * and the farther rooms are streamed within the budget of stream_budget_mb.
+ */
+void init_scene(Scene* scene, int load_threads, int stream_budget_mb);
+
+/**
+ * Upload the assets finished since the last frame and the changed static batches within the frame budget,
+ * then enable the completed objects.
+ */
+void update_scene_loading(Scene* scene);
+
+/**
+ * Block until every asset of the scene is loaded.
  */
-void init_scene(Scene* scene);
+void wait_for_scene_loading(Scene* scene);
 
 /**
  * Find a room by name.
@@ -56,12 +98,12 @@ Object* find_object_by_name(Scene* scene, const char* name);
 Object* find_object_by_id(Scene* scene, int id);
 
 /**
- * 
+ * Create the collision box and the display lists of a static object. Its mesh is kept for the static world.
  */
 void create_static_physics_and_display(Object* obj, Scene* scene);
 
 /**
- * 
+ * Create the body and the display lists of a dynamic object, then release its mesh.
  */
 void create_dynamic_physics_and_display(Object* obj, Scene* scene, float mass);
 
@@ -70,6 +112,21 @@ void create_dynamic_physics_and_display(Object* obj, Scene* scene, float mass);
  */
 void update_scene(Scene* scene, double elapsed_time);
 
+/**
+ * Enable and upload the MAX_LIGHTS scene lights starting at index first, disable the unused slots.
+ */
+void apply_scene_lights(const Scene* scene, int first);
+
+/**
+ * Draw the rooms and the active objects with the current lighting state.
+ */
+void draw_scene_geometry(const Scene* scene);
+
+/**
+ * Draw the extraction status and the bounding box of the selected object.
+ */
+void draw_scene_overlays(const Scene* scene);
+
 /**
  * Render the scene objects.
  */
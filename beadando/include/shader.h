@@ -0,0 +1,17 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include "gl_loader.h"
+
+/**
+ * Compile and link a GLSL program from a vertex and a fragment shader file.
+ * Returns 0 on failure.
+ */
+GLuint load_shader_program(const char* vertex_path, const char* fragment_path);
+
+/**
+ * Read a whole text file into a newly allocated string.
+ */
+char* read_text_file(const char* filename);
+
+#endif /* SHADER_H */
@@ -0,0 +1,60 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Scene Scene;
+
+// Rooms at most this many doors away from the player are kept loaded.
+#define STREAMING_RESIDENT_DISTANCE 1
+
+// Rooms at most this many doors away are loaded ahead while the budget allows.
+#define STREAMING_PREFETCH_DISTANCE 2
+
+#define DEFAULT_STREAMING_BUDGET_MB 256
+
+/**
+ * Loads the rooms around the player by their distance in the connection graph and evicts the far ones.
+ */
+typedef struct RoomStreamer {
+    int current_room;
+    int* distances;
+    int* queue;
+    size_t budget_bytes;
+    bool is_budget_exceeded;
+} RoomStreamer;
+
+/**
+ * Start from the given room, a budget of 0 means the default one. The distance table and the search queue are kept in the scene arena.
+ */
+void init_room_streamer(RoomStreamer* streamer, Scene* scene, int start_room, int budget_mb);
+
+/**
+ * Queue the unloaded rooms at most max_distance doors away with their props and start the loader.
+ * Returns false when there was nothing to load.
+ */
+bool start_room_streaming(Scene* scene, int max_distance);
+
+/**
+ * Mark the loaded rooms resident and compile their display lists, called when the loader finished.
+ */
+void finish_room_streaming(Scene* scene);
+
+/**
+ * Follow the player between the rooms, evict over the budget and start loading the rooms coming in range.
+ */
+void update_room_streaming(Scene* scene, Vec3 player_position);
+
+/**
+ * Load every room of the scene and wait for them.
+ */
+void load_all_rooms(Scene* scene);
+
+/**
+ * Estimated memory of the loaded rooms and objects.
+ */
+size_t get_resident_memory(const Scene* scene);
+
+#endif /* STREAMING_H */
@@ -2,12 +2,69 @@
 #define TEXTURE_H
 
 #include <GL/gl.h>
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
 
-typedef GLubyte Pixel[3];
+// Pixel buffers used in turn for the uploads, so a new upload does not wait for the previous transfer.
+#define TEXTURE_UPLOAD_BUFFERS 4
+
+// Enough mipmap levels for a 32768 pixel wide texture.
+#define MAX_TEXTURE_LEVELS 16
+
+/**
+ * Tightly packed 8 bit RGB or RGBA pixels, the rows from top to bottom.
+ * A compressed image holds the S3TC blocks of its whole mipmap chain, the largest level first.
+ */
+typedef struct TextureImage {
+    int width;
+    int height;
+    GLenum format;
+    bool is_compressed;
+    int level_count;
+    size_t level_sizes[MAX_TEXTURE_LEVELS];
+    unsigned char* pixels;
+} TextureImage;
 
 /**
  * Load texture from file and returns with the texture name.
  */
 GLuint load_texture(char* filename);
 
+/**
+ * Load the baked compressed texture of the image file when there is an up to date one and the GPU can sample it,
+ * otherwise decode the image file. Does not touch OpenGL, so it can run on a worker thread.
+ */
+bool decode_texture(const char* filename, TextureImage* image);
+
+/**
+ * Decode the image file itself and convert it to RGB or RGBA.
+ */
+bool decode_image(const char* filename, TextureImage* image);
+
+/**
+ * Upload the image as a new mipmapped texture and free its pixels, returns 0 for an image without pixels.
+ */
+GLuint upload_texture(TextureImage* image);
+
+/**
+ * Redefine an existing texture from the image and free its pixels, the display lists binding it stay valid.
+ */
+void replace_texture(GLuint texture, TextureImage* image);
+
+/**
+ * Free the pixels of an image that is not uploaded.
+ */
+void free_texture_image(TextureImage* image);
+
+/**
+ * Estimated video memory of the texture, 0 for no texture.
+ */
+size_t get_texture_memory(GLuint texture);
+
+/**
+ * Delete the pixel buffers of the uploads.
+ */
+void destroy_texture_uploads(void);
+
 #endif /* TEXTURE_H */
@@ -0,0 +1,93 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Threads that can record zones at once, further threads are not traced.
+#define TRACE_MAX_THREADS 16
+
+// Finished zones kept per thread, the later ones are dropped.
+#define TRACE_BUFFER_EVENTS 65536
+
+// Zones open at once on a thread.
+#define TRACE_MAX_DEPTH 32
+
+// Runtime frames recorded after the startup when --trace-frames is not given.
+#define DEFAULT_TRACE_FRAMES 300
+
+/**
+ * A finished zone, the times are performance counter ticks.
+ */
+typedef struct TraceEvent {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+} TraceEvent;
+
+/**
+ * Zones of one thread. Only the owning thread writes it, the count is published after each event.
+ * A buffer released by a finished thread is continued by the next thread that claims it.
+ */
+typedef struct TraceBuffer {
+    SDL_atomic_t is_claimed;
+    char thread_name[32];
+    TraceEvent* events;
+    SDL_atomic_t count;
+    int dropped;
+    int depth;
+    const char* open_names[TRACE_MAX_DEPTH];
+    Uint64 open_starts[TRACE_MAX_DEPTH];
+} TraceBuffer;
+
+/**
+ * Record a single statement as a zone. The name has to outlive the trace, use string literals.
+ */
+#define TRACE_ZONE(name, statement) \
+    do { \
+        trace_begin(name); \
+        statement; \
+        trace_end(); \
+    } while (0)
+
+/**
+ * Start recording zones, the trace is written to the path after the given number of frames.
+ */
+void start_trace(const char* path, int frame_count);
+
+/**
+ * Name the calling thread in the trace.
+ */
+void trace_thread_name(const char* name);
+
+/**
+ * Release the buffer of the calling thread before it exits.
+ */
+void trace_thread_exit(void);
+
+/**
+ * Open a zone on the calling thread.
+ */
+void trace_begin(const char* name);
+
+/**
+ * Close the last opened zone of the calling thread.
+ */
+void trace_end(void);
+
+/**
+ * Record a zone measured by the caller.
+ */
+void trace_record(const char* name, Uint64 start, Uint64 end);
+
+/**
+ * Count a finished frame, the trace is written when the last recorded frame ends.
+ */
+void trace_end_frame(void);
+
+/**
+ * Write the trace if it is still recording and free the buffers, every traced thread has to be finished.
+ */
+void finish_trace(void);
+
+#endif /* TRACE_H */
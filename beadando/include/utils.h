@@ -5,8 +5,7 @@
 
 #define EPSILON 1e-6f
 #define MAX_LIGHTS 8
-#define MAX_OBJECTS 64
-#define MAX_ROOMS 32
+#define MAX_LOD_LEVELS 4
 
 /**
  * GLSL-like three dimensional vector.
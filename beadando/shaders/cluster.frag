@@ -0,0 +1,100 @@
+#version 150 compatibility
+
+// Light layout, 5 RGBA32F texels per light (see write_light_texels in cluster.c):
+// 0: view position, range (0 = unbounded)
+// 1: diffuse * brightness, spotlight flag
+// 2: view direction, cosine of the cutoff angle
+// 3: ambient, spot exponent
+// 4: specular, position w (0 = directional)
+#define LIGHT_TEXELS 5
+
+in vec3 view_position;
+in vec3 view_normal;
+in vec2 tex_coord;
+
+uniform sampler2D material_texture;
+uniform samplerBuffer light_data;
+uniform usamplerBuffer cluster_grid;
+uniform usamplerBuffer light_indices;
+
+uniform ivec3 grid_size;
+uniform vec2 viewport_size;
+uniform float near_plane;
+uniform float far_plane;
+uniform int global_light_count;
+
+out vec4 frag_color;
+
+vec3 shade_light(int index, vec3 normal)
+{
+    int base = index * LIGHT_TEXELS;
+    vec4 position_range = texelFetch(light_data, base);
+    vec4 diffuse_spot = texelFetch(light_data, base + 1);
+    vec4 direction_cutoff = texelFetch(light_data, base + 2);
+    vec4 ambient_exponent = texelFetch(light_data, base + 3);
+    vec4 specular_w = texelFetch(light_data, base + 4);
+
+    vec3 to_light;
+    float attenuation = 1.0;
+    if (specular_w.w == 0.0) {
+        to_light = normalize(position_range.xyz);
+    }
+    else {
+        to_light = position_range.xyz - view_position;
+        float distance = length(to_light);
+        to_light /= max(distance, 1e-5);
+
+        if (position_range.w > 0.0) {
+            float ratio = distance / position_range.w;
+            float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+            attenuation = window * window;
+        }
+    }
+
+    if (diffuse_spot.w > 0.0) {
+        float spot = dot(-to_light, direction_cutoff.xyz);
+        attenuation *= (spot >= direction_cutoff.w) ? pow(max(spot, 0.0), ambient_exponent.w) : 0.0;
+    }
+
+    if (attenuation <= 0.0) {
+        return vec3(0.0);
+    }
+
+    float n_dot_l = dot(normal, to_light);
+    vec3 color = ambient_exponent.rgb * gl_FrontMaterial.ambient.rgb;
+
+    if (n_dot_l > 0.0) {
+        vec3 half_vector = normalize(to_light + vec3(0.0, 0.0, 1.0));
+        float n_dot_h = max(dot(normal, half_vector), 0.0);
+
+        color += n_dot_l * diffuse_spot.rgb * gl_FrontMaterial.diffuse.rgb;
+        color += pow(n_dot_h, gl_FrontMaterial.shininess) * specular_w.rgb * gl_FrontMaterial.specular.rgb;
+    }
+
+    return color * attenuation;
+}
+
+void main()
+{
+    vec3 normal = normalize(view_normal);
+    vec3 color = gl_FrontMaterial.emission.rgb + gl_LightModel.ambient.rgb * gl_FrontMaterial.ambient.rgb;
+
+    for (int i = 0; i < global_light_count; i++) {
+        color += shade_light(i, normal);
+    }
+
+    float depth = -view_position.z;
+    int slice = int(log(depth / near_plane) / log(far_plane / near_plane) * float(grid_size.z));
+    ivec2 tile = ivec2(gl_FragCoord.xy / viewport_size * vec2(grid_size.xy));
+    ivec3 cell = clamp(ivec3(tile, slice), ivec3(0), grid_size - 1);
+    int cluster = (cell.z * grid_size.y + cell.y) * grid_size.x + cell.x;
+
+    uvec2 offset_count = texelFetch(cluster_grid, cluster).xy;
+    for (uint i = 0u; i < offset_count.y; i++) {
+        int index = int(texelFetch(light_indices, int(offset_count.x + i)).r);
+        color += shade_light(index, normal);
+    }
+
+    vec4 texel = texture(material_texture, tex_coord);
+    frag_color = vec4(clamp(color, 0.0, 1.0), gl_FrontMaterial.diffuse.a) * texel;
+}
@@ -0,0 +1,17 @@
+#version 150 compatibility
+
+out vec3 view_position;
+out vec3 view_normal;
+out vec2 tex_coord;
+
+void main()
+{
+    vec4 position = gl_ModelViewMatrix * gl_Vertex;
+
+    view_position = position.xyz;
+    view_normal = gl_NormalMatrix * gl_Normal;
+    // Packed static vertices are dequantized by the texture matrix.
+    tex_coord = (gl_TextureMatrix[0] * gl_MultiTexCoord0).xy;
+
+    gl_Position = gl_ProjectionMatrix * position;
+}
@@ -1,20 +1,100 @@
 #include "app.h"
 #include "draw.h"
+#include "profiler.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include <SDL2/SDL_image.h>
 
-void init_app(App* app, int width, int height) {
-    int error_code;
-    int inited_loaders;
+void parse_app_options(AppOptions* options, int argc, char* argv[]) {
+    memset(options, 0, sizeof(AppOptions));
 
-    app->is_running = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--clustered") == 0) {
+            options->use_clustered = true;
+        }
+        else if (strcmp(argv[i], "--light-bench") == 0 && i + 1 < argc) {
+            options->light_bench_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--headless") == 0) {
+            options->is_headless = true;
+        }
+        else if (strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &options->width, &options->height) != 2) {
+                printf("[WARNING] Invalid resolution: %s\n", argv[i]);
+                options->width = options->height = 0;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-frames") == 0 && i + 1 < argc) {
+            options->bench_frames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench-report") == 0 && i + 1 < argc) {
+            options->bench_report_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) {
+            options->screenshot_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            if (!parse_frame_pacing(argv[++i], &options->pacing)) {
+                printf("[WARNING] Unknown pacing mode: %s\n", argv[i]);
+            }
+        }
+        else if (strcmp(argv[i], "--fps-limit") == 0 && i + 1 < argc) {
+            options->fps_limit = atoi(argv[++i]);
+            options->pacing = PACING_LIMITED;
+        }
+        else if (strcmp(argv[i], "--no-idle") == 0) {
+            options->no_idle_throttle = true;
+        }
+        else if (strcmp(argv[i], "--no-occlusion") == 0) {
+            options->no_occlusion = true;
+        }
+        else if (strcmp(argv[i], "--bake") == 0) {
+            options->bake = true;
+        }
+        else if (strcmp(argv[i], "--obj-bench") == 0 && i + 1 < argc) {
+            options->obj_bench_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--config-bench") == 0 && i + 1 < argc) {
+            options->config_bench_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--load-threads") == 0 && i + 1 < argc) {
+            options->load_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stream-budget") == 0 && i + 1 < argc) {
+            options->stream_budget_mb = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options->trace_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace-frames") == 0 && i + 1 < argc) {
+            options->trace_frames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-hot-reload") == 0) {
+            options->no_hot_reload = true;
+        }
+        else if (strcmp(argv[i], "--packed-vertices") == 0) {
+            options->packed_vertices = true;
+        }
+        else {
+            printf("[WARNING] Unknown option: %s\n", argv[i]);
+        }
+    }
+
+    if (options->is_headless && options->bench_frames <= 0) {
+        options->bench_frames = 600;
+    }
+}
+
+static bool init_window(App* app, int width, int height) {
+    int error_code;
 
     error_code = SDL_Init(SDL_INIT_EVERYTHING);
     if (error_code != 0) {
         printf("[ERROR] SDL initialization error: %s\n", SDL_GetError());
-        return;
+        return false;
     }
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 1);
@@ -32,46 +112,132 @@ void init_app(App* app, int width, int height) {
 
     if (app->window == NULL) {
         printf("[ERROR] Unable to create the application window!\n");
-        return;
+        return false;
     }
 
     SDL_SetRelativeMouseMode(SDL_TRUE);
 
-    inited_loaders = IMG_Init(IMG_INIT_PNG);
-    if (inited_loaders == 0) {
-        printf("[ERROR] IMG initialization error: %s\n", IMG_GetError());
-        return;
-    }
-
     app->gl_context = SDL_GL_CreateContext(app->window);
     if (app->gl_context == NULL) {
         printf("[ERROR] Unable to create the OpenGL context!\n");
+        return false;
+    }
+
+    load_gl_functions(SDL_GL_GetProcAddress);
+    return true;
+}
+
+static bool init_headless(App* app, int width, int height) {
+    int error_code;
+
+    app->window = NULL;
+    app->gl_context = NULL;
+
+    error_code = SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS);
+    if (error_code != 0) {
+        printf("[ERROR] SDL initialization error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    return init_headless_context(&app->headless, width, height);
+}
+
+void init_app(App* app, int width, int height, const AppOptions* options) {
+    int inited_loaders;
+    bool has_context;
+
+    app->is_running = false;
+    app->is_headless = options->is_headless;
+    memset(&app->frame_benchmark, 0, sizeof(FrameBenchmark));
+    memset(&app->headless, 0, sizeof(HeadlessContext));
+    memset(&app->occlusion, 0, sizeof(OcclusionCuller));
+    memset(&app->config_watcher, 0, sizeof(ConfigWatcher));
+    memset(&app->scene, 0, sizeof(Scene));
+    app->scene.use_packed_vertices = options->packed_vertices;
+    app->manual.text = NULL;
+    init_arena(&frame_arena, FRAME_ARENA_SIZE);
+    app->config_watcher.inotify_fd = -1;
+
+    if (options->width > 0 && options->height > 0) {
+        width = options->width;
+        height = options->height;
+    }
+
+    trace_begin("Create context");
+    if (app->is_headless) {
+        has_context = init_headless(app, width, height);
+    }
+    else {
+        has_context = init_window(app, width, height);
+    }
+    trace_end();
+    if (!has_context) return;
+
+    // Every format is initialized up front, the asset loader decodes on several threads at once.
+    TRACE_ZONE("IMG_Init", inited_loaders = IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG));
+    if (inited_loaders == 0) {
+        printf("[ERROR] IMG initialization error: %s\n", IMG_GetError());
         return;
     }
 
     init_opengl();
     printf("[INFO] OpenGL version: %s\n", glGetString(GL_VERSION));
 
-    if (SDL_GL_SetSwapInterval(1) != 0) {
-        printf("[WARNING] Could not enable VSync: %s\n", SDL_GetError());
+    init_frame_pacer(&app->pacer);
+    app->pacer.mode = options->pacing;
+    app->pacer.idle_throttle = !options->no_idle_throttle;
+    if (options->fps_limit > 0) {
+        app->pacer.target_fps = options->fps_limit;
     }
+    apply_frame_pacing(&app->pacer, app->window != NULL);
 
     app->manual.enabled = false;
-    app->manual.charmap_id = load_texture("assets/textures/charmap.png");
+    TRACE_ZONE("Load manual", app->manual.charmap_id = load_texture("assets/textures/charmap.png"));
     app->manual.text = read_manual("assets/manual.txt");
     app->manual.scroll = 0.0f;
     app->manual.line_height = 1.0f;
     update_manual_display_params(app);
 
-    SDL_SetWindowFullscreen(app->window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+    // A fixed resolution is kept for reproducible benchmarks.
+    app->is_fullscreen = !app->is_headless && options->width <= 0;
+    if (app->is_fullscreen) {
+        SDL_SetWindowFullscreen(app->window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+    }
 
     init_camera(&(app->camera));
     reshape(app, width, height);
-    init_scene(&(app->scene));
+    TRACE_ZONE("Init scene", init_scene(&(app->scene), options->load_threads, options->stream_budget_mb));
     init_camera_physics(&app->scene.physics_world, &app->camera);
 
+    if (!options->no_occlusion) {
+        TRACE_ZONE("Init occlusion culler", init_occlusion_culler(&app->occlusion, &app->scene));
+    }
+
+    TRACE_ZONE("Init clustered renderer", init_clustered_renderer(&app->clustered));
+    app->use_clustered = options->use_clustered && app->clustered.is_ready;
+
+    // Benchmarks measure the complete scene.
+    if (options->bench_frames > 0 || options->light_bench_count > 0) {
+        TRACE_ZONE("Load all rooms", load_all_rooms(&app->scene));
+    }
+
+    // Benchmarks run on the configs they started with.
+    if (!options->no_hot_reload && options->bench_frames <= 0 && options->light_bench_count <= 0) {
+        init_config_watcher(&app->config_watcher);
+    }
+
+    app->light_benchmark.enabled = false;
+    if (options->light_bench_count > 0) {
+        start_light_benchmark(app, options->light_bench_count);
+    }
+
+    if (options->bench_frames > 0) {
+        start_frame_benchmark(app, options->bench_frames, options->screenshot_path, options->bench_report_path);
+    }
+
+    init_profiler();
+
     app->is_dragging = false;
-    app->is_fullscreen = true;
     app->is_running = true;
 }
 
@@ -106,16 +272,15 @@ void reshape(App* app, GLsizei width, GLsizei height) {
     update_manual_display_params(app);
 
     glViewport(0, 0, width, height);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(app->camera.fov, app->camera.aspect_ratio, 0.1, 100.0);
-    glMatrixMode(GL_MODELVIEW);
+    set_projection(&app->camera);
 }
 
 void handle_app_events(App* app) {
     SDL_Event event;
 
     while (SDL_PollEvent(&event)) {
+        app->pacer.had_activity = true;
+
         switch (event.type) {
         case SDL_WINDOWEVENT:
             switch (event.window.event) {
@@ -163,7 +328,24 @@ void handle_app_events(App* app) {
             case SDL_SCANCODE_F6:
                 adjust_brightness(&app->scene, -0.1f);
                 break;
+            case SDL_SCANCODE_F8:
+                profiler.hud_enabled = !profiler.hud_enabled;
+                break;
+            case SDL_SCANCODE_F7:
+                if (app->clustered.is_ready) {
+                    app->use_clustered = !app->use_clustered;
+                    printf("[INFO] Lighting: %s\n", app->use_clustered ? "clustered" : "fixed-function");
+                }
+                break;
+            case SDL_SCANCODE_F9:
+                cycle_frame_pacing(&app->pacer, app->window != NULL);
+                break;
+            case SDL_SCANCODE_F10:
+                app->pacer.idle_throttle = !app->pacer.idle_throttle;
+                printf("[INFO] Idle throttling: %s\n", app->pacer.idle_throttle ? "on" : "off");
+                break;
             case SDL_SCANCODE_F11:
+                if (!app->window) break;
                 app->is_fullscreen = !app->is_fullscreen;
                 SDL_SetWindowFullscreen(
                     app->window,
@@ -265,6 +447,32 @@ void handle_app_events(App* app) {
     }
 }
 
+static bool is_app_active(const App* app) {
+    const Camera* camera = &app->camera;
+
+    if (app->is_dragging) return true;
+    if (app->light_benchmark.enabled || app->frame_benchmark.enabled) return true;
+    if (vec3_length(camera->speed) > 0.0f || vec3_length(camera->rotation_speed) > 0.0f) return true;
+    if (count_awake_objects(&app->scene) > 0) return true;
+    if (app->scene.is_loading) return true;
+    if (has_animated_lights(&app->scene)) return true;
+
+    return false;
+}
+
+bool is_app_idle(App* app) {
+    return update_idle_state(&app->pacer, is_app_active(app));
+}
+
+void idle_app(App* app) {
+    wait_while_idle(&app->pacer);
+
+    // The time spent waiting must not be simulated on wake up.
+    app->uptime = (double)SDL_GetTicks() / 1000;
+    profiler.frame_start = SDL_GetPerformanceCounter();
+    profiler.frame_allocations_start = get_thread_heap_allocations();
+}
+
 void update_app(App* app) {
     double current_time;
     double elapsed_time;
@@ -273,15 +481,31 @@ void update_app(App* app) {
     elapsed_time = current_time - app->uptime;
     app->uptime = current_time;
 
-    update_camera(&(app->camera), elapsed_time);
+    if (app->frame_benchmark.enabled) {
+        // Fixed steps keep the physics, and so the final frame, reproducible.
+        elapsed_time = BENCHMARK_TIME_STEP;
+        PROFILE(PROFILE_CAMERA, update_benchmark_camera(app));
+    }
+    else {
+        PROFILE(PROFILE_CAMERA, update_camera(&(app->camera), elapsed_time));
+    }
+    update_config_watcher(&app->config_watcher, &app->scene);
+    TRACE_ZONE("Room streaming", update_room_streaming(&app->scene, app->camera.position));
+    TRACE_ZONE("LOD selection", update_object_lods(&app->scene, &app->camera));
+
+    // Rasterized by the worker while the physics runs.
+    begin_occlusion_frame(&app->occlusion, &app->camera);
     update_scene(&(app->scene), elapsed_time);
 
     if (app->is_dragging) {
         handle_move_selected_object(app, 0, 0);
     }
+    update_object_matrices(&app->scene, &app->camera);
 }
 
 void render_app(App* app) {
+    PROFILE(PROFILE_OCCLUSION, cull_occluded_objects(&app->occlusion, &app->scene));
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
 
@@ -289,19 +513,61 @@ void render_app(App* app) {
 
     set_view(&(app->camera));
     if (!app->manual.enabled) {
-        render_scene(&(app->scene));
+        profiler_begin(PROFILE_RENDER);
+        if (app->use_clustered) {
+            render_scene_clustered(&app->scene, &app->clustered, &app->camera);
+        }
+        else {
+            render_scene(&(app->scene));
+        }
+        profiler_end(PROFILE_RENDER);
+
         draw_crosshair(app);
+        if (profiler.hud_enabled) {
+            draw_profiler_hud(app->manual.charmap_id, app->window_width, app->window_height);
+        }
     }
     else {
        draw_manual(app);
     }
 
     glPopMatrix();
-    
-    SDL_GL_SwapWindow(app->window);
+
+    if (app->frame_benchmark.enabled) {
+        capture_benchmark_frame(app);
+    }
+
+    if (app->is_headless) {
+        PROFILE(PROFILE_SWAP, glFinish());
+    }
+    else {
+        PROFILE(PROFILE_SWAP, SDL_GL_SwapWindow(app->window));
+    }
+    reset_arena(&frame_arena);
+    profiler_end_frame();
+
+    if (app->light_benchmark.enabled) {
+        step_light_benchmark(app);
+    }
+    if (app->frame_benchmark.enabled) {
+        step_frame_benchmark(app);
+    }
 }
 
 void destroy_app(App* app) {
+    free_config_watcher(&app->config_watcher);
+    free_scene(&app->scene);
+    free(app->manual.text);
+    free_arena(&frame_arena);
+    destroy_occlusion_culler(&app->occlusion);
+    destroy_texture_uploads();
+    destroy_clustered_renderer(&app->clustered);
+    free_frame_benchmark(&app->frame_benchmark);
+
+    if (app->is_headless) {
+        destroy_headless_context(&app->headless);
+    }
+
     if (app->gl_context != NULL) {
         SDL_GL_DeleteContext(app->gl_context);
     }
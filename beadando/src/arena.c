@@ -0,0 +1,148 @@
+#include "arena.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Arena frame_arena;
+
+static ArenaBlock* allocate_block(size_t capacity) {
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + capacity);
+    if (block == NULL) {
+        printf("[ERROR] Cannot allocate an arena block of %zu bytes\n", capacity);
+        exit(1);
+    }
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+void init_arena(Arena* arena, size_t block_size) {
+    memset(arena, 0, sizeof(Arena));
+    arena->block_size = block_size;
+}
+
+/**
+ * Offset of the next allocation in the block with the alignment, the block data is aligned by its address.
+ */
+static size_t align_offset(const ArenaBlock* block, size_t alignment) {
+    uintptr_t data = (uintptr_t)(block + 1) + block->used;
+    return block->used + ((alignment - data % alignment) % alignment);
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t alignment) {
+    ArenaBlock* block = arena->blocks;
+    size_t offset = block != NULL ? align_offset(block, alignment) : 0;
+
+    if (block == NULL || offset + size > block->capacity) {
+        size_t capacity = size + alignment > arena->block_size ? size + alignment : arena->block_size;
+        block = allocate_block(capacity);
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->block_count++;
+        offset = align_offset(block, alignment);
+    }
+
+    block->used = offset + size;
+    arena->used += size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return (char*)(block + 1) + offset;
+}
+
+void* arena_calloc(Arena* arena, size_t size, size_t alignment) {
+    void* data = arena_alloc(arena, size, alignment);
+    memset(data, 0, size);
+    return data;
+}
+
+void reset_arena(Arena* arena) {
+    if (arena->block_count > 1) {
+        size_t capacity = 0;
+        for (ArenaBlock* block = arena->blocks; block != NULL; block = block->next) {
+            capacity += block->capacity;
+        }
+        free_arena(arena);
+        arena->blocks = allocate_block(capacity);
+        arena->block_count = 1;
+    }
+    else if (arena->blocks != NULL) {
+        arena->blocks->used = 0;
+    }
+    arena->used = 0;
+}
+
+void free_arena(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->block_count = 0;
+    arena->used = 0;
+}
+
+#if defined(__GLIBC__) && defined(COUNT_ALLOCATIONS)
+
+// glibc lets the program replace malloc, the replacements count the calls and forward them to glibc.
+// Only the profiling build (make profile) defines COUNT_ALLOCATIONS, the normal builds link the stock allocator.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* data, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* data);
+
+static _Thread_local long heap_allocations;
+
+void* malloc(size_t size) {
+    heap_allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    heap_allocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* data, size_t size) {
+    heap_allocations++;
+    return __libc_realloc(data, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    heap_allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    heap_allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** data, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+    heap_allocations++;
+    void* result = __libc_memalign(alignment, size);
+    if (result == NULL) return ENOMEM;
+    *data = result;
+    return 0;
+}
+
+void free(void* data) {
+    __libc_free(data);
+}
+
+long get_thread_heap_allocations(void) {
+    return heap_allocations;
+}
+
+#else
+
+long get_thread_heap_allocations(void) {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,359 @@
+#include "bake.h"
+#include "dds.h"
+#include "dxt.h"
+#include "filemap.h"
+#include "obj_loader.h"
+#include "object.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+_Static_assert(sizeof(MeshVertex) == 32, "Baked meshes store MeshVertex as 8 packed floats");
+_Static_assert(sizeof(GLuint) == 4, "Baked meshes store 32 bit indices");
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Hash of the config fields the baked vertices depend on, the placement in the room does not count.
+ */
+static uint64_t hash_object_config(const ObjectConfig* config) {
+    uint32_t version = BAKED_MESH_VERSION;
+    uint64_t hash = hash_bytes(FNV_OFFSET_BASIS, &version, sizeof(version));
+    hash = hash_bytes(hash, config->model_path, strlen(config->model_path));
+    hash = hash_bytes(hash, &config->scale, sizeof(config->scale));
+    return hash_bytes(hash, &config->rotation, sizeof(config->rotation));
+}
+
+static bool hash_file(const char* path, uint64_t* hash) {
+    MappedFile file;
+    if (!map_file(&file, path)) return false;
+
+    *hash = hash_bytes(FNV_OFFSET_BASIS, file.data, file.size);
+    unmap_file(&file);
+    return true;
+}
+
+static void get_baked_mesh_path(const ObjectConfig* config, char* path, size_t size) {
+    snprintf(path, size, "%s/%s.mesh", BAKED_MESH_DIRECTORY, config->name);
+}
+
+/**
+ * Write the current size and modification time of the OBJ into the header of the baked mesh.
+ */
+static void restamp_baked_mesh(const char* path, const struct stat* info) {
+    int64_t stamp[2] = { (int64_t)info->st_size, (int64_t)info->st_mtime };
+    FILE* file = fopen(path, "r+b");
+    if (file == NULL) return;
+
+    bool is_written = fseek(file, (long)offsetof(BakedMeshHeader, source_size), SEEK_SET) == 0
+        && fwrite(stamp, sizeof(stamp), 1, file) == 1;
+    is_written = fclose(file) == 0 && is_written;
+    if (!is_written) {
+        printf("[WARNING] Cannot update the source stamp of %s\n", path);
+    }
+}
+
+/**
+ * The size and modification time are checked first, the OBJ is only hashed when they differ.
+ * When the hash still matches, the new stamp is written back so the OBJ is not hashed again on the next start.
+ * Without the OBJ file the baked mesh is used as it is.
+ */
+static bool is_baked_mesh_current(const BakedMeshHeader* header, const ObjectConfig* config, const char* path) {
+    if (header->magic != BAKED_MESH_MAGIC || header->version != BAKED_MESH_VERSION) return false;
+    if (header->config_hash != hash_object_config(config)) return false;
+
+    struct stat info;
+    if (stat(config->model_path, &info) != 0) return true;
+    if ((int64_t)info.st_size == header->source_size && (int64_t)info.st_mtime == header->source_mtime) return true;
+
+    uint64_t source_hash;
+    if (!hash_file(config->model_path, &source_hash) || source_hash != header->source_hash) return false;
+
+    restamp_baked_mesh(path, &info);
+    return true;
+}
+
+static bool is_level_in_file(const BakedMeshLevel* level, size_t file_size) {
+    uint64_t vertex_end = (uint64_t)level->vertex_offset + (uint64_t)level->vertex_count * sizeof(MeshVertex);
+    uint64_t index_end = (uint64_t)level->index_offset + (uint64_t)level->index_count * sizeof(GLuint);
+    return level->vertex_offset % 4 == 0 && level->index_offset % 4 == 0
+        && vertex_end <= file_size && index_end <= file_size;
+}
+
+bool load_baked_mesh(const ObjectConfig* config, LodChain* lod, Vec3* aabb_min, Vec3* aabb_max) {
+    char path[512];
+    get_baked_mesh_path(config, path, sizeof(path));
+
+    MappedFile file;
+    if (!map_file(&file, path)) return false;
+
+    const BakedMeshHeader* header = file.data;
+    if (file.size < sizeof(BakedMeshHeader) || !is_baked_mesh_current(header, config, path)
+        || header->level_count == 0 || header->level_count > MAX_LOD_LEVELS) {
+        printf("[INFO] Baked mesh %s is out of date\n", path);
+        unmap_file(&file);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header->level_count; i++) {
+        if (!is_level_in_file(&header->levels[i], file.size)) {
+            printf("[WARNING] Baked mesh %s is truncated\n", path);
+            unmap_file(&file);
+            return false;
+        }
+    }
+
+    // The levels point into the mapping, nothing is copied before the upload.
+    memset(lod, 0, sizeof(LodChain));
+    char* data = file.data;
+    for (uint32_t i = 0; i < header->level_count; i++) {
+        const BakedMeshLevel* level = &header->levels[i];
+        Mesh* mesh = &lod->levels[i];
+        mesh->vertices = (MeshVertex*)(data + level->vertex_offset);
+        mesh->vertex_count = (int)level->vertex_count;
+        mesh->indices = (GLuint*)(data + level->index_offset);
+        mesh->index_count = (int)level->index_count;
+        lod->triangle_counts[i] = mesh->index_count / 3;
+    }
+    lod->level_count = (int)header->level_count;
+    lod->radius = header->radius;
+    lod->mapping = file;
+
+    *aabb_min = (Vec3){ header->aabb_min[0], header->aabb_min[1], header->aabb_min[2] };
+    *aabb_max = (Vec3){ header->aabb_max[0], header->aabb_max[1], header->aabb_max[2] };
+    return true;
+}
+
+void make_baked_directory(void) {
+#ifdef _WIN32
+    _mkdir("assets");
+    _mkdir(BAKED_MESH_DIRECTORY);
+#else
+    mkdir("assets", 0755);
+    mkdir(BAKED_MESH_DIRECTORY, 0755);
+#endif
+}
+
+bool replace_baked_file(const char* temp_path, const char* path, bool is_written) {
+#ifdef _WIN32
+    // Rename does not replace an existing file on Windows.
+    if (is_written) remove(path);
+#endif
+    if (!is_written || rename(temp_path, path) != 0) {
+        printf("[WARNING] Cannot write %s\n", path);
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
+
+bool save_baked_mesh(const ObjectConfig* config, const LodChain* lod, Vec3 aabb_min, Vec3 aabb_max) {
+    BakedMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BAKED_MESH_MAGIC;
+    header.version = BAKED_MESH_VERSION;
+    header.config_hash = hash_object_config(config);
+    header.radius = lod->radius;
+    header.level_count = (uint32_t)lod->level_count;
+    header.aabb_min[0] = aabb_min.x;
+    header.aabb_min[1] = aabb_min.y;
+    header.aabb_min[2] = aabb_min.z;
+    header.aabb_max[0] = aabb_max.x;
+    header.aabb_max[1] = aabb_max.y;
+    header.aabb_max[2] = aabb_max.z;
+
+    struct stat info;
+    if (stat(config->model_path, &info) != 0 || !hash_file(config->model_path, &header.source_hash)) {
+        printf("[WARNING] Cannot bake %s, the model %s is missing\n", config->name, config->model_path);
+        return false;
+    }
+    header.source_size = (int64_t)info.st_size;
+    header.source_mtime = (int64_t)info.st_mtime;
+
+    uint32_t offset = sizeof(BakedMeshHeader);
+    for (int i = 0; i < lod->level_count; i++) {
+        const Mesh* mesh = &lod->levels[i];
+        header.levels[i].vertex_offset = offset;
+        header.levels[i].vertex_count = (uint32_t)mesh->vertex_count;
+        offset += mesh->vertex_count * sizeof(MeshVertex);
+        header.levels[i].index_offset = offset;
+        header.levels[i].index_count = (uint32_t)mesh->index_count;
+        offset += mesh->index_count * sizeof(GLuint);
+    }
+
+    char path[512], temp_path[520];
+    get_baked_mesh_path(config, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    make_baked_directory();
+
+    // Written beside the old file and renamed, so a running instance never maps a half written mesh.
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        printf("[WARNING] Cannot write %s\n", temp_path);
+        return false;
+    }
+
+    bool is_written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; i < lod->level_count && is_written; i++) {
+        const Mesh* mesh = &lod->levels[i];
+        is_written = fwrite(mesh->vertices, sizeof(MeshVertex), mesh->vertex_count, file) == (size_t)mesh->vertex_count
+            && fwrite(mesh->indices, sizeof(GLuint), mesh->index_count, file) == (size_t)mesh->index_count;
+    }
+    is_written = fclose(file) == 0 && is_written;
+    if (!replace_baked_file(temp_path, path, is_written)) return false;
+
+    printf("[INFO] Baked %s into %s (%u bytes)\n", config->model_path, path, offset);
+    return true;
+}
+
+bool bake_object_meshes(const char* config_path) {
+    int config_count = 0;
+    ObjectConfig* configs = read_object_config(config_path, &config_count);
+
+    bool is_success = true;
+    for (int i = 0; i < config_count; i++) {
+        LodChain lod;
+        Vec3 aabb_min, aabb_max;
+        prepare_object_mesh(&configs[i], OBJ_MAX_THREADS, &lod, &aabb_min, &aabb_max);
+        is_success = save_baked_mesh(&configs[i], &lod, aabb_min, aabb_max) && is_success;
+        free_lod_chain(&lod);
+    }
+    free(configs);
+
+    printf("[INFO] Baked %d object meshes\n", config_count);
+    return is_success;
+}
+
+/**
+ * The directories of the image file are kept in the name, so textures with the same file name do not collide.
+ */
+static void get_baked_texture_path(const char* source_path, char* path, size_t size) {
+    int length = snprintf(path, size, "%s/", BAKED_MESH_DIRECTORY);
+    for (const char* c = source_path; *c != '\0' && (size_t)length + 1 < size; c++) {
+        path[length++] = (*c == '/' || *c == '\\' || *c == ':') ? '_' : *c;
+    }
+    path[length] = '\0';
+    strncat(path, ".dds", size - strlen(path) - 1);
+}
+
+bool load_baked_texture(const char* source_path, TextureImage* image) {
+    char path[512];
+    get_baked_texture_path(source_path, path, sizeof(path));
+
+    uint32_t tag[DDS_TAG_WORDS];
+    if (!read_dds(path, image, tag)) return false;
+
+    // The size and modification time of the image are kept in the reserved words of the header.
+    struct stat info;
+    bool is_current = tag[0] == BAKED_TEXTURE_MAGIC && tag[1] == BAKED_TEXTURE_VERSION
+        && (stat(source_path, &info) != 0
+            || ((uint32_t)info.st_size == tag[2] && (uint32_t)((uint64_t)info.st_size >> 32) == tag[3]
+                && (uint32_t)info.st_mtime == tag[4] && (uint32_t)((uint64_t)info.st_mtime >> 32) == tag[5]));
+    if (!is_current) {
+        printf("[INFO] Baked texture %s is out of date\n", path);
+        free_texture_image(image);
+        return false;
+    }
+    return true;
+}
+
+bool save_baked_texture(const char* source_path, const TextureImage* image) {
+    struct stat info;
+    if (stat(source_path, &info) != 0) {
+        printf("[WARNING] Cannot bake the missing texture %s\n", source_path);
+        return false;
+    }
+
+    uint32_t tag[DDS_TAG_WORDS] = { 0 };
+    tag[0] = BAKED_TEXTURE_MAGIC;
+    tag[1] = BAKED_TEXTURE_VERSION;
+    tag[2] = (uint32_t)info.st_size;
+    tag[3] = (uint32_t)((uint64_t)info.st_size >> 32);
+    tag[4] = (uint32_t)info.st_mtime;
+    tag[5] = (uint32_t)((uint64_t)info.st_mtime >> 32);
+
+    char path[512], temp_path[520];
+    get_baked_texture_path(source_path, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    make_baked_directory();
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        printf("[WARNING] Cannot write %s\n", temp_path);
+        return false;
+    }
+    bool is_written = write_dds(file, image, tag);
+    is_written = fclose(file) == 0 && is_written;
+    return replace_baked_file(temp_path, path, is_written);
+}
+
+static bool bake_texture(const char* source_path) {
+    TextureImage source;
+    if (!decode_image(source_path, &source)) return false;
+
+    TextureImage compressed;
+    bool is_baked = compress_texture(&source, &compressed) && save_baked_texture(source_path, &compressed);
+    if (is_baked) {
+        size_t compressed_size = 0;
+        for (int i = 0; i < compressed.level_count; i++) {
+            compressed_size += compressed.level_sizes[i];
+        }
+        printf("[INFO] Baked %s (%dx%d, %d levels) into %zu bytes of %s\n", source_path,
+            compressed.width, compressed.height, compressed.level_count, compressed_size,
+            compressed.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "DXT1" : "DXT5");
+    }
+
+    free_texture_image(&source);
+    free_texture_image(&compressed);
+    return is_baked;
+}
+
+/**
+ * Bake the texture unless an earlier entry already named the same image.
+ */
+static bool bake_unique_texture(const char* source_path, const char** baked, int* baked_count) {
+    if (source_path[0] == '\0') return true;
+    for (int i = 0; i < *baked_count; i++) {
+        if (strcmp(baked[i], source_path) == 0) return true;
+    }
+    baked[(*baked_count)++] = source_path;
+    return bake_texture(source_path);
+}
+
+bool bake_textures(const char* room_config_path, const char* object_config_path) {
+    int room_count = 0, object_count = 0, baked_count = 0;
+    RoomConfig* room_configs = read_room_config(room_config_path, &room_count);
+    ObjectConfig* object_configs = read_object_config(object_config_path, &object_count);
+    const char** baked = malloc((room_count * 3 + object_count + 1) * sizeof(const char*));
+
+    bool is_success = true;
+    for (int i = 0; i < room_count; i++) {
+        is_success = bake_unique_texture(room_configs[i].floor_tex_path, baked, &baked_count) && is_success;
+        is_success = bake_unique_texture(room_configs[i].ceiling_tex_path, baked, &baked_count) && is_success;
+        is_success = bake_unique_texture(room_configs[i].wall_tex_path, baked, &baked_count) && is_success;
+    }
+    for (int i = 0; i < object_count; i++) {
+        is_success = bake_unique_texture(object_configs[i].texture_path, baked, &baked_count) && is_success;
+    }
+    free(baked);
+    free(room_configs);
+    free(object_configs);
+
+    printf("[INFO] Baked %d textures\n", baked_count);
+    return is_success;
+}
@@ -0,0 +1,435 @@
+#include "batch.h"
+#include "scene.h"
+#include "profiler.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int find_or_add_batch(StaticWorld* world, GLuint texture) {
+    for (int i = 0; i < world->batch_count; i++) {
+        if (world->batches[i].texture == texture) return i;
+    }
+
+    world->batches = realloc(world->batches, (world->batch_count + 1) * sizeof(StaticBatch));
+    StaticBatch* batch = &world->batches[world->batch_count];
+    memset(batch, 0, sizeof(StaticBatch));
+    batch->texture = texture;
+    return world->batch_count++;
+}
+
+static bool is_batched_object(const Object* obj) {
+    return obj->is_static && obj->is_active && obj->is_loaded && obj->lod.level_count > 0;
+}
+
+static void append_room_quad(const RoomQuad* quad, MeshVertex* vertices, int* vertex_count, GLuint* indices, int* index_count) {
+    // Split like GL_QUADS: (0, 1, 2) and (0, 2, 3).
+    static const int QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+    GLuint base = *vertex_count;
+
+    for (int i = 0; i < 4; i++) {
+        MeshVertex* vertex = &vertices[(*vertex_count)++];
+        memcpy(vertex->position, quad->vertices[i], sizeof(vertex->position));
+        memcpy(vertex->normal, quad->normal, sizeof(vertex->normal));
+        memcpy(vertex->uv, quad->uv[i], sizeof(vertex->uv));
+    }
+    for (int i = 0; i < 6; i++) {
+        indices[(*index_count)++] = base + QUAD_INDICES[i];
+    }
+}
+
+static void append_object_levels(Object* obj, MeshVertex* vertices, int* vertex_count, GLuint* indices, int* index_count) {
+    for (int level = 0; level < obj->lod.level_count; level++) {
+        const Mesh* mesh = &obj->lod.levels[level];
+        GLuint base = *vertex_count;
+
+        for (int i = 0; i < mesh->vertex_count; i++) {
+            MeshVertex* vertex = &vertices[(*vertex_count)++];
+            *vertex = mesh->vertices[i];
+            vertex->position[0] += obj->position.x;
+            vertex->position[1] += obj->position.y;
+            vertex->position[2] += obj->position.z;
+        }
+
+        obj->lod.first_index[level] = *index_count;
+        for (int i = 0; i < mesh->index_count; i++) {
+            indices[(*index_count)++] = base + mesh->indices[i];
+        }
+    }
+}
+
+// Largest magnitude of the quantized positions and texture coordinates.
+#define PACKED_RANGE 32767.0f
+
+static GLshort quantize(float value, float offset, float step) {
+    return (GLshort)fmaxf(-PACKED_RANGE, fminf(PACKED_RANGE, roundf((value - offset) / step)));
+}
+
+/**
+ * Set the bounds of the batch and quantize its vertices over them, returns the largest position error.
+ * The position step is the same on every axis, so the modelview scale keeps the normals' directions.
+ */
+static float pack_vertices(StaticBatch* batch, const MeshVertex* vertices, int vertex_count, PackedVertex* packed) {
+    float lower[5] = { 0 }, upper[5] = { 0 };
+    for (int i = 0; i < vertex_count; i++) {
+        const float values[5] = { vertices[i].position[0], vertices[i].position[1], vertices[i].position[2],
+            vertices[i].uv[0], vertices[i].uv[1] };
+        for (int c = 0; c < 5; c++) {
+            lower[c] = i == 0 ? values[c] : fminf(lower[c], values[c]);
+            upper[c] = i == 0 ? values[c] : fmaxf(upper[c], values[c]);
+        }
+    }
+
+    float half_size = 0.0f;
+    for (int c = 0; c < 3; c++) {
+        batch->position_offset[c] = (lower[c] + upper[c]) * 0.5f;
+        half_size = fmaxf(half_size, (upper[c] - lower[c]) * 0.5f);
+    }
+    batch->position_step = half_size > 0.0f ? half_size / PACKED_RANGE : 1.0f;
+    for (int c = 0; c < 2; c++) {
+        float half_range = (upper[3 + c] - lower[3 + c]) * 0.5f;
+        batch->uv_offset[c] = (lower[3 + c] + upper[3 + c]) * 0.5f;
+        batch->uv_step[c] = half_range > 0.0f ? half_range / PACKED_RANGE : 1.0f;
+    }
+
+    float max_error = 0.0f;
+    for (int i = 0; i < vertex_count; i++) {
+        const MeshVertex* vertex = &vertices[i];
+        PackedVertex* out = &packed[i];
+        memset(out, 0, sizeof(PackedVertex));
+        for (int c = 0; c < 3; c++) {
+            out->position[c] = quantize(vertex->position[c], batch->position_offset[c], batch->position_step);
+            float error = batch->position_offset[c] + out->position[c] * batch->position_step - vertex->position[c];
+            max_error = fmaxf(max_error, fabsf(error));
+            out->normal[c] = (GLbyte)fmaxf(-127.0f, fminf(127.0f, roundf(vertex->normal[c] * 127.0f)));
+        }
+        for (int c = 0; c < 2; c++) {
+            out->uv[c] = quantize(vertex->uv[c], batch->uv_offset[c], batch->uv_step[c]);
+        }
+    }
+    return max_error;
+}
+
+/**
+ * The rooms join the batches once their textures arrived and their display lists are compiled.
+ */
+static bool is_batched_room(const Room* room) {
+    return room->residency != ROOM_UNLOADED && room->display_list != 0;
+}
+
+static bool has_room_quads(const Room* room, const Scene* scene, GLuint texture) {
+    RoomQuad quads[MAX_ROOM_QUADS];
+    int quad_count = build_room_quads(room, scene, quads);
+    for (int q = 0; q < quad_count; q++) {
+        if (quads[q].texture == texture) return true;
+    }
+    return false;
+}
+
+/**
+ * Collect the batched rooms with faces of the texture of the batch and its static props, both in id order.
+ */
+static void collect_batch_members(const StaticBatch* batch, const Scene* scene, int* room_ids, int* room_count,
+    int* object_ids, int* object_count) {
+    *room_count = 0;
+    for (int r = 0; r < scene->room_count; r++) {
+        if (!is_batched_room(&scene->rooms[r])) continue;
+        if (has_room_quads(&scene->rooms[r], scene, batch->texture)) room_ids[(*room_count)++] = r;
+    }
+    *object_count = 0;
+    for (int i = 0; i < scene->object_count; i++) {
+        const Object* obj = &scene->objects[i];
+        if (is_batched_object(obj) && obj->texture_id == batch->texture) object_ids[(*object_count)++] = i;
+    }
+}
+
+/**
+ * Fill the buffers of one batch: its room faces first, then every level of its props.
+ * The buffers of an emptied batch are deleted.
+ */
+static void upload_batch(StaticBatch* batch, int batch_index, Scene* scene) {
+    // The props that left the batch are drawn from their display lists again.
+    for (int i = 0; i < batch->object_count; i++) {
+        Object* obj = &scene->objects[batch->object_ids[i]];
+        if (obj->static_batch == batch_index) obj->static_batch = -1;
+    }
+
+    int member_capacity = (scene->room_count > scene->object_count ? scene->room_count : scene->object_count) + 1;
+    batch->room_ids = realloc(batch->room_ids, member_capacity * sizeof(int));
+    batch->object_ids = realloc(batch->object_ids, member_capacity * sizeof(int));
+    collect_batch_members(batch, scene, batch->room_ids, &batch->room_count, batch->object_ids, &batch->object_count);
+
+    int vertex_capacity = batch->room_count * MAX_ROOM_QUADS * 4;
+    int index_capacity = batch->room_count * MAX_ROOM_QUADS * 6;
+    for (int i = 0; i < batch->object_count; i++) {
+        const LodChain* lod = &scene->objects[batch->object_ids[i]].lod;
+        for (int level = 0; level < lod->level_count; level++) {
+            vertex_capacity += lod->levels[level].vertex_count;
+            index_capacity += lod->levels[level].index_count;
+        }
+    }
+
+    batch->room_first_index = realloc(batch->room_first_index, (batch->room_count + 1) * sizeof(GLuint));
+    batch->room_index_counts = realloc(batch->room_index_counts, (batch->room_count + 1) * sizeof(GLsizei));
+    batch->draw_counts = realloc(batch->draw_counts, (batch->room_count + batch->object_count + 1) * sizeof(GLsizei));
+    batch->draw_offsets = realloc(batch->draw_offsets, (batch->room_count + batch->object_count + 1) * sizeof(GLvoid*));
+    batch->is_dirty = false;
+    batch->vertex_bytes = 0;
+
+    if (vertex_capacity == 0) {
+        if (batch->vertex_buffer) glDeleteBuffers(1, &batch->vertex_buffer);
+        if (batch->index_buffer) glDeleteBuffers(1, &batch->index_buffer);
+        batch->vertex_buffer = 0;
+        batch->index_buffer = 0;
+        return;
+    }
+
+    MeshVertex* vertices = malloc(vertex_capacity * sizeof(MeshVertex));
+    GLuint* indices = malloc(index_capacity * sizeof(GLuint));
+    int vertex_count = 0;
+    int index_count = 0;
+
+    RoomQuad quads[MAX_ROOM_QUADS];
+    for (int i = 0; i < batch->room_count; i++) {
+        batch->room_first_index[i] = index_count;
+        int quad_count = build_room_quads(&scene->rooms[batch->room_ids[i]], scene, quads);
+        for (int q = 0; q < quad_count; q++) {
+            if (quads[q].texture != batch->texture) continue;
+            append_room_quad(&quads[q], vertices, &vertex_count, indices, &index_count);
+        }
+        batch->room_index_counts[i] = index_count - batch->room_first_index[i];
+    }
+
+    for (int i = 0; i < batch->object_count; i++) {
+        Object* obj = &scene->objects[batch->object_ids[i]];
+        append_object_levels(obj, vertices, &vertex_count, indices, &index_count);
+        obj->static_batch = batch_index;
+    }
+
+    const void* vertex_data = vertices;
+    size_t vertex_bytes = vertex_count * sizeof(MeshVertex);
+    PackedVertex* packed = NULL;
+    batch->is_packed = scene->use_packed_vertices;
+    if (batch->is_packed) {
+        packed = malloc((vertex_count > 0 ? vertex_count : 1) * sizeof(PackedVertex));
+        float max_error = pack_vertices(batch, vertices, vertex_count, packed);
+        printf("[INFO] Packed batch %d: %d vertices, %zu -> %zu bytes, largest position error %.2f mm\n",
+            batch_index, vertex_count, vertex_bytes, vertex_count * sizeof(PackedVertex), max_error * 1000.0f);
+        vertex_data = packed;
+        vertex_bytes = vertex_count * sizeof(PackedVertex);
+    }
+
+    // The buffers are kept, so the draws of the other batches do not change.
+    if (batch->vertex_buffer == 0) glGenBuffers(1, &batch->vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertex_bytes, vertex_data, GL_STATIC_DRAW);
+
+    if (batch->index_buffer == 0) glGenBuffers(1, &batch->index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    batch->vertex_bytes = vertex_bytes;
+
+    free(packed);
+    free(vertices);
+    free(indices);
+}
+
+static bool are_same_ids(const int* ids, int count, const int* other_ids, int other_count) {
+    return count == other_count && (count == 0 || memcmp(ids, other_ids, count * sizeof(int)) == 0);
+}
+
+void invalidate_static_world(StaticWorld* world, Scene* scene) {
+    if (!world->is_ready) return;
+
+    // Every texture in use gets a batch before the members are compared.
+    RoomQuad quads[MAX_ROOM_QUADS];
+    for (int r = 0; r < scene->room_count; r++) {
+        if (!is_batched_room(&scene->rooms[r])) continue;
+        int quad_count = build_room_quads(&scene->rooms[r], scene, quads);
+        for (int q = 0; q < quad_count; q++) {
+            find_or_add_batch(world, quads[q].texture);
+        }
+    }
+    for (int i = 0; i < scene->object_count; i++) {
+        if (is_batched_object(&scene->objects[i])) find_or_add_batch(world, scene->objects[i].texture_id);
+    }
+
+    int member_capacity = (scene->room_count > scene->object_count ? scene->room_count : scene->object_count) + 1;
+    int* room_ids = malloc(member_capacity * sizeof(int));
+    int* object_ids = malloc(member_capacity * sizeof(int));
+    for (int b = 0; b < world->batch_count; b++) {
+        StaticBatch* batch = &world->batches[b];
+        if (batch->is_dirty) continue;
+
+        int room_count, object_count;
+        collect_batch_members(batch, scene, room_ids, &room_count, object_ids, &object_count);
+        if (are_same_ids(batch->room_ids, batch->room_count, room_ids, room_count)
+            && are_same_ids(batch->object_ids, batch->object_count, object_ids, object_count)) continue;
+
+        // The rooms of the batch are drawn from their display lists until every batch is uploaded again.
+        batch->is_dirty = true;
+        world->dirty_count++;
+        for (int i = 0; i < batch->room_count; i++) {
+            scene->rooms[batch->room_ids[i]].is_batched = false;
+        }
+        for (int i = 0; i < room_count; i++) {
+            scene->rooms[room_ids[i]].is_batched = false;
+        }
+    }
+    free(room_ids);
+    free(object_ids);
+}
+
+/**
+ * Sum the vertex buffers and draw the resident rooms from the batches again.
+ */
+static void finish_static_world_update(StaticWorld* world, Scene* scene) {
+    world->vertex_bytes = 0;
+    for (int b = 0; b < world->batch_count; b++) {
+        world->vertex_bytes += world->batches[b].vertex_bytes;
+    }
+
+    int room_count = 0;
+    for (int r = 0; r < scene->room_count; r++) {
+        scene->rooms[r].is_batched = is_batched_room(&scene->rooms[r]);
+        if (scene->rooms[r].is_batched) room_count++;
+    }
+    printf("[INFO] Static world: %d rooms in %d batches, %zu KB of %s vertices\n", room_count, world->batch_count,
+        world->vertex_bytes / 1024, scene->use_packed_vertices ? "packed" : "float");
+}
+
+void update_static_world(StaticWorld* world, Scene* scene, int budget_ms) {
+    if (!world->is_ready || world->dirty_count == 0) return;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = SDL_GetPerformanceFrequency() * budget_ms / 1000;
+    for (int b = 0; b < world->batch_count && world->dirty_count > 0; b++) {
+        if (!world->batches[b].is_dirty) continue;
+        if (budget_ms > 0 && SDL_GetPerformanceCounter() - start >= budget) break;
+
+        upload_batch(&world->batches[b], b, scene);
+        world->dirty_count--;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    if (world->dirty_count == 0) {
+        finish_static_world_update(world, scene);
+    }
+}
+
+bool build_static_world(StaticWorld* world, Scene* scene) {
+    memset(world, 0, sizeof(StaticWorld));
+    if (!gl_features.buffer_objects) {
+        printf("[WARNING] No buffer objects, the static world stays in display lists.\n");
+        return false;
+    }
+
+    world->is_ready = true;
+    invalidate_static_world(world, scene);
+    update_static_world(world, scene, 0);
+    if (world->batch_count == 0) {
+        finish_static_world_update(world, scene);
+    }
+    return true;
+}
+
+/**
+ * Scale the packed integers back to world positions and texture coordinates.
+ */
+static void push_dequantization(const StaticBatch* batch) {
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glTranslatef(batch->uv_offset[0], batch->uv_offset[1], 0.0f);
+    glScalef(batch->uv_step[0], batch->uv_step[1], 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glTranslatef(batch->position_offset[0], batch->position_offset[1], batch->position_offset[2]);
+    glScalef(batch->position_step, batch->position_step, batch->position_step);
+}
+
+static void pop_dequantization(void) {
+    glPopMatrix();
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void draw_static_world(const StaticWorld* world, const Scene* scene) {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    for (int b = 0; b < world->batch_count; b++) {
+        const StaticBatch* batch = &world->batches[b];
+        int range_count = 0;
+
+        // Until a rebuilt batch is uploaded, its changed rooms and props are drawn from their display lists.
+        for (int i = 0; i < batch->room_count; i++) {
+            if (!scene->rooms[batch->room_ids[i]].is_batched) continue;
+            batch->draw_counts[range_count] = batch->room_index_counts[i];
+            batch->draw_offsets[range_count] = (const GLvoid*)(batch->room_first_index[i] * sizeof(GLuint));
+            range_count++;
+        }
+
+        for (int i = 0; i < batch->object_count; i++) {
+            const Object* obj = &scene->objects[batch->object_ids[i]];
+            if (obj->static_batch != b || !obj->is_active || obj->is_occluded) continue;
+
+            int level = obj->lod.current;
+            batch->draw_counts[range_count] = obj->lod.triangle_counts[level] * 3;
+            batch->draw_offsets[range_count] = (const GLvoid*)(obj->lod.first_index[level] * sizeof(GLuint));
+            range_count++;
+
+            profiler.stats.triangles += obj->lod.triangle_counts[level];
+            profiler.stats.lod_objects[level]++;
+        }
+
+        if (range_count == 0) continue;
+
+        glBindTexture(GL_TEXTURE_2D, batch->texture);
+        glBindBuffer(GL_ARRAY_BUFFER, batch->vertex_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->index_buffer);
+        if (batch->is_packed) {
+            push_dequantization(batch);
+            glVertexPointer(3, GL_SHORT, sizeof(PackedVertex), (const GLvoid*)offsetof(PackedVertex, position));
+            glNormalPointer(GL_BYTE, sizeof(PackedVertex), (const GLvoid*)offsetof(PackedVertex, normal));
+            glTexCoordPointer(2, GL_SHORT, sizeof(PackedVertex), (const GLvoid*)offsetof(PackedVertex, uv));
+        }
+        else {
+            glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, position));
+            glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, normal));
+            glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), (const GLvoid*)offsetof(MeshVertex, uv));
+        }
+
+        glMultiDrawElements(GL_TRIANGLES, batch->draw_counts, GL_UNSIGNED_INT, batch->draw_offsets, range_count);
+        if (batch->is_packed) {
+            pop_dequantization();
+        }
+        profiler.stats.draw_calls++;
+        profiler.stats.texture_binds++;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+void destroy_static_world(StaticWorld* world) {
+    for (int b = 0; b < world->batch_count; b++) {
+        StaticBatch* batch = &world->batches[b];
+        if (batch->vertex_buffer) glDeleteBuffers(1, &batch->vertex_buffer);
+        if (batch->index_buffer) glDeleteBuffers(1, &batch->index_buffer);
+        free(batch->room_ids);
+        free(batch->room_first_index);
+        free(batch->room_index_counts);
+        free(batch->object_ids);
+        free(batch->draw_counts);
+        free(batch->draw_offsets);
+    }
+    free(world->batches);
+    memset(world, 0, sizeof(StaticWorld));
+}
@@ -0,0 +1,478 @@
+#include "benchmark.h"
+#include "app.h"
+#include "config.h"
+#include "obj_loader.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL2/SDL_image.h>
+#include <obj/load.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static float random_range(float min, float max) {
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+void add_benchmark_lights(Scene* scene, int count) {
+    if (scene->room_count == 0 || count <= 0) return;
+
+    // The old array stays in the scene arena until the scene is freed.
+    Lighting* lights = ARENA_ARRAY(&scene->arena, Lighting, scene->light_count + count);
+    memcpy(lights, scene->lights, scene->light_count * sizeof(Lighting));
+    scene->lights = lights;
+
+    for (int i = 0; i < count; i++) {
+        const Room* room = &scene->rooms[i % scene->room_count];
+        Lighting* light = &scene->lights[scene->light_count];
+
+        memset(light, 0, sizeof(Lighting));
+        snprintf(light->name, sizeof(light->name), "bench_light_%d", i);
+        snprintf(light->room_name, sizeof(light->room_name), "%s", room->name);
+
+        light->enabled = true;
+        light->slot = scene->light_count;
+        light->is_spotlight = true;
+        light->position = (Vec4){
+            room->position.x + random_range(-0.45f, 0.45f) * room->dimension.x,
+            room->position.y + random_range(-0.45f, 0.45f) * room->dimension.y,
+            room->position.z + room->dimension.z - 0.1f,
+            1.0f
+        };
+        light->direction = (Vec3){ 0.0f, 0.0f, -1.0f };
+        light->cutoff = random_range(45.0f, 80.0f);
+        light->exponent = random_range(2.0f, 10.0f);
+        light->range = random_range(3.0f, 6.0f);
+        light->brightness = 0.5f;
+        light->ambient = (ColorRGBA){ 0.0f, 0.0f, 0.0f, 1.0f };
+        light->diffuse = (ColorRGBA){ random_range(0.2f, 1.0f), random_range(0.2f, 1.0f), random_range(0.2f, 1.0f), 1.0f };
+        light->specular = (ColorRGBA){ 0.2f, 0.2f, 0.2f, 1.0f };
+
+        scene->light_count++;
+    }
+
+    // The lights array moved, so re-resolve the pointer kept by the extraction.
+    scene->extraction.target_light = find_light_by_name(scene, "start_light");
+
+    printf("[INFO] Added %d benchmark lights, %d lights in total\n", count, scene->light_count);
+}
+
+void start_light_benchmark(App* app, int light_count) {
+    LightBenchmark* bench = &app->light_benchmark;
+
+    add_benchmark_lights(&app->scene, light_count);
+
+    bench->enabled = true;
+    bench->light_count = app->scene.light_count;
+    bench->warmup_frames = 30;
+    bench->measured_frames = 300;
+    bench->frame = 0;
+    bench->path = 0;
+    bench->path_ms[0] = bench->path_ms[1] = 0.0;
+
+    app->use_clustered = false;
+    app->pacer.mode = PACING_UNCAPPED;
+    app->pacer.idle_throttle = false;
+    apply_frame_pacing(&app->pacer, app->window != NULL);
+}
+
+void step_light_benchmark(App* app) {
+    LightBenchmark* bench = &app->light_benchmark;
+
+    bench->frame++;
+    if (bench->frame == bench->warmup_frames) {
+        glFinish();
+        bench->path_start = SDL_GetPerformanceCounter();
+    }
+    if (bench->frame < bench->warmup_frames + bench->measured_frames) return;
+
+    glFinish();
+    Uint64 elapsed = SDL_GetPerformanceCounter() - bench->path_start;
+    bench->path_ms[bench->path] = 1000.0 * elapsed / SDL_GetPerformanceFrequency() / bench->measured_frames;
+
+    if (bench->path == 0 && app->clustered.is_ready) {
+        bench->path = 1;
+        bench->frame = 0;
+        app->use_clustered = true;
+        return;
+    }
+
+    printf("[INFO] Light benchmark, %d lights, %d frames per path:\n", bench->light_count, bench->measured_frames);
+    printf("  Fixed-function (%d passes): %.3f ms/frame\n",
+        (bench->light_count + MAX_LIGHTS - 1) / MAX_LIGHTS, bench->path_ms[0]);
+    if (app->clustered.is_ready) {
+        printf("  Clustered: %.3f ms/frame\n", bench->path_ms[1]);
+    }
+    else {
+        printf("  Clustered: unavailable\n");
+    }
+
+    bench->enabled = false;
+    app->is_running = false;
+}
+
+static Vec3 room_eye_point(const Room* room) {
+    return (Vec3){ room->position.x, room->position.y, room->position.z + 1.25f };
+}
+
+/**
+ * Depth-first walk through the room graph, returning to each room after visiting a neighbour.
+ * Doors are centered on the walls, so straight lines between connected room centers pass through them.
+ */
+static void walk_rooms(FrameBenchmark* bench, const Scene* scene, int room_idx, bool* visited) {
+    visited[room_idx] = true;
+    bench->path[bench->path_length++] = room_eye_point(&scene->rooms[room_idx]);
+
+    for (int d = 0; d < DIR_COUNT; d++) {
+        const Connection* connection = &scene->rooms[room_idx].connections[d];
+        if (connection->room[0] == '\0') continue;
+        if (connection->id < 0 || connection->id >= scene->room_count) continue;
+        if (visited[connection->id]) continue;
+
+        walk_rooms(bench, scene, connection->id, visited);
+        bench->path[bench->path_length++] = room_eye_point(&scene->rooms[room_idx]);
+    }
+}
+
+void start_frame_benchmark(App* app, int frame_count, const char* screenshot_path, const char* report_path) {
+    FrameBenchmark* bench = &app->frame_benchmark;
+    const Scene* scene = &app->scene;
+
+    bench->frame_count = frame_count;
+    bench->frame = 0;
+    bench->frame_ms = calloc(frame_count, sizeof(double));
+    bench->steady_allocations = 0;
+    bench->allocating_frames = 0;
+    bench->screenshot_path = screenshot_path;
+    bench->report_path = report_path;
+    // The walk enters every room once and returns to it after each neighbour, so it has at most two points per room.
+    bench->path = calloc(scene->room_count > 0 ? scene->room_count * 2 : 1, sizeof(Vec3));
+    bench->path_length = 0;
+    bench->path_total = 0.0f;
+
+    if (scene->room_count > 0) {
+        bool* visited = calloc(scene->room_count, sizeof(bool));
+        int start_idx = find_name(&scene->room_index, "start_room");
+        if (start_idx < 0) start_idx = 0;
+        walk_rooms(bench, scene, start_idx, visited);
+        free(visited);
+    }
+    else {
+        bench->path[bench->path_length++] = app->camera.position;
+    }
+
+    for (int i = 1; i < bench->path_length; i++) {
+        bench->path_total += vec3_length(vec3_substract(bench->path[i], bench->path[i - 1]));
+    }
+
+    app->camera.is_orbital = false;
+    set_camera_speed(&app->camera, 0);
+    set_camera_side_speed(&app->camera, 0);
+    set_camera_vertical_speed(&app->camera, 0);
+
+    app->pacer.mode = PACING_UNCAPPED;
+    app->pacer.idle_throttle = false;
+    apply_frame_pacing(&app->pacer, app->window != NULL);
+
+    bench->enabled = true;
+    bench->frame_start = SDL_GetPerformanceCounter();
+
+    printf("[INFO] Frame benchmark: %d frames along %d path points (%.1f m)\n",
+        frame_count, bench->path_length, bench->path_total);
+}
+
+void update_benchmark_camera(App* app) {
+    FrameBenchmark* bench = &app->frame_benchmark;
+    Camera* camera = &app->camera;
+
+    float t = bench->frame_count > 1 ? (float)bench->frame / (bench->frame_count - 1) : 1.0f;
+    float distance = t * bench->path_total;
+
+    Vec3 position = bench->path[0];
+    Vec3 heading = { 0.0f, 0.0f, 0.0f };
+    for (int i = 1; i < bench->path_length; i++) {
+        Vec3 segment = vec3_substract(bench->path[i], bench->path[i - 1]);
+        float length = vec3_length(segment);
+        if (length < EPSILON) continue;
+
+        heading = segment;
+        if (distance <= length || i == bench->path_length - 1) {
+            float s = fminf(distance / length, 1.0f);
+            position = vec3_add(bench->path[i - 1], vec3_scale(segment, s));
+            break;
+        }
+        distance -= length;
+    }
+
+    camera->position = position;
+    if (vec3_length(heading) > EPSILON) {
+        camera->rotation.z = atan2f(heading.y, heading.x) * 180.0f / M_PI;
+    }
+    camera->rotation.x = 0.0f;
+    update_camera_basis(camera);
+
+    if (camera->physics_body.body) {
+        dBodySetLinearVel(camera->physics_body.body, 0.0, 0.0, 0.0);
+        dBodySetPosition(camera->physics_body.body, position.x, position.y, position.z);
+    }
+}
+
+bool save_framebuffer_png(const char* filename, int width, int height) {
+    int pitch = width * 4;
+    unsigned char* pixels = malloc((size_t)pitch * height);
+    unsigned char* flipped = malloc((size_t)pitch * height);
+    if (!pixels || !flipped) {
+        free(pixels);
+        free(flipped);
+        return false;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // OpenGL rows start at the bottom, PNG rows at the top.
+    for (int y = 0; y < height; y++) {
+        memcpy(flipped + (size_t)y * pitch, pixels + (size_t)(height - 1 - y) * pitch, pitch);
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(flipped, width, height, 32, pitch, SDL_PIXELFORMAT_RGBA32);
+    bool saved = surface && IMG_SavePNG(surface, filename) == 0;
+    if (!saved) {
+        printf("[ERROR] Could not save %s: %s\n", filename, IMG_GetError());
+    }
+
+    SDL_FreeSurface(surface);
+    free(pixels);
+    free(flipped);
+    return saved;
+}
+
+void capture_benchmark_frame(App* app) {
+    FrameBenchmark* bench = &app->frame_benchmark;
+
+    if (bench->frame == bench->frame_count - 1 && bench->screenshot_path) {
+        if (save_framebuffer_png(bench->screenshot_path, app->window_width, app->window_height)) {
+            printf("[INFO] Saved the final frame to %s\n", bench->screenshot_path);
+        }
+    }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count) - 1;
+    if (rank < 0) rank = 0;
+    if (rank >= count) rank = count - 1;
+    return sorted[rank];
+}
+
+static void write_frame_report(FILE* out, const FrameBenchmark* bench, const double* sorted, const App* app) {
+    double sum = 0.0;
+    for (int i = 0; i < bench->frame_count; i++) {
+        sum += sorted[i];
+    }
+
+    fprintf(out, "frames: %d\n", bench->frame_count);
+    fprintf(out, "resolution: %dx%d\n", app->window_width, app->window_height);
+    fprintf(out, "renderer: %s\n", glGetString(GL_RENDERER));
+    fprintf(out, "lighting: %s\n", app->use_clustered ? "clustered" : "fixed-function");
+    fprintf(out, "vertex_format: %s\n", app->scene.use_packed_vertices ? "packed" : "float");
+    fprintf(out, "static_vertex_bytes: %zu\n", app->scene.static_world.vertex_bytes);
+    fprintf(out, "mean_ms: %.3f\n", sum / bench->frame_count);
+    fprintf(out, "p50_ms: %.3f\n", percentile(sorted, bench->frame_count, 50.0));
+    fprintf(out, "p90_ms: %.3f\n", percentile(sorted, bench->frame_count, 90.0));
+    fprintf(out, "p95_ms: %.3f\n", percentile(sorted, bench->frame_count, 95.0));
+    fprintf(out, "p99_ms: %.3f\n", percentile(sorted, bench->frame_count, 99.0));
+    fprintf(out, "max_ms: %.3f\n", sorted[bench->frame_count - 1]);
+    if (get_thread_heap_allocations() >= 0) {
+        fprintf(out, "steady_heap_allocations: %ld\n", bench->steady_allocations);
+        fprintf(out, "steady_allocating_frames: %d\n", bench->allocating_frames);
+    }
+}
+
+void step_frame_benchmark(App* app) {
+    FrameBenchmark* bench = &app->frame_benchmark;
+
+    glFinish();
+    Uint64 now = SDL_GetPerformanceCounter();
+    bench->frame_ms[bench->frame] = 1000.0 * (now - bench->frame_start) / SDL_GetPerformanceFrequency();
+    bench->frame_start = now;
+
+    long allocations = profiler.last_stats.heap_allocations;
+    if (bench->frame >= BENCHMARK_STEADY_FRAME && allocations > 0) {
+        bench->steady_allocations += allocations;
+        bench->allocating_frames++;
+    }
+
+    bench->frame++;
+    if (bench->frame < bench->frame_count) return;
+
+    qsort(bench->frame_ms, bench->frame_count, sizeof(double), compare_doubles);
+
+    printf("[INFO] Frame benchmark results:\n");
+    write_frame_report(stdout, bench, bench->frame_ms, app);
+
+    if (bench->report_path) {
+        FILE* out = fopen(bench->report_path, "w");
+        if (out) {
+            write_frame_report(out, bench, bench->frame_ms, app);
+            fclose(out);
+        }
+        else {
+            printf("[ERROR] Cannot write %s\n", bench->report_path);
+        }
+    }
+
+    bench->enabled = false;
+    app->is_running = false;
+}
+
+void free_frame_benchmark(FrameBenchmark* bench) {
+    free(bench->frame_ms);
+    bench->frame_ms = NULL;
+    free(bench->path);
+    bench->path = NULL;
+    bench->enabled = false;
+}
+
+static double elapsed_ms(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void run_obj_benchmark(const char* path) {
+    double libobj_ms = INFINITY, loader_ms = INFINITY;
+    int libobj_vertices = 0, loader_vertices = 0;
+    int triangles = 0;
+
+    for (int i = 0; i < OBJ_BENCHMARK_RUNS; i++) {
+        Model model;
+        Mesh mesh;
+        Uint64 start = SDL_GetPerformanceCounter();
+        load_model(&model, path);
+        mesh_from_model(&mesh, &model);
+        libobj_ms = fmin(libobj_ms, elapsed_ms(start));
+        libobj_vertices = mesh.vertex_count;
+        free_mesh(&mesh);
+        free_model(&model);
+    }
+
+    for (int i = 0; i < OBJ_BENCHMARK_RUNS; i++) {
+        Mesh mesh;
+        Vec3 aabb_min, aabb_max;
+        Uint64 start = SDL_GetPerformanceCounter();
+        load_obj_mesh(path, OBJ_MAX_THREADS, &mesh, &aabb_min, &aabb_max);
+        loader_ms = fmin(loader_ms, elapsed_ms(start));
+        loader_vertices = mesh.vertex_count;
+        triangles = mesh.index_count / 3;
+        free_mesh(&mesh);
+    }
+
+    printf("OBJ loader benchmark: %s, %d triangles, best of %d runs\n", path, triangles, OBJ_BENCHMARK_RUNS);
+    printf("  libobj + mesh_from_model: %8.2f ms, %d vertices\n", libobj_ms, libobj_vertices);
+    printf("  load_obj_mesh:            %8.2f ms, %d vertices (%d threads)\n", loader_ms, loader_vertices, SDL_GetCPUCount());
+    printf("  speedup: %.2fx\n", libobj_ms / loader_ms);
+}
+
+/**
+ * Write generated object entries until the file reaches the given size.
+ */
+static bool generate_object_config(const char* path, long target_size) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("[ERROR] Cannot write %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "[\n");
+    for (int i = 0; ftell(file) < target_size; i++) {
+        fprintf(file, "%s    {\n", i > 0 ? ",\n" : "");
+        fprintf(file, "        \"name\": \"generated_%d\",\n", i);
+        fprintf(file, "        \"model_path\": \"assets/models/barrel.obj\",\n");
+        fprintf(file, "        \"texture_path\": \"assets/textures/wood_rough.jpg\",\n");
+        fprintf(file, "        \"offset\": [%.3f, %.3f, 0.0],\n", random_range(-1.0f, 1.0f), random_range(-1.0f, 1.0f));
+        fprintf(file, "        \"rotation\": [90, 0, %d],\n", rand() % 360);
+        fprintf(file, "        \"scale\": [1, 1, 1],\n");
+        fprintf(file, "        \"mass\": %.2f,\n", random_range(0.5f, 20.0f));
+        fprintf(file, "        \"value\": %d,\n", rand() % 200);
+        fprintf(file, "        \"room_name\": \"start_room\",\n");
+        fprintf(file, "        \"is_static\": %s\n", i % 4 == 0 ? "true" : "false");
+        fprintf(file, "    }");
+    }
+    fprintf(file, "\n]\n");
+    return fclose(file) == 0;
+}
+
+/**
+ * Peak resident set size of the process in megabytes, 0 where it is not available.
+ */
+static double get_peak_rss_mb(void) {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss / 1024.0;
+    }
+#endif
+    return 0.0;
+}
+
+/**
+ * Sums a field of every entry, so neither reader can skip the copying.
+ */
+typedef struct ConfigBenchmarkCount {
+    int entry_count;
+    long value_sum;
+} ConfigBenchmarkCount;
+
+static bool count_object_config(const ObjectConfig* config, void* user_data) {
+    ConfigBenchmarkCount* count = user_data;
+    count->entry_count++;
+    count->value_sum += config->value;
+    return true;
+}
+
+void run_config_benchmark(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Generating a %d MB object config at %s\n", CONFIG_BENCHMARK_SIZE_MB, path);
+        if (!generate_object_config(path, CONFIG_BENCHMARK_SIZE_MB * 1024L * 1024L)) return;
+        file = fopen(path, "rb");
+        if (file == NULL) return;
+    }
+    fseek(file, 0, SEEK_END);
+    double size_mb = ftell(file) / (1024.0 * 1024.0);
+    fclose(file);
+
+    // The peak only grows, so the streaming reader runs first and each reader is reported by its increase.
+    double base_rss = get_peak_rss_mb();
+    ConfigBenchmarkCount stream_count = { 0 };
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool is_streamed = stream_object_config(path, count_object_config, &stream_count);
+    double stream_ms = elapsed_ms(start);
+    double stream_rss = get_peak_rss_mb();
+
+    ConfigBenchmarkCount tree_count = { 0 };
+    start = SDL_GetPerformanceCounter();
+    bool is_parsed = parse_object_config_tree(path, count_object_config, &tree_count);
+    double tree_ms = elapsed_ms(start);
+    double tree_rss = get_peak_rss_mb();
+
+    if (!is_streamed || !is_parsed || stream_count.entry_count != tree_count.entry_count
+        || stream_count.value_sum != tree_count.value_sum) {
+        printf("[WARNING] The readers disagree: %d and %d entries\n", stream_count.entry_count, tree_count.entry_count);
+    }
+
+    printf("Config reader benchmark: %s, %.1f MB, %d entries\n", path, size_mb, stream_count.entry_count);
+    printf("  json-c tree:  %8.2f ms, %7.1f MB/s, peak RSS +%.1f MB\n", tree_ms, size_mb * 1000.0 / tree_ms,
+        tree_rss - stream_rss);
+    printf("  streaming:    %8.2f ms, %7.1f MB/s, peak RSS +%.1f MB\n", stream_ms, size_mb * 1000.0 / stream_ms,
+        stream_rss - base_rss);
+    printf("  speedup: %.2fx\n", tree_ms / stream_ms);
+}
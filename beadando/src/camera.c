@@ -1,7 +1,6 @@
 #include "camera.h"
 
 #include <GL/gl.h>
-#include <GL/glu.h>
 #include <math.h>
 #include <stdio.h>
 
@@ -70,26 +69,54 @@ void update_camera(Camera* camera, double time) {
 }
 
 void set_view(const Camera* camera) {
+    Mat4 view;
+    get_view_matrix(camera, &view);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view.m);
+}
+
+void set_projection(const Camera* camera) {
+    Mat4 projection;
+    get_projection_matrix(camera, &projection);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(projection.m);
     glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+}
 
+void get_view_matrix(const Camera* camera, Mat4* view) {
     if (camera->is_orbital) {
         float azimuth = degree_to_radian(camera->rotation.z);
         float elevation = degree_to_radian(-camera->rotation.x);
-
-        float x = camera->orbital_radius * cos(azimuth) * cos(elevation) + camera->position.x;
-        float y = camera->orbital_radius * sin(azimuth) * cos(elevation) + camera->position.y;
-        float z = camera->orbital_radius * sin(elevation) + camera->position.z;
-
-        gluLookAt(x, y, z, camera->position.x, camera->position.y, camera->position.z, 0, 0, 1);
+        Vec3 eye = {
+            camera->orbital_radius * cos(azimuth) * cos(elevation) + camera->position.x,
+            camera->orbital_radius * sin(azimuth) * cos(elevation) + camera->position.y,
+            camera->orbital_radius * sin(elevation) + camera->position.z
+        };
+        Vec3 up = { 0.0f, 0.0f, 1.0f };
+        mat4_look_at(view, eye, camera->position, up);
     }
     else {
-        glRotatef(-(camera->rotation.x + 90), 1.0, 0, 0);
-        glRotatef(-(camera->rotation.z - 90), 0, 0, 1.0);
-        glTranslatef(-camera->position.x, -camera->position.y, -camera->position.z);
+        // Rotation about x by -(rotation.x + 90), then about z by -(rotation.z - 90), then the translation.
+        Vec3 x_axis = { 1.0f, 0.0f, 0.0f };
+        Vec3 z_axis = { 0.0f, 0.0f, 1.0f };
+        Vec3 origin = { 0.0f, 0.0f, 0.0f };
+        Quat rotation = quat_multiply(
+            quat_from_axis_angle(x_axis, -(camera->rotation.x + 90)),
+            quat_from_axis_angle(z_axis, -(camera->rotation.z - 90)));
+
+        Mat4 orientation, translation;
+        mat4_from_quat(&orientation, rotation, origin);
+        mat4_translation(&translation, vec3_scale(camera->position, -1.0f));
+        mat4_multiply(view, &orientation, &translation);
     }
 }
 
+void get_projection_matrix(const Camera* camera, Mat4* projection) {
+    mat4_perspective(projection, camera->fov, camera->aspect_ratio, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+}
+
 void rotate_camera(Camera* camera, double horizontal, double vertical) {
     camera->rotation.z += camera->is_orbital ? -horizontal :  horizontal;
     camera->rotation.x += camera->is_orbital ? -vertical :  vertical;
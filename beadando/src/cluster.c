@@ -0,0 +1,261 @@
+#include "cluster.h"
+#include "scene.h"
+#include "shader.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void transform_point(const Mat4* m, Vec3 p, float w, float out[3]) {
+    Vec4 view = mat4_transform(m, (Vec4){ p.x, p.y, p.z, w });
+    out[0] = view.x;
+    out[1] = view.y;
+    out[2] = view.z;
+}
+
+static bool is_global_light(const Lighting* light) {
+    return !light->is_spotlight || light->range <= 0.0f;
+}
+
+static int depth_to_slice(float depth) {
+    float log_ratio = logf(CAMERA_FAR_PLANE / CAMERA_NEAR_PLANE);
+    int slice = (int)floorf(logf(depth / CAMERA_NEAR_PLANE) / log_ratio * CLUSTER_GRID_Z);
+    if (slice < 0) return 0;
+    if (slice >= CLUSTER_GRID_Z) return CLUSTER_GRID_Z - 1;
+    return slice;
+}
+
+static float slice_to_depth(int slice) {
+    return CAMERA_NEAR_PLANE * powf(CAMERA_FAR_PLANE / CAMERA_NEAR_PLANE, (float)slice / CLUSTER_GRID_Z);
+}
+
+/**
+ * Conservative tile range covered by the box [lo, hi] x [near_depth, far_depth] along one screen axis.
+ */
+static bool tile_range(float lo, float hi, float near_depth, float far_depth, float scale, int tiles, int* first, int* last) {
+    float ndc_min = fminf(lo / near_depth, lo / far_depth) * scale;
+    float ndc_max = fmaxf(hi / near_depth, hi / far_depth) * scale;
+    if (ndc_max < -1.0f || ndc_min > 1.0f) return false;
+
+    *first = (int)floorf((ndc_min + 1.0f) * 0.5f * tiles);
+    *last = (int)floorf((ndc_max + 1.0f) * 0.5f * tiles);
+    if (*first < 0) *first = 0;
+    if (*last >= tiles) *last = tiles - 1;
+    return true;
+}
+
+/**
+ * Visit every cluster touched by a light sphere: count it in the first pass, write its index in the second.
+ */
+static void bin_light(ClusteredRenderer* renderer, const float center[3], float radius, float p00, float p11, GLuint light_index, bool write) {
+    float depth = -center[2];
+    float depth_min = fmaxf(depth - radius, CAMERA_NEAR_PLANE);
+    float depth_max = fminf(depth + radius, CAMERA_FAR_PLANE);
+    if (depth_max < CAMERA_NEAR_PLANE || depth_min > CAMERA_FAR_PLANE) return;
+
+    int first_slice = depth_to_slice(depth_min);
+    int last_slice = depth_to_slice(depth_max);
+
+    for (int z = first_slice; z <= last_slice; z++) {
+        float slice_near = fmaxf(slice_to_depth(z), depth_min);
+        float slice_far = fminf(slice_to_depth(z + 1), depth_max);
+
+        int x0, x1, y0, y1;
+        if (!tile_range(center[0] - radius, center[0] + radius, slice_near, slice_far, p00, CLUSTER_GRID_X, &x0, &x1)) continue;
+        if (!tile_range(center[1] - radius, center[1] + radius, slice_near, slice_far, p11, CLUSTER_GRID_Y, &y0, &y1)) continue;
+
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                int cluster = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+                GLuint* cell = &renderer->grid[cluster * 2];
+                if (write) {
+                    renderer->indices[cell[0] + cell[1]] = light_index;
+                }
+                cell[1]++;
+            }
+        }
+    }
+}
+
+static void write_light_texels(float* texels, const Lighting* light, const Mat4* view) {
+    float position[3], direction[3];
+    Vec3 light_position = { light->position.x, light->position.y, light->position.z };
+    transform_point(view, light_position, light->position.w, position);
+    transform_point(view, light->direction, 0.0f, direction);
+
+    float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    if (length > EPSILON) {
+        direction[0] /= length;
+        direction[1] /= length;
+        direction[2] /= length;
+    }
+
+    float range = is_global_light(light) ? 0.0f : light->range;
+    float cos_cutoff = (light->is_spotlight && light->cutoff < 180.0f) ? cosf(degree_to_radian(light->cutoff)) : -1.0f;
+
+    float data[CLUSTER_LIGHT_TEXELS * 4] = {
+        position[0], position[1], position[2], range,
+        light->diffuse.red * light->brightness,
+        light->diffuse.green * light->brightness,
+        light->diffuse.blue * light->brightness,
+        light->is_spotlight ? 1.0f : 0.0f,
+        direction[0], direction[1], direction[2], cos_cutoff,
+        light->ambient.red, light->ambient.green, light->ambient.blue, light->exponent,
+        light->specular.red, light->specular.green, light->specular.blue, light->position.w
+    };
+    memcpy(texels, data, sizeof(data));
+}
+
+static GLuint create_buffer_texture(GLuint* buffer, GLenum format) {
+    GLuint texture;
+
+    glGenBuffers(1, buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, *buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, *buffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return texture;
+}
+
+bool init_clustered_renderer(ClusteredRenderer* renderer) {
+    memset(renderer, 0, sizeof(ClusteredRenderer));
+
+    if (!gl_features.texture_buffers) {
+        printf("[WARNING] Clustered lighting needs OpenGL 3.1 texture buffers, using fixed-function lighting.\n");
+        return false;
+    }
+
+    renderer->program = load_shader_program("shaders/cluster.vert", "shaders/cluster.frag");
+    if (renderer->program == 0) {
+        printf("[WARNING] Clustered lighting shaders unavailable, using fixed-function lighting.\n");
+        return false;
+    }
+
+    renderer->light_texture = create_buffer_texture(&renderer->light_buffer, GL_RGBA32F);
+    renderer->grid_texture = create_buffer_texture(&renderer->grid_buffer, GL_RG32UI);
+    renderer->index_texture = create_buffer_texture(&renderer->index_buffer, GL_R32UI);
+    renderer->grid = calloc(CLUSTER_COUNT * 2, sizeof(GLuint));
+
+    GLuint program = renderer->program;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "material_texture"), 0);
+    glUniform1i(glGetUniformLocation(program, "light_data"), 1);
+    glUniform1i(glGetUniformLocation(program, "cluster_grid"), 2);
+    glUniform1i(glGetUniformLocation(program, "light_indices"), 3);
+    renderer->grid_size_location = glGetUniformLocation(program, "grid_size");
+    renderer->viewport_size_location = glGetUniformLocation(program, "viewport_size");
+    renderer->near_plane_location = glGetUniformLocation(program, "near_plane");
+    renderer->far_plane_location = glGetUniformLocation(program, "far_plane");
+    renderer->global_light_count_location = glGetUniformLocation(program, "global_light_count");
+    glUseProgram(0);
+
+    renderer->is_ready = true;
+    printf("[INFO] Clustered lighting ready (%dx%dx%d clusters)\n",
+        CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+    return true;
+}
+
+void update_light_clusters(ClusteredRenderer* renderer, const Scene* scene, const Camera* camera, const Mat4* view) {
+    // The light and index arrays are only read by the uploads of this frame.
+    renderer->light_data = ARENA_ARRAY(&frame_arena, float, scene->light_count * CLUSTER_LIGHT_TEXELS * 4);
+
+    int light_count = 0;
+    for (int i = 0; i < scene->light_count; i++) {
+        const Lighting* light = &scene->lights[i];
+        if (light->enabled && is_global_light(light)) {
+            write_light_texels(&renderer->light_data[light_count++ * CLUSTER_LIGHT_TEXELS * 4], light, view);
+        }
+    }
+    renderer->global_light_count = light_count;
+
+    float tan_half_fov = tanf(degree_to_radian(camera->fov) * 0.5f);
+    float p11 = 1.0f / tan_half_fov;
+    float p00 = p11 / camera->aspect_ratio;
+
+    memset(renderer->grid, 0, CLUSTER_COUNT * 2 * sizeof(GLuint));
+
+    int first_bounded = light_count;
+    for (int i = 0; i < scene->light_count; i++) {
+        const Lighting* light = &scene->lights[i];
+        if (!light->enabled || is_global_light(light)) continue;
+
+        float* texels = &renderer->light_data[light_count * CLUSTER_LIGHT_TEXELS * 4];
+        write_light_texels(texels, light, view);
+        bin_light(renderer, texels, light->range, p00, p11, light_count, false);
+        light_count++;
+    }
+
+    GLuint offset = 0;
+    for (int c = 0; c < CLUSTER_COUNT; c++) {
+        renderer->grid[c * 2] = offset;
+        offset += renderer->grid[c * 2 + 1];
+        renderer->grid[c * 2 + 1] = 0;
+    }
+    renderer->index_count = offset;
+
+    renderer->indices = ARENA_ARRAY(&frame_arena, GLuint, renderer->index_count);
+
+    for (int i = first_bounded; i < light_count; i++) {
+        const float* texels = &renderer->light_data[i * CLUSTER_LIGHT_TEXELS * 4];
+        bin_light(renderer, texels, texels[3], p00, p11, i, true);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, renderer->light_buffer);
+    glBufferData(GL_TEXTURE_BUFFER,
+        (light_count > 0 ? light_count : 1) * CLUSTER_LIGHT_TEXELS * 4 * sizeof(float),
+        light_count > 0 ? renderer->light_data : NULL, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, renderer->grid_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * 2 * sizeof(GLuint), renderer->grid, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, renderer->index_buffer);
+    glBufferData(GL_TEXTURE_BUFFER,
+        (renderer->index_count > 0 ? renderer->index_count : 1) * sizeof(GLuint),
+        renderer->index_count > 0 ? renderer->indices : NULL, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void render_scene_clustered(const Scene* scene, ClusteredRenderer* renderer, const Camera* camera) {
+    update_light_clusters(renderer, scene, camera, &scene->view_matrix);
+
+    glUseProgram(renderer->program);
+    glUniform3i(renderer->grid_size_location, CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+    glUniform2f(renderer->viewport_size_location, (float)camera->viewport.width, (float)camera->viewport.height);
+    glUniform1f(renderer->near_plane_location, CAMERA_NEAR_PLANE);
+    glUniform1f(renderer->far_plane_location, CAMERA_FAR_PLANE);
+    glUniform1i(renderer->global_light_count_location, renderer->global_light_count);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->light_texture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->grid_texture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer->index_texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    draw_scene_geometry(scene);
+
+    glUseProgram(0);
+    draw_scene_overlays(scene);
+}
+
+void destroy_clustered_renderer(ClusteredRenderer* renderer) {
+    if (renderer->is_ready) {
+        glDeleteProgram(renderer->program);
+        glDeleteTextures(1, &renderer->light_texture);
+        glDeleteTextures(1, &renderer->grid_texture);
+        glDeleteTextures(1, &renderer->index_texture);
+        glDeleteBuffers(1, &renderer->light_buffer);
+        glDeleteBuffers(1, &renderer->grid_buffer);
+        glDeleteBuffers(1, &renderer->index_buffer);
+    }
+
+    free(renderer->grid);
+    memset(renderer, 0, sizeof(ClusteredRenderer));
+}
@@ -1,5 +1,8 @@
 #include "config.h"
+#include "filemap.h"
+#include "json_stream.h"
 #include "scene.h"
+#include "trace.h"
 #include <json-c/json.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,9 +11,11 @@
 #include <ctype.h>
 
 json_object* parse_json_file(const char* filename) {
+    trace_begin("Parse JSON");
     FILE* fp = fopen(filename, "r");
     if (!fp) {
         printf("[ERROR] Cannot open %s\n", filename);
+        trace_end();
         return NULL;
     }
 
@@ -24,6 +29,7 @@ json_object* parse_json_file(const char* filename) {
 
     json_object* root = json_tokener_parse(data);
     free(data);
+    trace_end();
     return root;
 }
 
@@ -118,15 +124,187 @@ void parse_room_connections(json_object* item, RoomConfig* cfg) {
     }
 }
 
-void read_room_config(const char* filename, RoomConfig* room_configs, int* room_count) {
+/**
+ * Expected type of a config field. Numbers accept integers too, the length is the array length
+ * or the size of the string buffer the field is copied into.
+ */
+typedef struct FieldSchema {
+    const char* name;
+    json_type type;
+    int length;
+    bool is_required;
+} FieldSchema;
+
+static const FieldSchema room_schema[] = {
+    { "name", json_type_string, 64, true },
+    { "dimension", json_type_array, 3, true },
+    { "floor_tex", json_type_string, 256, false },
+    { "ceiling_tex", json_type_string, 256, false },
+    { "wall_tex", json_type_string, 256, false },
+    { "connections", json_type_array, DIR_COUNT, false },
+    { NULL, json_type_null, 0, false }
+};
+
+static const FieldSchema object_schema[] = {
+    { "name", json_type_string, 64, true },
+    { "model_path", json_type_string, 256, true },
+    { "texture_path", json_type_string, 256, false },
+    { "room_name", json_type_string, 64, true },
+    { "offset", json_type_array, 3, false },
+    { "rotation", json_type_array, 3, false },
+    { "scale", json_type_array, 3, true },
+    { "mass", json_type_double, 0, false },
+    { "value", json_type_int, 0, false },
+    { "is_static", json_type_boolean, 0, false },
+    { NULL, json_type_null, 0, false }
+};
+
+static const FieldSchema light_schema[] = {
+    { "name", json_type_string, 50, true },
+    { "ambient", json_type_array, 4, false },
+    { "diffuse", json_type_array, 4, false },
+    { "specular", json_type_array, 4, false },
+    { "position", json_type_array, 4, false },
+    { "direction", json_type_array, 3, false },
+    { "cutoff", json_type_double, 0, false },
+    { "exponent", json_type_double, 0, false },
+    { "brightness", json_type_double, 0, false },
+    { "range", json_type_double, 0, false },
+    { "room", json_type_string, 64, false },
+    { NULL, json_type_null, 0, false }
+};
+
+static bool is_number(json_object* value) {
+    return json_object_is_type(value, json_type_double) || json_object_is_type(value, json_type_int);
+}
+
+static bool is_direction_name(const char* name) {
+    return strcmp(name, "north") == 0 || strcmp(name, "east") == 0
+        || strcmp(name, "south") == 0 || strcmp(name, "west") == 0;
+}
+
+static bool validate_connections(const char* filename, int index, json_object* connections) {
+    bool is_valid = true;
+    int count = json_object_array_length(connections);
+    for (int c = 0; c < count; c++) {
+        json_object* connection = json_object_array_get_idx(connections, c);
+        json_object* room = json_object_object_get(connection, "room");
+        json_object* dir = json_object_object_get(connection, "dir");
+        if (!json_object_is_type(room, json_type_string) || !json_object_is_type(dir, json_type_string)
+            || strlen(json_object_get_string(room)) >= 64 || !is_direction_name(json_object_get_string(dir))) {
+            printf("[ERROR] %s entry %d: connection %d needs a room name and a north, east, south or west dir\n",
+                filename, index, c);
+            is_valid = false;
+        }
+    }
+    return is_valid;
+}
+
+static bool validate_field(const char* filename, int index, json_object* item, const FieldSchema* field) {
+    json_object* value = json_object_object_get(item, field->name);
+    if (value == NULL) {
+        if (field->is_required) {
+            printf("[ERROR] %s entry %d: missing \"%s\"\n", filename, index, field->name);
+        }
+        return !field->is_required;
+    }
+
+    bool is_valid;
+    switch (field->type) {
+        case json_type_double:
+            is_valid = is_number(value);
+            break;
+        case json_type_string:
+            is_valid = json_object_is_type(value, json_type_string)
+                && (int)strlen(json_object_get_string(value)) < field->length;
+            break;
+        case json_type_array:
+            is_valid = json_object_is_type(value, json_type_array);
+            if (is_valid && strcmp(field->name, "connections") == 0) {
+                return validate_connections(filename, index, value);
+            }
+            is_valid = is_valid && (int)json_object_array_length(value) == field->length;
+            for (int i = 0; is_valid && i < field->length; i++) {
+                is_valid = is_number(json_object_array_get_idx(value, i));
+            }
+            break;
+        default:
+            is_valid = json_object_is_type(value, field->type);
+            break;
+    }
+
+    if (!is_valid) {
+        if (field->type == json_type_array) {
+            printf("[ERROR] %s entry %d: \"%s\" has to be %d numbers\n", filename, index, field->name, field->length);
+        }
+        else if (field->type == json_type_string) {
+            printf("[ERROR] %s entry %d: \"%s\" has to be a string shorter than %d characters\n",
+                filename, index, field->name, field->length);
+        }
+        else {
+            printf("[ERROR] %s entry %d: \"%s\" has to be a %s\n", filename, index, field->name,
+                json_type_to_name(field->type));
+        }
+    }
+    return is_valid;
+}
+
+bool validate_config(const char* filename, ConfigKind kind) {
+    const FieldSchema* schema = kind == CONFIG_ROOMS ? room_schema : kind == CONFIG_OBJECTS ? object_schema : light_schema;
+
     json_object* root = parse_json_file(filename);
     if (!root || !json_object_is_type(root, json_type_array)) {
+        printf("[ERROR] %s is not a JSON array\n", filename);
         if (root) json_object_put(root);
-        return;
+        return false;
+    }
+
+    bool is_valid = true;
+    int n = json_object_array_length(root);
+    // Rooms and objects are only limited by memory, the lights by the fixed-function slots.
+    if (kind == CONFIG_LIGHTS && n > MAX_LIGHTS) {
+        printf("[ERROR] %s has %d entries, at most %d are read\n", filename, n, MAX_LIGHTS);
+        is_valid = false;
+    }
+
+    for (int i = 0; i < n; i++) {
+        json_object* item = json_object_array_get_idx(root, i);
+        if (!json_object_is_type(item, json_type_object)) {
+            printf("[ERROR] %s entry %d is not an object\n", filename, i);
+            is_valid = false;
+            continue;
+        }
+
+        for (const FieldSchema* field = schema; field->name != NULL; field++) {
+            is_valid = validate_field(filename, i, item, field) && is_valid;
+        }
+        // Unknown fields are most likely typos of optional ones, which would silently keep their defaults.
+        json_object_object_foreach(item, key, value) {
+            (void)value;
+            const FieldSchema* field = schema;
+            while (field->name != NULL && strcmp(field->name, key) != 0) field++;
+            if (field->name == NULL) {
+                printf("[ERROR] %s entry %d: unknown field \"%s\"\n", filename, i, key);
+                is_valid = false;
+            }
+        }
+    }
+
+    json_object_put(root);
+    return is_valid;
+}
+
+RoomConfig* read_room_config(const char* filename, int* room_count) {
+    *room_count = 0;
+    json_object* root = parse_json_file(filename);
+    if (!root || !json_object_is_type(root, json_type_array)) {
+        if (root) json_object_put(root);
+        return NULL;
     }
 
     int n = json_object_array_length(root);
-    for (int i = 0; i < n && *room_count < MAX_ROOMS; i++) {
+    RoomConfig* room_configs = malloc((n > 0 ? n : 1) * sizeof(RoomConfig));
+    for (int i = 0; i < n; i++) {
         json_object* item = json_object_array_get_idx(root, i);
         RoomConfig cfg = {0};
 
@@ -142,17 +320,18 @@ void read_room_config(const char* filename, RoomConfig* room_configs, int* room_
     }
 
     json_object_put(root);
+    return room_configs;
 }
 
-void read_object_config(const char* filename, ObjectConfig* object_configs, int* object_count) {
+bool parse_object_config_tree(const char* filename, ObjectConfigHandler handler, void* user_data) {
     json_object* root = parse_json_file(filename);
     if (!root || !json_object_is_type(root, json_type_array)) {
         if (root) json_object_put(root);
-        return;
+        return false;
     }
 
     int n = json_object_array_length(root);
-    for (int i = 0; i < n && *object_count < MAX_OBJECTS; i++) {
+    for (int i = 0; i < n; i++) {
         json_object* item = json_object_array_get_idx(root, i);
         ObjectConfig cfg = {0};
 
@@ -169,10 +348,135 @@ void read_object_config(const char* filename, ObjectConfig* object_configs, int*
         cfg.value = json_get_int_field(item, "value", 0);
         cfg.is_static = json_get_bool_field(item, "is_static", false);
 
-        object_configs[(*object_count)++] = cfg;
+        if (!handler(&cfg, user_data)) break;
     }
 
     json_object_put(root);
+    return true;
+}
+
+/**
+ * Read the numbers of an array value into the vector, like the tree path it is kept only with at least count numbers.
+ */
+static bool stream_float_array(JsonStream* stream, JsonToken token, float* values, int count) {
+    if (token != JSON_TOKEN_ARRAY_BEGIN) return skip_json_value(stream, token);
+
+    float read[4] = { 0 };
+    int length = 0;
+    while ((token = next_json_token(stream)) != JSON_TOKEN_ARRAY_END) {
+        if (token == JSON_TOKEN_NUMBER && length < 4) {
+            read[length] = (float)stream->number;
+        }
+        else if (!skip_json_value(stream, token)) {
+            return false;
+        }
+        length++;
+    }
+    if (length >= count) {
+        memcpy(values, read, count * sizeof(float));
+    }
+    return true;
+}
+
+static bool stream_string(JsonStream* stream, JsonToken token, char* dest, size_t dest_size) {
+    if (token != JSON_TOKEN_STRING) return skip_json_value(stream, token);
+    // The token buffer is larger than the fields, long strings are cut like by the tree path.
+    size_t length = strnlen(stream->text, dest_size - 1);
+    memcpy(dest, stream->text, length);
+    dest[length] = '\0';
+    return true;
+}
+
+/**
+ * Read the fields of an object entry after its opening brace.
+ */
+static bool stream_object_entry(JsonStream* stream, ObjectConfig* cfg) {
+    JsonToken token;
+    while ((token = next_json_token(stream)) == JSON_TOKEN_KEY) {
+        char key[32];
+        strncpy(key, stream->text, sizeof(key) - 1);
+        key[sizeof(key) - 1] = '\0';
+
+        token = next_json_token(stream);
+        bool is_read;
+        if (strcmp(key, "name") == 0) is_read = stream_string(stream, token, cfg->name, sizeof(cfg->name));
+        else if (strcmp(key, "model_path") == 0) is_read = stream_string(stream, token, cfg->model_path, sizeof(cfg->model_path));
+        else if (strcmp(key, "texture_path") == 0) is_read = stream_string(stream, token, cfg->texture_path, sizeof(cfg->texture_path));
+        else if (strcmp(key, "room_name") == 0) is_read = stream_string(stream, token, cfg->room_name, sizeof(cfg->room_name));
+        else if (strcmp(key, "offset") == 0) is_read = stream_float_array(stream, token, &cfg->offset.x, 3);
+        else if (strcmp(key, "rotation") == 0) is_read = stream_float_array(stream, token, &cfg->rotation.x, 3);
+        else if (strcmp(key, "scale") == 0) is_read = stream_float_array(stream, token, &cfg->scale.x, 3);
+        else if (strcmp(key, "mass") == 0 && token == JSON_TOKEN_NUMBER) {
+            cfg->mass = (float)stream->number;
+            is_read = true;
+        }
+        else if (strcmp(key, "value") == 0 && token == JSON_TOKEN_NUMBER) {
+            cfg->value = (int)stream->number;
+            is_read = true;
+        }
+        else if (strcmp(key, "is_static") == 0 && (token == JSON_TOKEN_TRUE || token == JSON_TOKEN_FALSE)) {
+            cfg->is_static = token == JSON_TOKEN_TRUE;
+            is_read = true;
+        }
+        else is_read = skip_json_value(stream, token);
+
+        if (!is_read) return false;
+    }
+    return token == JSON_TOKEN_OBJECT_END;
+}
+
+bool stream_object_config(const char* filename, ObjectConfigHandler handler, void* user_data) {
+    JsonStream* stream = malloc(sizeof(JsonStream));
+    if (!open_json_stream(stream, filename)) {
+        printf("[ERROR] Cannot open %s\n", filename);
+        free(stream);
+        return false;
+    }
+    trace_begin("Stream JSON");
+
+    bool is_valid = next_json_token(stream) == JSON_TOKEN_ARRAY_BEGIN;
+    bool is_stopped = false;
+    JsonToken token;
+    while (is_valid && !is_stopped && (token = next_json_token(stream)) != JSON_TOKEN_ARRAY_END) {
+        // Like on the tree path, other array items are passed as entries with every field missing.
+        ObjectConfig cfg = {0};
+        is_valid = token == JSON_TOKEN_OBJECT_BEGIN ? stream_object_entry(stream, &cfg) : skip_json_value(stream, token);
+        is_stopped = is_valid && !handler(&cfg, user_data);
+    }
+    if (is_valid && !is_stopped) {
+        is_valid = next_json_token(stream) == JSON_TOKEN_END;
+    }
+    if (!is_valid) {
+        printf("[ERROR] %s is not an array of objects\n", filename);
+    }
+
+    close_json_stream(stream);
+    free(stream);
+    trace_end();
+    return is_valid;
+}
+
+typedef struct ObjectConfigArray {
+    ObjectConfig* configs;
+    int count;
+    int capacity;
+} ObjectConfigArray;
+
+static bool append_object_config(const ObjectConfig* config, void* user_data) {
+    ObjectConfigArray* array = user_data;
+    if (array->count == array->capacity) {
+        array->capacity *= 2;
+        array->configs = realloc(array->configs, array->capacity * sizeof(ObjectConfig));
+    }
+    array->configs[array->count++] = *config;
+    return true;
+}
+
+ObjectConfig* read_object_config(const char* filename, int* object_count) {
+    ObjectConfigArray array = { malloc(64 * sizeof(ObjectConfig)), 0, 64 };
+    stream_object_config(filename, append_object_config, &array);
+    *object_count = array.count;
+    return array.configs;
 }
 
 void read_light_config(const char* filename, Lighting* light_configs, int* light_count) {
@@ -183,6 +487,9 @@ void read_light_config(const char* filename, Lighting* light_configs, int* light
     }
 
     int n = json_object_array_length(root);
+    if (n > MAX_LIGHTS) {
+        printf("[WARNING] %s has %d lights, only the first %d are read\n", filename, n, MAX_LIGHTS);
+    }
     for (int i = 0; i < n && *light_count < MAX_LIGHTS; i++) {
         json_object* item = json_object_array_get_idx(root, i);
         Lighting cfg = {0};
@@ -192,6 +499,7 @@ void read_light_config(const char* filename, Lighting* light_configs, int* light
 
         json_get_string_field(item, "name", cfg.name, sizeof(cfg.name));
         cfg.brightness = json_get_float_field(item, "brightness", 1.0f);
+        cfg.range = json_get_float_field(item, "range", 0.0f);
 
         json_get_rgba_field(item, "ambient", &cfg.ambient);
         json_get_rgba_field(item, "diffuse", &cfg.diffuse);
@@ -219,6 +527,7 @@ void read_light_config(const char* filename, Lighting* light_configs, int* light
             
             cfg.cutoff = json_get_float_field(item, "cutoff", 30.0f);
             cfg.exponent = json_get_float_field(item, "exponent", 10.0f);
+            cfg.range = json_get_float_field(item, "range", 10.0f);
             
             cfg.position = (Vec4){0.0f, 0.0f, 0.0f, 1.0f};
         }
@@ -230,67 +539,52 @@ void read_light_config(const char* filename, Lighting* light_configs, int* light
 }
 
 char* read_manual(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
+    MappedFile file;
+    if (!map_file(&file, filename)) {
         printf("[ERROR] Cannot open manual file\n");
         return NULL;
     }
-    
-    char** lines = NULL;
+
+    // The lines are measured in place, so the padded text is the only allocation.
+    const char* data = file.data;
     int line_count = 0;
     size_t max_line_length = 0;
-    
-    char line_buffer[1024];
-    while (fgets(line_buffer, sizeof(line_buffer), file)) {
-        size_t len = strlen(line_buffer);
-        
-        if (len > 0 && line_buffer[len - 1] == '\n') {
-            line_buffer[len - 1] = '\0';
-            len--;
-        }
-        
-        if (len > max_line_length) {
-            max_line_length = len;
+    size_t line_start = 0;
+    for (size_t i = 0; i <= file.size; i++) {
+        if (i == file.size || data[i] == '\n') {
+            if (i == file.size && i == line_start) break;
+            size_t length = i - line_start;
+            if (length > max_line_length) max_line_length = length;
+            line_count++;
+            line_start = i + 1;
         }
-        
-        lines = realloc(lines, (line_count + 1) * sizeof(char*));
-        lines[line_count] = strdup(line_buffer);
-        line_count++;
     }
-    
-    size_t total_size = (max_line_length + 1) * line_count + 1;
-    
-    char* result = malloc(total_size);
+
+    char* result = malloc((max_line_length + 1) * line_count + 1);
     if (!result) {
-        for (int i = 0; i < line_count; i++) {
-            free(lines[i]);
-        }
-        free(lines);
-        fclose(file);
+        unmap_file(&file);
         return NULL;
     }
-    
+
+    // The lines are written from the last one, padded to the longest.
     char* current = result;
-    
-    for (int i = line_count - 1; i >= 0; i--) {
-        int line_len = strlen(lines[i]);
-        
-        strcpy(current, lines[i]);
-        current += line_len;
-        
-        for (size_t j = line_len; j < max_line_length; j++) {
-            *current++ = ' ';
-        }
-        
+    size_t line_end = file.size > 0 && data[file.size - 1] == '\n' ? file.size - 1 : file.size;
+    for (int i = 0; i < line_count; i++) {
+        size_t start = line_end;
+        while (start > 0 && data[start - 1] != '\n') start--;
+
+        size_t line_len = line_end - start;
+        memcpy(current, data + start, line_len);
+        memset(current + line_len, ' ', max_line_length - line_len);
+        current += max_line_length;
         *current++ = '\n';
-        
-        free(lines[i]);
+
+        line_end = start > 0 ? start - 1 : 0;
     }
-    
+
     *current = '\0';
-    
-    free(lines);
-    fclose(file);
+
+    unmap_file(&file);
     return result;
 }
 
@@ -401,6 +695,7 @@ void print_light_configs(Lighting* light_config, int light_config_count) {
                    config.direction.x, config.direction.y, config.direction.z);
             printf("  Cutoff: %.2f degrees\n", config.cutoff);
             printf("  Exponent: %.2f\n", config.exponent);
+            printf("  Range: %.2f\n", config.range);
             printf("  Room: %s\n", config.room_name);
         }
         
@@ -0,0 +1,387 @@
+#include "config_bundle.h"
+#include "bake.h"
+#include "name_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(BundleHeader) % 4 == 0 && sizeof(BundledRoom) % 4 == 0
+    && sizeof(BundledObject) % 4 == 0 && sizeof(BundledLight) % 4 == 0, "Bundle records keep 4 byte alignment");
+_Static_assert(sizeof(Vec3) == 12 && sizeof(Vec4) == 16 && sizeof(ColorRGBA) == 16, "Bundled vectors are packed floats");
+
+/**
+ * String table of the bundle being compiled, equal strings are stored once.
+ */
+typedef struct StringTable {
+    char* data;
+    uint32_t size;
+    uint32_t capacity;
+    NameIndex offsets;
+} StringTable;
+
+static uint32_t add_string(StringTable* table, const char* string) {
+    if (string[0] == '\0') return 0;
+
+    int offset = find_name(&table->offsets, string);
+    if (offset >= 0) return (uint32_t)offset;
+
+    uint32_t length = (uint32_t)strlen(string) + 1;
+    while (table->size + length > table->capacity) {
+        table->capacity *= 2;
+        table->data = realloc(table->data, table->capacity);
+    }
+    memcpy(table->data + table->size, string, length);
+    offset = (int)table->size;
+    table->size += length;
+
+    // The name is kept by the config arrays, which outlive the table.
+    add_name(&table->offsets, string, offset);
+    return (uint32_t)offset;
+}
+
+static bool check_unique_names(const char* filename, const char* names, size_t stride, int count, NameIndex* index) {
+    bool is_valid = true;
+    init_name_index(index, count);
+    for (int i = 0; i < count; i++) {
+        const char* name = names + i * stride;
+        if (find_name(index, name) >= 0) {
+            printf("[ERROR] %s entry %d: the name \"%s\" is already used\n", filename, i, name);
+            is_valid = false;
+        }
+        add_name(index, name, i);
+    }
+    return is_valid;
+}
+
+static bool check_room_reference(const char* filename, int entry, const char* room_name, const NameIndex* rooms) {
+    if (find_name(rooms, room_name) >= 0) return true;
+    printf("[ERROR] %s entry %d: there is no room named \"%s\"\n", filename, entry, room_name);
+    return false;
+}
+
+/**
+ * Check what the schema cannot: unique names and rooms referenced by connections, objects and spotlights.
+ */
+static bool check_references(const char* room_config_path, const RoomConfig* room_configs, int room_count,
+    const char* object_config_path, const ObjectConfig* object_configs, int object_count,
+    const char* light_config_path, const Lighting* light_configs, int light_count) {
+    NameIndex rooms, objects, lights;
+    bool is_valid = check_unique_names(room_config_path, room_configs[0].name, sizeof(RoomConfig), room_count, &rooms);
+    is_valid = check_unique_names(object_config_path, object_configs[0].name, sizeof(ObjectConfig), object_count, &objects)
+        && is_valid;
+    is_valid = check_unique_names(light_config_path, light_configs[0].name, sizeof(Lighting), light_count, &lights)
+        && is_valid;
+
+    for (int i = 0; i < room_count; i++) {
+        for (int d = 0; d < DIR_COUNT; d++) {
+            const char* peer = room_configs[i].connections[d].room;
+            if (peer[0] != '\0') {
+                is_valid = check_room_reference(room_config_path, i, peer, &rooms) && is_valid;
+            }
+        }
+    }
+    for (int i = 0; i < object_count; i++) {
+        is_valid = check_room_reference(object_config_path, i, object_configs[i].room_name, &rooms) && is_valid;
+    }
+    for (int i = 0; i < light_count; i++) {
+        if (light_configs[i].is_spotlight) {
+            is_valid = check_room_reference(light_config_path, i, light_configs[i].room_name, &rooms) && is_valid;
+        }
+    }
+
+    free_name_index(&rooms);
+    free_name_index(&objects);
+    free_name_index(&lights);
+    return is_valid;
+}
+
+static void bundle_room(const RoomConfig* config, BundledRoom* record, StringTable* strings) {
+    memset(record, 0, sizeof(BundledRoom));
+    record->name = add_string(strings, config->name);
+    record->floor_tex_path = add_string(strings, config->floor_tex_path);
+    record->ceiling_tex_path = add_string(strings, config->ceiling_tex_path);
+    record->wall_tex_path = add_string(strings, config->wall_tex_path);
+    for (int d = 0; d < DIR_COUNT; d++) {
+        record->connections[d] = add_string(strings, config->connections[d].room);
+    }
+    record->connection_count = config->connection_count;
+    memcpy(record->dimension, &config->dimension, sizeof(record->dimension));
+}
+
+static void bundle_object(const ObjectConfig* config, BundledObject* record, StringTable* strings) {
+    memset(record, 0, sizeof(BundledObject));
+    record->name = add_string(strings, config->name);
+    record->model_path = add_string(strings, config->model_path);
+    record->texture_path = add_string(strings, config->texture_path);
+    record->room_name = add_string(strings, config->room_name);
+    memcpy(record->offset, &config->offset, sizeof(record->offset));
+    memcpy(record->rotation, &config->rotation, sizeof(record->rotation));
+    memcpy(record->scale, &config->scale, sizeof(record->scale));
+    record->mass = config->mass;
+    record->value = config->value;
+    record->is_static = config->is_static;
+}
+
+static void bundle_light(const Lighting* config, BundledLight* record, StringTable* strings) {
+    memset(record, 0, sizeof(BundledLight));
+    record->name = add_string(strings, config->name);
+    record->room_name = add_string(strings, config->room_name);
+    memcpy(record->ambient, &config->ambient, sizeof(record->ambient));
+    memcpy(record->diffuse, &config->diffuse, sizeof(record->diffuse));
+    memcpy(record->specular, &config->specular, sizeof(record->specular));
+    memcpy(record->position, &config->position, sizeof(record->position));
+    memcpy(record->direction, &config->direction, sizeof(record->direction));
+    record->cutoff = config->cutoff;
+    record->exponent = config->exponent;
+    record->brightness = config->brightness;
+    record->range = config->range;
+    record->is_spotlight = config->is_spotlight;
+}
+
+static bool get_source_stamp(const char* path, BundleSource* source) {
+    struct stat info;
+    if (stat(path, &info) != 0) return false;
+    source->size = (int64_t)info.st_size;
+    source->mtime = (int64_t)info.st_mtime;
+    return true;
+}
+
+/**
+ * Check the references between the configs, then write their records and strings to the bundle.
+ */
+static bool write_config_bundle(const char* room_config_path, const RoomConfig* room_configs, int room_count,
+    const char* object_config_path, const ObjectConfig* object_configs, int object_count,
+    const char* light_config_path, const Lighting* light_configs, int light_count) {
+    if (!check_references(room_config_path, room_configs, room_count, object_config_path, object_configs, object_count,
+            light_config_path, light_configs, light_count)) {
+        printf("[ERROR] The configs are invalid, %s is not written\n", CONFIG_BUNDLE_PATH);
+        return false;
+    }
+
+    BundleHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_BUNDLE_MAGIC;
+    header.version = CONFIG_BUNDLE_VERSION;
+    if (!get_source_stamp(room_config_path, &header.sources[CONFIG_ROOMS])
+        || !get_source_stamp(object_config_path, &header.sources[CONFIG_OBJECTS])
+        || !get_source_stamp(light_config_path, &header.sources[CONFIG_LIGHTS])) {
+        printf("[WARNING] Cannot stat the config files\n");
+        return false;
+    }
+
+    BundledRoom* rooms = calloc(room_count > 0 ? room_count : 1, sizeof(BundledRoom));
+    BundledObject* objects = calloc(object_count > 0 ? object_count : 1, sizeof(BundledObject));
+    BundledLight lights[MAX_LIGHTS];
+    StringTable strings = { malloc(4096), 1, 4096, { 0 } };
+    strings.data[0] = '\0';
+    init_name_index(&strings.offsets, room_count * (4 + DIR_COUNT) + object_count * 4 + light_count * 2);
+    for (int i = 0; i < room_count; i++) bundle_room(&room_configs[i], &rooms[i], &strings);
+    for (int i = 0; i < object_count; i++) bundle_object(&object_configs[i], &objects[i], &strings);
+    for (int i = 0; i < light_count; i++) bundle_light(&light_configs[i], &lights[i], &strings);
+
+    header.room_offset = sizeof(BundleHeader);
+    header.room_count = (uint32_t)room_count;
+    header.object_offset = header.room_offset + room_count * sizeof(BundledRoom);
+    header.object_count = (uint32_t)object_count;
+    header.light_offset = header.object_offset + object_count * sizeof(BundledObject);
+    header.light_count = (uint32_t)light_count;
+    header.string_offset = header.light_offset + light_count * sizeof(BundledLight);
+    header.string_size = strings.size;
+
+    char temp_path[sizeof(CONFIG_BUNDLE_PATH) + 4];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", CONFIG_BUNDLE_PATH);
+    make_baked_directory();
+
+    bool is_written = false;
+    FILE* file = fopen(temp_path, "wb");
+    if (file != NULL) {
+        is_written = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(rooms, sizeof(BundledRoom), room_count, file) == (size_t)room_count
+            && fwrite(objects, sizeof(BundledObject), object_count, file) == (size_t)object_count
+            && fwrite(lights, sizeof(BundledLight), light_count, file) == (size_t)light_count
+            && fwrite(strings.data, 1, strings.size, file) == strings.size;
+        is_written = fclose(file) == 0 && is_written;
+    }
+    free(rooms);
+    free(objects);
+    free(strings.data);
+    free_name_index(&strings.offsets);
+    if (!replace_baked_file(temp_path, CONFIG_BUNDLE_PATH, is_written)) return false;
+
+    printf("[INFO] Compiled %d rooms, %d objects and %d lights into %s (%u bytes)\n", room_count, object_count,
+        light_count, CONFIG_BUNDLE_PATH, header.string_offset + header.string_size);
+    return true;
+}
+
+bool compile_config_bundle(const char* room_config_path, const char* object_config_path, const char* light_config_path) {
+    static Lighting light_configs[MAX_LIGHTS];
+
+    bool is_valid = validate_config(room_config_path, CONFIG_ROOMS);
+    is_valid = validate_config(object_config_path, CONFIG_OBJECTS) && is_valid;
+    is_valid = validate_config(light_config_path, CONFIG_LIGHTS) && is_valid;
+    if (!is_valid) {
+        printf("[ERROR] The configs are invalid, %s is not written\n", CONFIG_BUNDLE_PATH);
+        return false;
+    }
+
+    // The records are built by the same readers the game falls back to, so both ways give the same configs.
+    int room_count = 0, object_count = 0, light_count = 0;
+    RoomConfig* room_configs = read_room_config(room_config_path, &room_count);
+    ObjectConfig* object_configs = read_object_config(object_config_path, &object_count);
+    read_light_config(light_config_path, light_configs, &light_count);
+    bool is_written = write_config_bundle(room_config_path, room_configs, room_count, object_config_path,
+        object_configs, object_count, light_config_path, light_configs, light_count);
+    free(room_configs);
+    free(object_configs);
+    return is_written;
+}
+
+static bool is_source_current(const char* path, const BundleSource* source) {
+    BundleSource current;
+    if (!get_source_stamp(path, &current)) return true;
+    return current.size == source->size && current.mtime == source->mtime;
+}
+
+static bool is_range_in_file(uint32_t offset, uint32_t count, size_t record_size, size_t file_size) {
+    return offset % 4 == 0 && (uint64_t)offset + (uint64_t)count * record_size <= file_size;
+}
+
+/**
+ * Every string offset of the records has to point into the table, which has to end with a terminator.
+ */
+static bool are_strings_valid(const ConfigBundle* bundle) {
+    const BundleHeader* header = bundle->header;
+    uint32_t size = header->string_size;
+    if (size == 0 || bundle->strings[size - 1] != '\0') return false;
+
+    bool is_valid = true;
+    for (uint32_t i = 0; i < header->room_count; i++) {
+        const BundledRoom* room = &bundle->rooms[i];
+        is_valid = is_valid && room->name < size && room->floor_tex_path < size
+            && room->ceiling_tex_path < size && room->wall_tex_path < size;
+        for (int d = 0; d < DIR_COUNT; d++) {
+            is_valid = is_valid && room->connections[d] < size;
+        }
+    }
+    for (uint32_t i = 0; i < header->object_count; i++) {
+        const BundledObject* object = &bundle->objects[i];
+        is_valid = is_valid && object->name < size && object->model_path < size
+            && object->texture_path < size && object->room_name < size;
+    }
+    for (uint32_t i = 0; i < header->light_count; i++) {
+        is_valid = is_valid && bundle->lights[i].name < size && bundle->lights[i].room_name < size;
+    }
+    return is_valid;
+}
+
+bool open_config_bundle(ConfigBundle* bundle, const char* room_config_path, const char* object_config_path,
+    const char* light_config_path) {
+    memset(bundle, 0, sizeof(ConfigBundle));
+    if (!map_file(&bundle->file, CONFIG_BUNDLE_PATH)) return false;
+
+    const BundleHeader* header = bundle->file.data;
+    size_t size = bundle->file.size;
+    if (size < sizeof(BundleHeader) || header->magic != CONFIG_BUNDLE_MAGIC || header->version != CONFIG_BUNDLE_VERSION
+        || !is_source_current(room_config_path, &header->sources[CONFIG_ROOMS])
+        || !is_source_current(object_config_path, &header->sources[CONFIG_OBJECTS])
+        || !is_source_current(light_config_path, &header->sources[CONFIG_LIGHTS])) {
+        printf("[INFO] %s is out of date, reading the JSON configs\n", CONFIG_BUNDLE_PATH);
+        close_config_bundle(bundle);
+        return false;
+    }
+
+    if (header->light_count > MAX_LIGHTS
+        || !is_range_in_file(header->room_offset, header->room_count, sizeof(BundledRoom), size)
+        || !is_range_in_file(header->object_offset, header->object_count, sizeof(BundledObject), size)
+        || !is_range_in_file(header->light_offset, header->light_count, sizeof(BundledLight), size)
+        || !is_range_in_file(header->string_offset, header->string_size, 1, size)) {
+        printf("[WARNING] %s is truncated, reading the JSON configs\n", CONFIG_BUNDLE_PATH);
+        close_config_bundle(bundle);
+        return false;
+    }
+
+    const char* data = bundle->file.data;
+    bundle->header = header;
+    bundle->rooms = (const BundledRoom*)(data + header->room_offset);
+    bundle->objects = (const BundledObject*)(data + header->object_offset);
+    bundle->lights = (const BundledLight*)(data + header->light_offset);
+    bundle->strings = data + header->string_offset;
+    if (!are_strings_valid(bundle)) {
+        printf("[WARNING] %s has a broken string table, reading the JSON configs\n", CONFIG_BUNDLE_PATH);
+        close_config_bundle(bundle);
+        return false;
+    }
+    return true;
+}
+
+static void copy_string(const ConfigBundle* bundle, uint32_t offset, char* dest, size_t dest_size) {
+    strncpy(dest, bundle->strings + offset, dest_size - 1);
+    dest[dest_size - 1] = '\0';
+}
+
+void read_bundled_room_config(const ConfigBundle* bundle, RoomConfig* room_configs, int* room_count) {
+    for (uint32_t i = 0; i < bundle->header->room_count; i++) {
+        const BundledRoom* record = &bundle->rooms[i];
+        RoomConfig* cfg = &room_configs[(*room_count)++];
+        memset(cfg, 0, sizeof(RoomConfig));
+
+        copy_string(bundle, record->name, cfg->name, sizeof(cfg->name));
+        copy_string(bundle, record->floor_tex_path, cfg->floor_tex_path, sizeof(cfg->floor_tex_path));
+        copy_string(bundle, record->ceiling_tex_path, cfg->ceiling_tex_path, sizeof(cfg->ceiling_tex_path));
+        copy_string(bundle, record->wall_tex_path, cfg->wall_tex_path, sizeof(cfg->wall_tex_path));
+        for (int d = 0; d < DIR_COUNT; d++) {
+            copy_string(bundle, record->connections[d], cfg->connections[d].room, sizeof(cfg->connections[d].room));
+            cfg->connections[d].dir = d;
+        }
+        cfg->connection_count = record->connection_count;
+        memcpy(&cfg->dimension, record->dimension, sizeof(record->dimension));
+    }
+}
+
+void read_bundled_object_config(const ConfigBundle* bundle, ObjectConfig* object_configs, int* object_count) {
+    for (uint32_t i = 0; i < bundle->header->object_count; i++) {
+        const BundledObject* record = &bundle->objects[i];
+        ObjectConfig* cfg = &object_configs[(*object_count)++];
+        memset(cfg, 0, sizeof(ObjectConfig));
+
+        copy_string(bundle, record->name, cfg->name, sizeof(cfg->name));
+        copy_string(bundle, record->model_path, cfg->model_path, sizeof(cfg->model_path));
+        copy_string(bundle, record->texture_path, cfg->texture_path, sizeof(cfg->texture_path));
+        copy_string(bundle, record->room_name, cfg->room_name, sizeof(cfg->room_name));
+        memcpy(&cfg->offset, record->offset, sizeof(record->offset));
+        memcpy(&cfg->rotation, record->rotation, sizeof(record->rotation));
+        memcpy(&cfg->scale, record->scale, sizeof(record->scale));
+        cfg->mass = record->mass;
+        cfg->value = record->value;
+        cfg->is_static = record->is_static != 0;
+    }
+}
+
+void read_bundled_light_config(const ConfigBundle* bundle, Lighting* light_configs, int* light_count) {
+    for (uint32_t i = 0; i < bundle->header->light_count && *light_count < MAX_LIGHTS; i++) {
+        const BundledLight* record = &bundle->lights[i];
+        Lighting* cfg = &light_configs[(*light_count)++];
+        memset(cfg, 0, sizeof(Lighting));
+
+        cfg->enabled = true;
+        cfg->slot = -1;
+        copy_string(bundle, record->name, cfg->name, sizeof(cfg->name));
+        copy_string(bundle, record->room_name, cfg->room_name, sizeof(cfg->room_name));
+        memcpy(&cfg->ambient, record->ambient, sizeof(record->ambient));
+        memcpy(&cfg->diffuse, record->diffuse, sizeof(record->diffuse));
+        memcpy(&cfg->specular, record->specular, sizeof(record->specular));
+        memcpy(&cfg->position, record->position, sizeof(record->position));
+        memcpy(&cfg->direction, record->direction, sizeof(record->direction));
+        cfg->cutoff = record->cutoff;
+        cfg->exponent = record->exponent;
+        cfg->brightness = record->brightness;
+        cfg->range = record->range;
+        cfg->is_spotlight = record->is_spotlight != 0;
+    }
+}
+
+void close_config_bundle(ConfigBundle* bundle) {
+    unmap_file(&bundle->file);
+    memset(bundle, 0, sizeof(ConfigBundle));
+}
@@ -0,0 +1,121 @@
+#include "dds.h"
+#include "dxt.h"
+#include "filemap.h"
+#include "gl_loader.h"
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(DdsHeader) == 124, "The DDS header is 124 bytes");
+
+// "DDS " read as a little endian integer.
+#define DDS_MAGIC 0x20534444u
+
+#define DDS_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define DDSD_CAPS 0x1u
+#define DDSD_HEIGHT 0x2u
+#define DDSD_WIDTH 0x4u
+#define DDSD_PIXELFORMAT 0x1000u
+#define DDSD_MIPMAPCOUNT 0x20000u
+#define DDSD_LINEARSIZE 0x80000u
+#define DDPF_FOURCC 0x4u
+#define DDSCAPS_COMPLEX 0x8u
+#define DDSCAPS_TEXTURE 0x1000u
+#define DDSCAPS_MIPMAP 0x400000u
+
+static GLenum get_dds_format(uint32_t four_cc) {
+    if (four_cc == DDS_FOURCC('D', 'X', 'T', '1')) return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (four_cc == DDS_FOURCC('D', 'X', 'T', '3')) return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    if (four_cc == DDS_FOURCC('D', 'X', 'T', '5')) return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    return 0;
+}
+
+static uint32_t get_dds_four_cc(GLenum format) {
+    if (format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT) return DDS_FOURCC('D', 'X', 'T', '3');
+    if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) return DDS_FOURCC('D', 'X', 'T', '5');
+    return DDS_FOURCC('D', 'X', 'T', '1');
+}
+
+bool read_dds(const char* path, TextureImage* image, uint32_t* tag) {
+    memset(image, 0, sizeof(TextureImage));
+
+    MappedFile file;
+    if (!map_file(&file, path)) return false;
+
+    const unsigned char* data = file.data;
+    DdsHeader header;
+    if (file.size < 4 + sizeof(DdsHeader) || *(const uint32_t*)data != DDS_MAGIC) {
+        printf("[WARNING] %s is not a DDS file\n", path);
+        unmap_file(&file);
+        return false;
+    }
+    memcpy(&header, data + 4, sizeof(DdsHeader));
+
+    GLenum format = (header.pixel_format.flags & DDPF_FOURCC) ? get_dds_format(header.pixel_format.four_cc) : 0;
+    if (header.size != sizeof(DdsHeader) || format == 0 || header.width == 0 || header.height == 0) {
+        printf("[WARNING] %s is not a DXT1, DXT3 or DXT5 texture\n", path);
+        unmap_file(&file);
+        return false;
+    }
+
+    image->width = (int)header.width;
+    image->height = (int)header.height;
+    image->format = format;
+    image->is_compressed = true;
+    image->level_count = header.mipmap_count > 0 ? (int)header.mipmap_count : 1;
+    if (image->level_count > MAX_TEXTURE_LEVELS) image->level_count = MAX_TEXTURE_LEVELS;
+
+    size_t total_size = 0;
+    int width = image->width, height = image->height;
+    for (int i = 0; i < image->level_count; i++) {
+        image->level_sizes[i] = get_compressed_level_size(format, width, height);
+        total_size += image->level_sizes[i];
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    if (4 + sizeof(DdsHeader) + total_size > file.size) {
+        printf("[WARNING] DDS file %s is truncated\n", path);
+        unmap_file(&file);
+        return false;
+    }
+
+    // Copied on the loader thread, so the upload does not fault the pages in on the main thread.
+    image->pixels = malloc(total_size);
+    memcpy(image->pixels, data + 4 + sizeof(DdsHeader), total_size);
+    if (tag != NULL) {
+        memcpy(tag, header.tag, sizeof(header.tag));
+    }
+
+    unmap_file(&file);
+    return true;
+}
+
+bool write_dds(FILE* file, const TextureImage* image, const uint32_t* tag) {
+    if (!image->is_compressed || image->pixels == NULL) return false;
+
+    DdsHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = sizeof(DdsHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = (uint32_t)image->height;
+    header.width = (uint32_t)image->width;
+    header.linear_size = (uint32_t)image->level_sizes[0];
+    header.mipmap_count = (uint32_t)image->level_count;
+    if (tag != NULL) {
+        memcpy(header.tag, tag, sizeof(header.tag));
+    }
+    header.pixel_format.size = sizeof(DdsPixelFormat);
+    header.pixel_format.flags = DDPF_FOURCC;
+    header.pixel_format.four_cc = get_dds_four_cc(image->format);
+    header.caps[0] = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    size_t total_size = 0;
+    for (int i = 0; i < image->level_count; i++) {
+        total_size += image->level_sizes[i];
+    }
+
+    uint32_t magic = DDS_MAGIC;
+    return fwrite(&magic, sizeof(magic), 1, file) == 1
+        && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(image->pixels, 1, total_size, file) == total_size;
+}
@@ -2,6 +2,7 @@
 #include "app.h"
 #include "scene.h"
 #include "physics.h"
+#include "profiler.h"
 #include <string.h>
 
 void draw_crosshair(App* app) {
@@ -94,6 +95,8 @@ void draw_extraction_status(const Scene* scene) {
 
     float text_width = strlen(status_text) * 0.5f;
     draw_string(extraction->font_texture_id, status_text, -text_width * 0.5f, 0.0f, 1.0f);
+    profiler.stats.draw_calls++;
+    profiler.stats.texture_binds++;
 
     glPopMatrix();
     glPopAttrib();
@@ -153,210 +156,19 @@ void draw_textured_quad(float normal[3], float tex_coords[4][2], float vertices[
     glEnd();
 }
 
-void draw_room(Room* room, Scene* scene) {
-    float w = room->dimension.x * 0.5f;
-    float l = room->dimension.y * 0.5f;
-    float h = room->dimension.z;
-    float px = room->position.x;
-    float py = room->position.y;
-    float pz = room->position.z;
-
-    float door_h = room->door_height;
-    float half_w = w * 0.5f;
-    float half_d = room->door_width * 0.5f;
-
-    float v1 = door_h / h;
-    float u1, u2;
-
-    float normal_z[3] = { 0, 0, 1 };
-    float solid_uv[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
-    float top_uv[4][2] = { {0, v1}, {1, v1}, {1, 1}, {0, 1} };
-
-    glBindTexture(GL_TEXTURE_2D, room->floor_tex);
-    draw_textured_quad(
-        normal_z, solid_uv,
-        (float[4][3]) {
-            { px - w, py - l, pz },
-            { px + w, py - l, pz },
-            { px + w, py + l, pz },
-            { px - w, py + l, pz }
-    }
-    );
-
-    glBindTexture(GL_TEXTURE_2D, room->ceiling_tex);
-    draw_textured_quad(
-        normal_z, solid_uv,
-        (float[4][3]) {
-            { px - w, py - l, pz + h },
-            { px + w, py - l, pz + h },
-            { px + w, py + l, pz + h },
-            { px - w, py + l, pz + h }
-    }
-    );
+int draw_room(Room* room, Scene* scene) {
+    RoomQuad quads[MAX_ROOM_QUADS];
+    int quad_count = build_room_quads(room, scene, quads);
+    int bind_count = 0;
 
-    glBindTexture(GL_TEXTURE_2D, room->wall_tex);
-    for (int d = 0; d < DIR_COUNT; d++) {
-        if (room->connections[d].room[0] == '\0') {
-            float vertices[4][3];
-
-            switch (d) {
-            case DIR_NORTH:
-                memcpy(vertices, (float[4][3]) {
-                    { px - w, py + l, pz },
-                    { px + w, py + l, pz },
-                    { px + w, py + l, pz + h },
-                    { px - w, py + l, pz + h }
-                }, sizeof(vertices));
-                break;
-            case DIR_EAST:
-                memcpy(vertices, (float[4][3]) {
-                    { px + w, py - l, pz },
-                    { px + w, py + l, pz },
-                    { px + w, py + l, pz + h },
-                    { px + w, py - l, pz + h }
-                }, sizeof(vertices));
-                break;
-            case DIR_SOUTH:
-                memcpy(vertices, (float[4][3]) {
-                    { px + w, py - l, pz },
-                    { px - w, py - l, pz },
-                    { px - w, py - l, pz + h },
-                    { px + w, py - l, pz + h }
-                }, sizeof(vertices));
-                break;
-            case DIR_WEST:
-                memcpy(vertices, (float[4][3]) {
-                    { px - w, py + l, pz },
-                    { px - w, py - l, pz },
-                    { px - w, py - l, pz + h },
-                    { px - w, py + l, pz + h }
-                }, sizeof(vertices));
-                break;
-            }
-
-            draw_textured_quad(normal_z, solid_uv, vertices);
-        }
-        else {
-            int neighbor_idx = room->connections[d].id;
-            if (neighbor_idx < 0 || neighbor_idx >= scene->room_count) continue;
-
-            Room* neighbor_room = &scene->rooms[neighbor_idx];
-            if (!needs_connector(room, neighbor_room, d)) continue;
-
-            if (d == DIR_NORTH || d == DIR_SOUTH) {
-                u1 = (half_w - half_d) / w;
-                u2 = (half_w + half_d) / w;
-            }
-            else {
-                u1 = (l - half_d) / (2 * l);
-                u2 = (l + half_d) / (2 * l);
-            }
-
-            float left_uv[4][2] = { {0, 0}, {u1, 0}, {u1, v1}, {0, v1} };
-            float right_uv[4][2] = { {u2, 0}, {1, 0}, {1, v1}, {u2, v1} };
-            float top_vertices[4][3];
-            float left_vertices[4][3];
-            float right_vertices[4][3];
-
-            switch (d) {
-            case DIR_NORTH:
-                memcpy(top_vertices, (float[4][3]) {
-                    { px - w, py + l, pz + door_h },
-                    { px + w, py + l, pz + door_h },
-                    { px + w, py + l, pz + h },
-                    { px - w, py + l, pz + h }
-                }, sizeof(top_vertices));
-
-                memcpy(left_vertices, (float[4][3]) {
-                    { px - w, py + l, pz },
-                    { px - half_d, py + l, pz },
-                    { px - half_d, py + l, pz + door_h },
-                    { px - w, py + l, pz + door_h }
-                }, sizeof(left_vertices));
-
-                memcpy(right_vertices, (float[4][3]) {
-                    { px + half_d, py + l, pz },
-                    { px + w, py + l, pz },
-                    { px + w, py + l, pz + door_h },
-                    { px + half_d, py + l, pz + door_h }
-                }, sizeof(right_vertices));
-                break;
-
-            case DIR_EAST:
-                memcpy(top_vertices, (float[4][3]) {
-                    { px + w, py - l, pz + door_h },
-                    { px + w, py + l, pz + door_h },
-                    { px + w, py + l, pz + h },
-                    { px + w, py - l, pz + h }
-                }, sizeof(top_vertices));
-
-                memcpy(left_vertices, (float[4][3]) {
-                    { px + w, py - l, pz },
-                    { px + w, py - half_d, pz },
-                    { px + w, py - half_d, pz + door_h },
-                    { px + w, py - l, pz + door_h }
-                }, sizeof(left_vertices));
-
-                memcpy(right_vertices, (float[4][3]) {
-                    { px + w, py + half_d, pz },
-                    { px + w, py + l, pz },
-                    { px + w, py + l, pz + door_h },
-                    { px + w, py + half_d, pz + door_h }
-                }, sizeof(right_vertices));
-                break;
-
-            case DIR_SOUTH:
-                memcpy(top_vertices, (float[4][3]) {
-                    { px + w, py - l, pz + door_h },
-                    { px - w, py - l, pz + door_h },
-                    { px - w, py - l, pz + h },
-                    { px + w, py - l, pz + h }
-                }, sizeof(top_vertices));
-
-                memcpy(left_vertices, (float[4][3]) {
-                    { px + w, py - l, pz },
-                    { px + half_d, py - l, pz },
-                    { px + half_d, py - l, pz + door_h },
-                    { px + w, py - l, pz + door_h }
-                }, sizeof(left_vertices));
-
-                memcpy(right_vertices, (float[4][3]) {
-                    { px - half_d, py - l, pz },
-                    { px - w, py - l, pz },
-                    { px - w, py - l, pz + door_h },
-                    { px - half_d, py - l, pz + door_h }
-                }, sizeof(right_vertices));
-                break;
-
-            case DIR_WEST:
-                memcpy(top_vertices, (float[4][3]) {
-                    { px - w, py + l, pz + door_h },
-                    { px - w, py - l, pz + door_h },
-                    { px - w, py - l, pz + h },
-                    { px - w, py + l, pz + h }
-                }, sizeof(top_vertices));
-
-                memcpy(left_vertices, (float[4][3]) {
-                    { px - w, py + l, pz },
-                    { px - w, py + half_d, pz },
-                    { px - w, py + half_d, pz + door_h },
-                    { px - w, py + l, pz + door_h }
-                }, sizeof(left_vertices));
-
-                memcpy(right_vertices, (float[4][3]) {
-                    { px - w, py - half_d, pz },
-                    { px - w, py - l, pz },
-                    { px - w, py - l, pz + door_h },
-                    { px - w, py - half_d, pz + door_h }
-                }, sizeof(right_vertices));
-                break;
-            }
-
-            draw_textured_quad(normal_z, top_uv, top_vertices);
-            draw_textured_quad(normal_z, left_uv, left_vertices);
-            draw_textured_quad(normal_z, right_uv, right_vertices);
+    for (int i = 0; i < quad_count; i++) {
+        if (i == 0 || quads[i].texture != quads[i - 1].texture) {
+            glBindTexture(GL_TEXTURE_2D, quads[i].texture);
+            bind_count++;
         }
+        draw_textured_quad(quads[i].normal, quads[i].uv, quads[i].vertices);
     }
+    return bind_count;
 }
 
 void draw_bounding_box(PhysicsBody* pb) {
@@ -384,6 +196,34 @@ void draw_bounding_box(PhysicsBody* pb) {
     glLineWidth(1.0f);
 }
 
+void draw_placeholder_box(Vec3 position, float half_size) {
+    // Corner i has its x, y and z at the upper side for bits 0, 1 and 2, the faces wind counter-clockwise.
+    static const int F[6][4] = {
+        {1,3,7,5}, {0,4,6,2},
+        {2,6,7,3}, {0,1,5,4},
+        {4,5,7,6}, {0,2,3,1}
+    };
+    static const float N[6][3] = {
+        {1,0,0}, {-1,0,0},
+        {0,1,0}, {0,-1,0},
+        {0,0,1}, {0,0,-1}
+    };
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBegin(GL_QUADS);
+    for (int f = 0; f < 6; ++f) {
+        glNormal3fv(N[f]);
+        for (int c = 0; c < 4; ++c) {
+            int i = F[f][c];
+            glVertex3f(
+                position.x + ((i & 1) ? half_size : -half_size),
+                position.y + ((i & 2) ? half_size : -half_size),
+                position.z + ((i & 4) ? 2.0f * half_size : 0.0f));
+        }
+    }
+    glEnd();
+}
+
 void draw_origin(float size) {
     glBegin(GL_LINES);
 
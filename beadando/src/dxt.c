@@ -0,0 +1,247 @@
+#include "dxt.h"
+#include "gl_loader.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t get_compressed_level_size(GLenum format, int width, int height) {
+    size_t block_size = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+    size_t blocks_x = (size_t)(width + 3) / 4;
+    size_t blocks_y = (size_t)(height + 3) / 4;
+    return (blocks_x > 0 ? blocks_x : 1) * (blocks_y > 0 ? blocks_y : 1) * block_size;
+}
+
+static uint16_t pack_565(const int* color) {
+    return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void unpack_565(uint16_t packed, int* color) {
+    color[0] = ((packed >> 11) & 31) * 255 / 31;
+    color[1] = ((packed >> 5) & 63) * 255 / 63;
+    color[2] = (packed & 31) * 255 / 31;
+}
+
+/**
+ * Copy the 4x4 RGBA block at the block coordinates, repeating the last row and column past the edges.
+ */
+static void fetch_block(const unsigned char* pixels, int width, int height, int block_x, int block_y,
+    unsigned char block[16][4]) {
+    for (int y = 0; y < 4; y++) {
+        int row = block_y * 4 + y < height ? block_y * 4 + y : height - 1;
+        for (int x = 0; x < 4; x++) {
+            int column = block_x * 4 + x < width ? block_x * 4 + x : width - 1;
+            memcpy(block[y * 4 + x], pixels + ((size_t)row * width + column) * 4, 4);
+        }
+    }
+}
+
+static void write_le(unsigned char* target, uint64_t value, int byte_count) {
+    for (int i = 0; i < byte_count; i++) {
+        target[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+/**
+ * Encode the colours of a block between two corners of their bounding box.
+ * The corners are chosen along the diagonal that follows the correlation of the channels with green.
+ */
+static void encode_color_block(unsigned char block[16][4], unsigned char* target) {
+    int low[3] = { 255, 255, 255 };
+    int high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            if (block[i][c] < low[c]) low[c] = block[i][c];
+            if (block[i][c] > high[c]) high[c] = block[i][c];
+        }
+    }
+
+    // The extremes are rarely hit exactly, pulling the corners in by a sixteenth lowers the average error.
+    for (int c = 0; c < 3; c++) {
+        int inset = (high[c] - low[c]) / 16;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+
+    int red_green = 0, blue_green = 0;
+    for (int i = 0; i < 16; i++) {
+        int green = block[i][1] * 2 - low[1] - high[1];
+        red_green += (block[i][0] * 2 - low[0] - high[0]) * green;
+        blue_green += (block[i][2] * 2 - low[2] - high[2]) * green;
+    }
+    if (red_green < 0) {
+        int swap = low[0]; low[0] = high[0]; high[0] = swap;
+    }
+    if (blue_green < 0) {
+        int swap = low[2]; low[2] = high[2]; high[2] = swap;
+    }
+
+    uint16_t color0 = pack_565(high);
+    uint16_t color1 = pack_565(low);
+    // The first colour has to be the greater one, otherwise DXT1 switches to three colours and transparency.
+    if (color0 < color1) {
+        uint16_t swap = color0; color0 = color1; color1 = swap;
+    }
+
+    int palette[4][3];
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16 && color0 != color1; i++) {
+        int best = 0, best_error = INT32_MAX;
+        for (int p = 0; p < 4; p++) {
+            int error = 0;
+            for (int c = 0; c < 3; c++) {
+                int difference = block[i][c] - palette[p][c];
+                error += difference * difference;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+    }
+
+    write_le(target, color0, 2);
+    write_le(target + 2, color1, 2);
+    write_le(target + 4, indices, 4);
+}
+
+/**
+ * Encode the alpha of a block with eight levels between its lowest and highest alpha.
+ */
+static void encode_alpha_block(unsigned char block[16][4], unsigned char* target) {
+    int high = 0, low = 255;
+    for (int i = 0; i < 16; i++) {
+        if (block[i][3] > high) high = block[i][3];
+        if (block[i][3] < low) low = block[i][3];
+    }
+
+    int palette[8] = { high, low };
+    for (int p = 2; p < 8; p++) {
+        palette[p] = ((8 - p) * high + (p - 1) * low) / 7;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 16 && high != low; i++) {
+        int best = 0, best_error = 256;
+        for (int p = 0; p < 8; p++) {
+            int error = abs(block[i][3] - palette[p]);
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        indices |= (uint64_t)best << (3 * i);
+    }
+
+    target[0] = (unsigned char)high;
+    target[1] = (unsigned char)low;
+    write_le(target + 2, indices, 6);
+}
+
+static void compress_level(const unsigned char* pixels, int width, int height, bool has_alpha, unsigned char* target) {
+    unsigned char block[16][4];
+    for (int block_y = 0; block_y < (height + 3) / 4; block_y++) {
+        for (int block_x = 0; block_x < (width + 3) / 4; block_x++) {
+            fetch_block(pixels, width, height, block_x, block_y, block);
+            if (has_alpha) {
+                encode_alpha_block(block, target);
+                target += 8;
+            }
+            encode_color_block(block, target);
+            target += 8;
+        }
+    }
+}
+
+/**
+ * Halve the RGBA image with a box filter, an odd last row or column is averaged with itself.
+ */
+static unsigned char* downsample(const unsigned char* pixels, int width, int height, int* out_width, int* out_height) {
+    int target_width = width > 1 ? width / 2 : 1;
+    int target_height = height > 1 ? height / 2 : 1;
+    unsigned char* target = malloc((size_t)target_width * target_height * 4);
+
+    for (int y = 0; y < target_height; y++) {
+        int y0 = y * 2 < height ? y * 2 : height - 1;
+        int y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+        for (int x = 0; x < target_width; x++) {
+            int x0 = x * 2 < width ? x * 2 : width - 1;
+            int x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+            for (int c = 0; c < 4; c++) {
+                int sum = pixels[((size_t)y0 * width + x0) * 4 + c] + pixels[((size_t)y0 * width + x1) * 4 + c]
+                    + pixels[((size_t)y1 * width + x0) * 4 + c] + pixels[((size_t)y1 * width + x1) * 4 + c];
+                target[((size_t)y * target_width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+
+    *out_width = target_width;
+    *out_height = target_height;
+    return target;
+}
+
+static unsigned char* expand_to_rgba(const TextureImage* source, bool* has_alpha) {
+    size_t pixel_count = (size_t)source->width * source->height;
+    unsigned char* pixels = malloc(pixel_count * 4);
+    *has_alpha = false;
+
+    for (size_t i = 0; i < pixel_count; i++) {
+        if (source->format == GL_RGBA) {
+            memcpy(pixels + i * 4, source->pixels + i * 4, 4);
+            *has_alpha = *has_alpha || pixels[i * 4 + 3] != 255;
+        }
+        else {
+            memcpy(pixels + i * 4, source->pixels + i * 3, 3);
+            pixels[i * 4 + 3] = 255;
+        }
+    }
+    return pixels;
+}
+
+bool compress_texture(const TextureImage* source, TextureImage* target) {
+    memset(target, 0, sizeof(TextureImage));
+    if (source->pixels == NULL || source->is_compressed) return false;
+
+    bool has_alpha;
+    unsigned char* pixels = expand_to_rgba(source, &has_alpha);
+
+    target->width = source->width;
+    target->height = source->height;
+    target->format = has_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    target->is_compressed = true;
+
+    size_t total_size = 0;
+    int width = source->width, height = source->height;
+    while (target->level_count < MAX_TEXTURE_LEVELS) {
+        target->level_sizes[target->level_count] = get_compressed_level_size(target->format, width, height);
+        total_size += target->level_sizes[target->level_count++];
+        if (width == 1 && height == 1) break;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    target->pixels = malloc(total_size);
+    unsigned char* level = target->pixels;
+    width = source->width;
+    height = source->height;
+    for (int i = 0; i < target->level_count; i++) {
+        compress_level(pixels, width, height, has_alpha, level);
+        level += target->level_sizes[i];
+
+        if (i + 1 < target->level_count) {
+            unsigned char* smaller = downsample(pixels, width, height, &width, &height);
+            free(pixels);
+            pixels = smaller;
+        }
+    }
+
+    free(pixels);
+    return true;
+}
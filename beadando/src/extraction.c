@@ -10,7 +10,7 @@ void init_extraction(Scene* scene) {
 
     memset(&scene->extraction, 0, sizeof(Extraction));
     
-    scene->extraction.object = (Object**)calloc(2, sizeof(Object*));
+    scene->extraction.object = ARENA_ARRAY(&scene->arena, Object*, 2);
     scene->extraction.object[0] = find_object_by_name(scene, "extraction_platform");
     scene->extraction.object[1] = find_object_by_name(scene, "extraction_screen");
     
@@ -19,8 +19,7 @@ void init_extraction(Scene* scene) {
         return;
     }
     
-    scene->extraction.collection_zone_center = scene->extraction.object[0]->position;
-    scene->extraction.collection_zone_center.z += 0.5f;
+    set_extraction_zone(&scene->extraction, scene->extraction.object[0]);
     scene->extraction.collection_radius = 2.0f;
     scene->extraction.collected_value = 0;
     scene->extraction.is_completed = false;
@@ -30,9 +29,13 @@ void init_extraction(Scene* scene) {
     printf("Target: %d%% of total object value\n", scene->extraction.target_percentage);
 }
 
+void set_extraction_zone(Extraction* extraction, const Object* platform) {
+    extraction->collection_zone_center = platform->position;
+    extraction->collection_zone_center.z += 0.5f;
+}
 
 bool is_object_in_extraction_zone(const Extraction* extraction, const Object* obj) {
-    if (!obj->is_active || obj->is_static) return false;
+    if (!obj->is_active || obj->is_static || (!obj->is_loaded && !obj->is_evicted)) return false;
 
     Vec3 distance = vec3_substract(obj->position, extraction->collection_zone_center);
     float dist_squared = vec3_dot(distance, distance);
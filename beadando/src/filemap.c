@@ -0,0 +1,82 @@
+#include "filemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool map_file(MappedFile* file, const char* path) {
+    file->data = NULL;
+    file->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("[WARNING] Could not map %s\n", path);
+        return false;
+    }
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    return true;
+}
+
+void unmap_file(MappedFile* file) {
+    if (file->data != NULL) {
+        munmap(file->data, file->size);
+    }
+    file->data = NULL;
+    file->size = 0;
+}
+
+#else
+
+// Without mmap the file is read into memory in one go.
+bool map_file(MappedFile* file, const char* path) {
+    file->data = NULL;
+    file->size = 0;
+
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) return false;
+
+    fseek(stream, 0, SEEK_END);
+    long size = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(stream);
+        return false;
+    }
+
+    file->data = malloc((size_t)size);
+    if (file->data == NULL || fread(file->data, 1, (size_t)size, stream) != (size_t)size) {
+        free(file->data);
+        file->data = NULL;
+        fclose(stream);
+        return false;
+    }
+
+    fclose(stream);
+    file->size = (size_t)size;
+    return true;
+}
+
+void unmap_file(MappedFile* file) {
+    free(file->data);
+    file->data = NULL;
+    file->size = 0;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "gl_loader.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Parse the "major.minor" prefix of GL_VERSION into major * 10 + minor.
+ */
+static int get_gl_version() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 1, minor = 0;
+    if (version) {
+        sscanf(version, "%d.%d", &major, &minor);
+    }
+    return major * 10 + minor;
+}
+
+static bool has_gl_extension(const char* name) {
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    size_t length = strlen(name);
+    for (const char* found = extensions; found != NULL && (found = strstr(found, name)) != NULL; found += length) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) return true;
+    }
+    return false;
+}
+
+#define GL_DEFINE_FUNCTION(type, name) type pfn_##name = NULL;
+GL_FUNCTION_LIST(GL_DEFINE_FUNCTION)
+#undef GL_DEFINE_FUNCTION
+
+GLFeatures gl_features;
+
+void load_gl_functions(GLProcLoader loader) {
+    // Stored through a void* lvalue, ISO C has no cast from object to function pointers.
+#define GL_LOAD_FUNCTION(type, name) *(void**)(&pfn_##name) = loader(#name);
+    GL_FUNCTION_LIST(GL_LOAD_FUNCTION)
+#undef GL_LOAD_FUNCTION
+
+    // GLX hands out non-NULL pointers for unsupported functions too.
+    int version = get_gl_version();
+
+    gl_features.buffer_objects = version >= 15 &&
+        glGenBuffers && glDeleteBuffers && glBindBuffer &&
+        glBufferData && glBufferSubData && glMultiDrawElements;
+
+    gl_features.shaders = version >= 20 &&
+        glActiveTexture && glCreateShader && glShaderSource && glCompileShader &&
+        glGetShaderiv && glGetShaderInfoLog && glDeleteShader &&
+        glCreateProgram && glAttachShader && glLinkProgram &&
+        glGetProgramiv && glGetProgramInfoLog && glDeleteProgram &&
+        glUseProgram && glGetUniformLocation && glUniform1i &&
+        glUniform1f && glUniform2f && glUniform3i;
+
+    gl_features.texture_buffers = version >= 31 &&
+        gl_features.buffer_objects && gl_features.shaders && glTexBuffer;
+
+    gl_features.framebuffers = version >= 30 &&
+        glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer &&
+        glGenRenderbuffers && glDeleteRenderbuffers && glBindRenderbuffer &&
+        glRenderbufferStorage && glFramebufferRenderbuffer && glCheckFramebufferStatus;
+
+    gl_features.pixel_buffers = version >= 21 &&
+        gl_features.buffer_objects && glMapBuffer && glUnmapBuffer;
+
+    gl_features.generate_mipmap = version >= 30 && glGenerateMipmap;
+
+    // S3TC is an extension even in core versions, but every desktop driver has it.
+    gl_features.texture_compression = version >= 13 &&
+        glCompressedTexImage2D && has_gl_extension("GL_EXT_texture_compression_s3tc");
+
+    printf("[INFO] GL features: buffer objects %s, shaders %s, texture buffers %s, framebuffers %s, pixel buffers %s, "
+        "texture compression %s\n",
+        gl_features.buffer_objects ? "yes" : "no",
+        gl_features.shaders ? "yes" : "no",
+        gl_features.texture_buffers ? "yes" : "no",
+        gl_features.framebuffers ? "yes" : "no",
+        gl_features.pixel_buffers ? "yes" : "no",
+        gl_features.texture_compression ? "yes" : "no");
+}
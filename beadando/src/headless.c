@@ -0,0 +1,127 @@
+#include "headless.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static void* get_egl_proc_address(const char* name) {
+    void* address;
+    // eglGetProcAddress returns a function pointer, ISO C has no cast to void*.
+    *(__eglMustCastToProperFunctionPointerType*)(&address) = eglGetProcAddress(name);
+    return address;
+}
+
+static EGLDisplay get_surfaceless_display() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+    *(void**)(&get_platform_display) = get_egl_proc_address("eglGetPlatformDisplayEXT");
+
+    if (get_platform_display) {
+        EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY) return display;
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool create_framebuffer(HeadlessContext* headless) {
+    if (!gl_features.framebuffers) {
+        printf("[ERROR] Headless rendering needs framebuffer objects (OpenGL 3.0).\n");
+        return false;
+    }
+
+    glGenRenderbuffers(1, &headless->color_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->color_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headless->width, headless->height);
+
+    glGenRenderbuffers(1, &headless->depth_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->depth_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, headless->width, headless->height);
+
+    glGenFramebuffers(1, &headless->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->color_buffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->depth_buffer);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("[ERROR] Incomplete headless framebuffer: 0x%x\n", status);
+        return false;
+    }
+
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    return true;
+}
+
+bool init_headless_context(HeadlessContext* headless, int width, int height) {
+    memset(headless, 0, sizeof(HeadlessContext));
+    headless->width = width;
+    headless->height = height;
+
+    EGLDisplay display = get_surfaceless_display();
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        printf("[ERROR] Unable to initialize EGL: 0x%x\n", eglGetError());
+        return false;
+    }
+    headless->display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        printf("[ERROR] EGL has no desktop OpenGL support.\n");
+        return false;
+    }
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        printf("[ERROR] Unable to create the headless OpenGL context: 0x%x\n", eglGetError());
+        return false;
+    }
+    headless->context = context;
+
+    printf("[INFO] Headless EGL %d.%d, renderer: %s\n", major, minor, glGetString(GL_RENDERER));
+    load_gl_functions(get_egl_proc_address);
+
+    return create_framebuffer(headless);
+}
+
+void destroy_headless_context(HeadlessContext* headless) {
+    if (headless->framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &headless->framebuffer);
+        glDeleteRenderbuffers(1, &headless->color_buffer);
+        glDeleteRenderbuffers(1, &headless->depth_buffer);
+    }
+
+    if (headless->display) {
+        eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (headless->context) {
+            eglDestroyContext(headless->display, headless->context);
+        }
+        eglTerminate(headless->display);
+    }
+
+    memset(headless, 0, sizeof(HeadlessContext));
+}
+
+#else
+
+bool init_headless_context(HeadlessContext* headless, int width, int height) {
+    memset(headless, 0, sizeof(HeadlessContext));
+    headless->width = width;
+    headless->height = height;
+    printf("[ERROR] Headless rendering needs EGL, which is not available on Windows.\n");
+    return false;
+}
+
+void destroy_headless_context(HeadlessContext* headless) {
+    memset(headless, 0, sizeof(HeadlessContext));
+}
+
+#endif
@@ -0,0 +1,349 @@
+#include "hot_reload.h"
+#include "scene.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * What a reloaded config entry did to its object.
+ */
+typedef enum ObjectChange {
+    OBJECT_UNCHANGED,
+    OBJECT_UPDATED,
+    OBJECT_MOVED,
+    OBJECT_RETEXTURED,
+    OBJECT_RELOADED
+} ObjectChange;
+
+static int64_t get_config_mtime(const char* file_name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", CONFIG_DIRECTORY, file_name);
+
+    struct stat info;
+    return stat(path, &info) == 0 ? (int64_t)info.st_mtime : 0;
+}
+
+void init_config_watcher(ConfigWatcher* watcher) {
+    memset(watcher, 0, sizeof(ConfigWatcher));
+    watcher->inotify_fd = -1;
+    watcher->light_mtime = get_config_mtime(LIGHT_CONFIG_FILE);
+    watcher->object_mtime = get_config_mtime(OBJECT_CONFIG_FILE);
+    watcher->last_poll = SDL_GetTicks();
+    watcher->is_enabled = true;
+
+#ifdef __linux__
+    // Editors either rewrite the file or move a new one over it.
+    watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->inotify_fd >= 0 && inotify_add_watch(watcher->inotify_fd, CONFIG_DIRECTORY, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(watcher->inotify_fd);
+        watcher->inotify_fd = -1;
+    }
+#endif
+    printf("[INFO] Watching %s/ for config changes (%s)\n", CONFIG_DIRECTORY,
+        watcher->inotify_fd >= 0 ? "inotify" : "polling");
+}
+
+static void mark_changed_config(ConfigWatcher* watcher, const char* file_name) {
+    if (strcmp(file_name, LIGHT_CONFIG_FILE) == 0) watcher->is_light_changed = true;
+    if (strcmp(file_name, OBJECT_CONFIG_FILE) == 0) watcher->is_object_changed = true;
+}
+
+static void read_config_events(ConfigWatcher* watcher) {
+#ifdef __linux__
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    while ((length = read(watcher->inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* next = buffer; next < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)next;
+            if (event->len > 0) {
+                mark_changed_config(watcher, event->name);
+            }
+            next += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#else
+    (void)watcher;
+#endif
+}
+
+static void poll_config_mtimes(ConfigWatcher* watcher) {
+    Uint32 now = SDL_GetTicks();
+    if (now - watcher->last_poll < CONFIG_POLL_INTERVAL_MS) return;
+    watcher->last_poll = now;
+
+    int64_t light_mtime = get_config_mtime(LIGHT_CONFIG_FILE);
+    int64_t object_mtime = get_config_mtime(OBJECT_CONFIG_FILE);
+    if (light_mtime != watcher->light_mtime) mark_changed_config(watcher, LIGHT_CONFIG_FILE);
+    if (object_mtime != watcher->object_mtime) mark_changed_config(watcher, OBJECT_CONFIG_FILE);
+    watcher->light_mtime = light_mtime;
+    watcher->object_mtime = object_mtime;
+}
+
+static double elapsed_ms(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Update the lights by name, disable the ones no longer in the config and add the new ones.
+ */
+static void reload_light_config(Scene* scene) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    Lighting configs[MAX_LIGHTS];
+    int config_count = 0;
+    read_light_config(CONFIG_DIRECTORY "/" LIGHT_CONFIG_FILE, configs, &config_count);
+    if (config_count > MAX_LIGHTS) config_count = MAX_LIGHTS;
+    if (config_count == 0) {
+        printf("[WARNING] %s has no lights, keeping the current ones\n", LIGHT_CONFIG_FILE);
+        return;
+    }
+
+    // The benchmark lights are appended after the fixed-function slots, the reload leaves them alone.
+    int light_count = scene->light_count < MAX_LIGHTS ? scene->light_count : MAX_LIGHTS;
+    bool is_kept[MAX_LIGHTS] = { false };
+    int updated = 0, added = 0, removed = 0;
+    for (int i = 0; i < config_count; i++) {
+        int index = find_name(&scene->light_index, configs[i].name);
+        if (index >= 0 && index < light_count) {
+            update_light(scene, &scene->lights[index], &configs[i]);
+            is_kept[index] = true;
+            updated++;
+        }
+        else if (scene->light_count < MAX_LIGHTS) {
+            is_kept[scene->light_count] = true;
+            add_light(scene, &configs[i]);
+            added++;
+        }
+        else {
+            printf("[WARNING] No free light for '%s'\n", configs[i].name);
+        }
+    }
+
+    for (int i = 0; i < light_count; i++) {
+        if (!is_kept[i] && scene->lights[i].enabled) {
+            scene->lights[i].enabled = false;
+            removed++;
+        }
+    }
+
+    printf("[INFO] Reloaded %s in %.2f ms: %d lights updated, %d added, %d removed\n",
+        LIGHT_CONFIG_FILE, elapsed_ms(start), updated, added, removed);
+}
+
+static bool is_same_vec3(Vec3 a, Vec3 b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/**
+ * Put an object that is not in memory to the place of its config, it loads from there.
+ */
+static void reset_object_placement(Scene* scene, Object* obj, const ObjectConfig* config) {
+    Room* room = find_room_by_name(scene, config->room_name);
+    obj->room_id = room->id;
+    obj->position = calculate_world_position(room, config);
+    obj->is_evicted = false;
+}
+
+/**
+ * Apply the differences of the new config to the object, only the mesh or the body changes reload it.
+ * The kept config is replaced, the loader and the room streaming read it later.
+ */
+static ObjectChange apply_object_config(Scene* scene, Object* obj, ObjectConfig* current, const ObjectConfig* config) {
+    bool is_same_mesh = strcmp(current->model_path, config->model_path) == 0
+        && is_same_vec3(current->scale, config->scale) && is_same_vec3(current->rotation, config->rotation);
+    bool is_same_body = current->mass == config->mass && current->is_static == config->is_static;
+    bool is_same_place = strcmp(current->room_name, config->room_name) == 0 && is_same_vec3(current->offset, config->offset);
+    bool is_same_texture = strcmp(current->texture_path, config->texture_path) == 0;
+    bool is_same_value = current->value == config->value;
+
+    if (is_same_mesh && is_same_body && is_same_place && is_same_texture && is_same_value && !obj->is_removed) {
+        return OBJECT_UNCHANGED;
+    }
+
+    *current = *config;
+    obj->rotation = config->rotation;
+    if (!is_same_value) {
+        obj->value = config->value;
+    }
+
+    // A removed object comes back when its name returns to the config.
+    if (obj->is_removed) {
+        obj->is_removed = false;
+        obj->is_active = true;
+    }
+
+    if (!obj->is_loaded) {
+        obj->is_static = config->is_static;
+        reset_object_placement(scene, obj, config);
+        return OBJECT_RELOADED;
+    }
+
+    // The display lists of the static objects have their position and texture name compiled in.
+    bool is_texture_toggled = !is_same_texture && (obj->texture_id == 0 || config->texture_path[0] == '\0');
+    if (!is_same_mesh || !is_same_body || (!is_same_place && obj->is_static) || is_texture_toggled) {
+        if (obj->id == scene->selected_object_id) {
+            scene->selected_object_id = -1;
+        }
+        // Released as the body it has now, before it changes kind.
+        release_object_assets(obj);
+        obj->is_static = config->is_static;
+        reset_object_placement(scene, obj, config);
+        return OBJECT_RELOADED;
+    }
+
+    ObjectChange change = OBJECT_UPDATED;
+    if (!is_same_texture) {
+        TextureImage image;
+        if (decode_texture(config->texture_path, &image)) {
+            replace_texture(obj->texture_id, &image);
+        }
+        obj->memory_bytes = get_texture_memory(obj->texture_id) + get_lod_chain_memory(&obj->lod);
+        change = OBJECT_RETEXTURED;
+    }
+
+    if (!is_same_place) {
+        obj->room_id = find_room_by_name(scene, config->room_name)->id;
+        place_object(scene, obj, config);
+        physics_set_position(&obj->physics_body, obj->position);
+        physics_set_linear_velocity(&obj->physics_body, (Vec3){ 0.0f, 0.0f, 0.0f });
+        change = OBJECT_MOVED;
+    }
+    return change;
+}
+
+static void remove_object(Scene* scene, Object* obj) {
+    if (obj->id == scene->selected_object_id) {
+        scene->selected_object_id = -1;
+    }
+    if (obj->is_loaded) {
+        release_object_assets(obj);
+    }
+    obj->is_evicted = false;
+    obj->is_active = false;
+    obj->is_removed = true;
+}
+
+/**
+ * Load the objects of the resident rooms that were released or added by the reload.
+ */
+static void start_object_reloading(Scene* scene) {
+    int count = 0;
+    for (int i = 0; i < scene->object_count; i++) {
+        const Object* obj = &scene->objects[i];
+        if (obj->is_active && !obj->is_loaded && scene->rooms[obj->room_id].residency == ROOM_RESIDENT) count++;
+    }
+    if (count == 0) return;
+
+    init_asset_loader(&scene->loader, scene->load_threads);
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (!obj->is_active || obj->is_loaded || scene->rooms[obj->room_id].residency != ROOM_RESIDENT) continue;
+
+        queue_object_assets(obj, &scene->object_configs[i], &scene->loader);
+    }
+    start_asset_loader(&scene->loader);
+    scene->is_loading = true;
+}
+
+/**
+ * Diff the object config against the scene by name, only the changed objects are touched.
+ */
+static void reload_object_config(Scene* scene) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    int config_count = 0;
+    ObjectConfig* configs = read_object_config(CONFIG_DIRECTORY "/" OBJECT_CONFIG_FILE, &config_count);
+    if (config_count == 0) {
+        printf("[WARNING] %s has no objects, keeping the current ones\n", OBJECT_CONFIG_FILE);
+        free(configs);
+        return;
+    }
+
+    bool* is_kept = calloc(scene->object_capacity, sizeof(bool));
+    int counts[OBJECT_RELOADED + 1] = { 0 };
+    int added = 0, removed = 0;
+    for (int i = 0; i < config_count; i++) {
+        const ObjectConfig* config = &configs[i];
+        int index = find_name(&scene->object_index, config->name);
+        if (find_room_by_name(scene, config->room_name) == NULL) {
+            printf("[WARNING] Unknown room '%s' for object '%s'\n", config->room_name, config->name);
+            if (index >= 0) is_kept[index] = true;
+            continue;
+        }
+
+        if (index >= 0) {
+            counts[apply_object_config(scene, &scene->objects[index], &scene->object_configs[index], config)]++;
+            is_kept[index] = true;
+        }
+        else if (scene->object_count < scene->object_capacity) {
+            int id = scene->object_count;
+            scene->object_configs[id] = *config;
+            scene->object_config_count = id + 1;
+            add_object(scene, &scene->object_configs[id]);
+            mat4_identity(&scene->model_matrices[id]);
+            is_kept[id] = true;
+            added++;
+        }
+        else {
+            printf("[WARNING] No room for object '%s', the scene holds %d objects\n", config->name,
+                scene->object_capacity);
+        }
+    }
+
+    for (int i = 0; i < scene->object_count; i++) {
+        if (!is_kept[i] && !scene->objects[i].is_removed) {
+            remove_object(scene, &scene->objects[i]);
+            removed++;
+        }
+    }
+    free(is_kept);
+    free(configs);
+
+    // The static batches hold the static props that were released.
+    if (scene->static_world.is_ready && (counts[OBJECT_RELOADED] > 0 || removed > 0)) {
+        destroy_static_world(&scene->static_world);
+        build_static_world(&scene->static_world, scene);
+    }
+    start_object_reloading(scene);
+
+    printf("[INFO] Reloaded %s in %.2f ms: %d objects updated, %d moved, %d retextured, %d reloaded, %d added, %d removed\n",
+        OBJECT_CONFIG_FILE, elapsed_ms(start), counts[OBJECT_UPDATED], counts[OBJECT_MOVED],
+        counts[OBJECT_RETEXTURED], counts[OBJECT_RELOADED], added, removed);
+}
+
+void update_config_watcher(ConfigWatcher* watcher, Scene* scene) {
+    if (!watcher->is_enabled) return;
+
+    if (watcher->inotify_fd >= 0) {
+        read_config_events(watcher);
+    }
+    else {
+        poll_config_mtimes(watcher);
+    }
+
+    if (watcher->is_light_changed) {
+        watcher->is_light_changed = false;
+        TRACE_ZONE("Reload light config", reload_light_config(scene));
+    }
+
+    // The changed objects are applied once the loader is done with the previous ones.
+    if (watcher->is_object_changed && !scene->is_loading) {
+        watcher->is_object_changed = false;
+        TRACE_ZONE("Reload object config", reload_object_config(scene));
+    }
+}
+
+void free_config_watcher(ConfigWatcher* watcher) {
+#ifdef __linux__
+    if (watcher->inotify_fd >= 0) {
+        close(watcher->inotify_fd);
+    }
+#endif
+    watcher->inotify_fd = -1;
+    watcher->is_enabled = false;
+}
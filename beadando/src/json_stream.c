@@ -0,0 +1,270 @@
+#include "json_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool open_json_stream(JsonStream* stream, const char* filename) {
+    memset(stream, 0, sizeof(JsonStream));
+    stream->file = fopen(filename, "rb");
+    stream->line = 1;
+    return stream->file != NULL;
+}
+
+void close_json_stream(JsonStream* stream) {
+    if (stream->file != NULL) {
+        fclose(stream->file);
+    }
+    stream->file = NULL;
+}
+
+static int peek_char(JsonStream* stream) {
+    if (stream->position == stream->length) {
+        stream->length = fread(stream->buffer, 1, JSON_STREAM_BUFFER_SIZE, stream->file);
+        stream->position = 0;
+        if (stream->length == 0) return -1;
+    }
+    return (unsigned char)stream->buffer[stream->position];
+}
+
+static int read_char(JsonStream* stream) {
+    int c = peek_char(stream);
+    if (c >= 0) {
+        stream->position++;
+        if (c == '\n') stream->line++;
+    }
+    return c;
+}
+
+static int skip_whitespace(JsonStream* stream) {
+    int c = peek_char(stream);
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        read_char(stream);
+        c = peek_char(stream);
+    }
+    return c;
+}
+
+static JsonToken fail(JsonStream* stream, const char* message) {
+    if (!stream->is_failed) {
+        printf("[ERROR] JSON syntax error on line %d: %s\n", stream->line, message);
+    }
+    stream->is_failed = true;
+    return JSON_TOKEN_ERROR;
+}
+
+static void append_text(JsonStream* stream, unsigned int c) {
+    if (stream->text_length + 1 < JSON_STREAM_MAX_STRING) {
+        stream->text[stream->text_length++] = (char)c;
+    }
+}
+
+static void append_utf8(JsonStream* stream, unsigned int code) {
+    if (code < 0x80) {
+        append_text(stream, code);
+    }
+    else if (code < 0x800) {
+        append_text(stream, 0xC0 | (code >> 6));
+        append_text(stream, 0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        append_text(stream, 0xE0 | (code >> 12));
+        append_text(stream, 0x80 | ((code >> 6) & 0x3F));
+        append_text(stream, 0x80 | (code & 0x3F));
+    }
+    else {
+        append_text(stream, 0xF0 | (code >> 18));
+        append_text(stream, 0x80 | ((code >> 12) & 0x3F));
+        append_text(stream, 0x80 | ((code >> 6) & 0x3F));
+        append_text(stream, 0x80 | (code & 0x3F));
+    }
+}
+
+static bool read_hex4(JsonStream* stream, unsigned int* code) {
+    *code = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = read_char(stream);
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (digit < 0) return false;
+        *code = *code * 16 + (unsigned int)digit;
+    }
+    return true;
+}
+
+/**
+ * Read a string after its opening quote into text, decoding the escapes.
+ */
+static bool read_string(JsonStream* stream) {
+    stream->text_length = 0;
+    for (;;) {
+        int c = read_char(stream);
+        if (c == '"') break;
+        if (c < 0x20) return false;
+        if (c != '\\') {
+            append_text(stream, (unsigned int)c);
+            continue;
+        }
+
+        c = read_char(stream);
+        unsigned int code;
+        switch (c) {
+            case '"': case '\\': case '/': append_text(stream, (unsigned int)c); break;
+            case 'b': append_text(stream, '\b'); break;
+            case 'f': append_text(stream, '\f'); break;
+            case 'n': append_text(stream, '\n'); break;
+            case 'r': append_text(stream, '\r'); break;
+            case 't': append_text(stream, '\t'); break;
+            case 'u':
+                if (!read_hex4(stream, &code)) return false;
+                // A high surrogate is combined with the low surrogate escape that follows it.
+                if (code >= 0xD800 && code < 0xDC00) {
+                    unsigned int low;
+                    if (read_char(stream) != '\\' || read_char(stream) != 'u' || !read_hex4(stream, &low)
+                        || low < 0xDC00 || low >= 0xE000) return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(stream, code);
+                break;
+            default:
+                return false;
+        }
+    }
+    stream->text[stream->text_length] = '\0';
+    return true;
+}
+
+static bool read_number(JsonStream* stream) {
+    char digits[64];
+    size_t length = 0;
+    int c = peek_char(stream);
+    while ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        if (length + 1 == sizeof(digits)) return false;
+        digits[length++] = (char)read_char(stream);
+        c = peek_char(stream);
+    }
+    digits[length] = '\0';
+
+    char* end;
+    stream->number = strtod(digits, &end);
+    return length > 0 && end == digits + length;
+}
+
+static bool read_literal(JsonStream* stream, const char* literal) {
+    for (const char* c = literal; *c != '\0'; c++) {
+        if (read_char(stream) != *c) return false;
+    }
+    return true;
+}
+
+/**
+ * A value was finished, the container it is in expects a separator next.
+ */
+static void finish_value(JsonStream* stream) {
+    stream->is_after_key = false;
+    stream->is_after_comma = false;
+    if (stream->depth == 0) {
+        stream->is_done = true;
+    }
+    else {
+        stream->has_value = true;
+    }
+}
+
+static JsonToken open_container(JsonStream* stream, char container, JsonToken token) {
+    if (stream->depth == JSON_STREAM_MAX_DEPTH) return fail(stream, "too deeply nested");
+    read_char(stream);
+    stream->containers[stream->depth++] = container;
+    stream->has_value = false;
+    stream->is_after_comma = false;
+    stream->is_after_key = false;
+    return token;
+}
+
+static JsonToken close_container(JsonStream* stream, JsonToken token) {
+    read_char(stream);
+    stream->depth--;
+    finish_value(stream);
+    return token;
+}
+
+JsonToken next_json_token(JsonStream* stream) {
+    if (stream->is_failed) return JSON_TOKEN_ERROR;
+
+    int c = skip_whitespace(stream);
+    if (stream->is_done) {
+        return c < 0 ? JSON_TOKEN_END : fail(stream, "content after the document");
+    }
+    if (c < 0) return fail(stream, "unexpected end of file");
+
+    if (stream->depth > 0) {
+        char container = stream->containers[stream->depth - 1];
+        char closing = container == '{' ? '}' : ']';
+        JsonToken end_token = container == '{' ? JSON_TOKEN_OBJECT_END : JSON_TOKEN_ARRAY_END;
+
+        if (stream->has_value) {
+            if (c == closing) return close_container(stream, end_token);
+            if (c != ',') return fail(stream, "expected a comma");
+            read_char(stream);
+            stream->has_value = false;
+            stream->is_after_comma = true;
+            c = skip_whitespace(stream);
+        }
+        else if (c == closing && !stream->is_after_comma && !stream->is_after_key) {
+            return close_container(stream, end_token);
+        }
+
+        if (container == '{' && !stream->is_after_key) {
+            if (c != '"') return fail(stream, "expected a key");
+            read_char(stream);
+            if (!read_string(stream)) return fail(stream, "invalid key");
+            if (skip_whitespace(stream) != ':') return fail(stream, "expected a colon");
+            read_char(stream);
+            stream->is_after_key = true;
+            stream->is_after_comma = false;
+            return JSON_TOKEN_KEY;
+        }
+    }
+
+    JsonToken token;
+    switch (c) {
+        case '{': return open_container(stream, '{', JSON_TOKEN_OBJECT_BEGIN);
+        case '[': return open_container(stream, '[', JSON_TOKEN_ARRAY_BEGIN);
+        case '"':
+            read_char(stream);
+            if (!read_string(stream)) return fail(stream, "invalid string");
+            token = JSON_TOKEN_STRING;
+            break;
+        case 't':
+            if (!read_literal(stream, "true")) return fail(stream, "invalid literal");
+            token = JSON_TOKEN_TRUE;
+            break;
+        case 'f':
+            if (!read_literal(stream, "false")) return fail(stream, "invalid literal");
+            token = JSON_TOKEN_FALSE;
+            break;
+        case 'n':
+            if (!read_literal(stream, "null")) return fail(stream, "invalid literal");
+            token = JSON_TOKEN_NULL;
+            break;
+        default:
+            if (!read_number(stream)) return fail(stream, "invalid value");
+            token = JSON_TOKEN_NUMBER;
+            break;
+    }
+    finish_value(stream);
+    return token;
+}
+
+bool skip_json_value(JsonStream* stream, JsonToken token) {
+    if (token != JSON_TOKEN_OBJECT_BEGIN && token != JSON_TOKEN_ARRAY_BEGIN) {
+        return token != JSON_TOKEN_ERROR && token != JSON_TOKEN_END;
+    }
+
+    int depth = 1;
+    while (depth > 0) {
+        token = next_json_token(stream);
+        if (token == JSON_TOKEN_ERROR) return false;
+        if (token == JSON_TOKEN_OBJECT_BEGIN || token == JSON_TOKEN_ARRAY_BEGIN) depth++;
+        if (token == JSON_TOKEN_OBJECT_END || token == JSON_TOKEN_ARRAY_END) depth--;
+    }
+    return true;
+}
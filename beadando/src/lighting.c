@@ -5,38 +5,54 @@
 #include <GL/gl.h>
 #include "utils.h"
 
+/**
+ * Hang a spotlight from the ceiling in the middle of its room.
+ */
+static void position_spotlight(Scene* scene, Lighting* light) {
+    if (!light->is_spotlight || light->room_name[0] == '\0') return;
+
+    Room* room = find_room_by_name(scene, light->room_name);
+    if (room) {
+        light->position = (Vec4){
+            room->position.x,
+            room->position.y,
+            room->position.z + room->dimension.z,
+            1.0f
+        };
+
+        printf("Positioned spotlight '%s' at [%.2f, %.2f, %.2f] in room '%s'\n",
+            light->name,
+            light->position.x,
+            light->position.y,
+            light->position.z,
+            light->room_name);
+    }
+    else {
+        printf("[WARNING]: Could not find room '%s' for light '%s'\n",
+            light->room_name, light->name);
+    }
+}
+
 void add_light(Scene* scene, Lighting* config) {
     Lighting new_light = *config;
     new_light.enabled = true;
     new_light.slot = scene->light_count;
+    position_spotlight(scene, &new_light);
 
-    if (new_light.is_spotlight && new_light.room_name[0] != '\0') {
-        Room* room = find_room_by_name(scene, new_light.room_name);
-        if (room) {
-            new_light.position = (Vec4){
-                room->position.x,
-                room->position.y,
-                room->position.z + room->dimension.z,
-                1.0f
-            };
-
-            printf("Positioned spotlight '%s' at [%.2f, %.2f, %.2f] in room '%s'\n",
-                new_light.name,
-                new_light.position.x,
-                new_light.position.y,
-                new_light.position.z,
-                new_light.room_name);
-        }
-        else {
-            printf("[WARNING]: Could not find room '%s' for light '%s'\n",
-                new_light.room_name, new_light.name);
-        }
-    }
-
-    scene->lights[scene->light_count++] = new_light;
+    scene->lights[scene->light_count] = new_light;
+    add_name(&scene->light_index, scene->lights[scene->light_count].name, scene->light_count);
+    scene->light_count++;
     glEnable(GL_LIGHT0 + new_light.slot);
 }
 
+void update_light(Scene* scene, Lighting* light, const Lighting* config) {
+    int slot = light->slot;
+    *light = *config;
+    light->enabled = true;
+    light->slot = slot;
+    position_spotlight(scene, light);
+}
+
 void set_lighting(int slot, const Lighting* light) {
     GLenum light_enum = GL_LIGHT0 + slot;
 
@@ -85,17 +101,30 @@ void set_lighting(int slot, const Lighting* light) {
     }
 }
 
+static bool is_animated_light(const Lighting* light) {
+    return strcmp(light->name, "disco_light") == 0;
+}
+
 void update_lighting(Scene* scene, float total_time) {
     for (int i = 0; i < scene->light_count; i++) {
         if (!scene->lights[i].enabled) continue;
 
-        if (strcmp(scene->lights[i].name, "disco_light") == 0) {
+        if (is_animated_light(&scene->lights[i])) {
             ColorRGB c = sine_animate_color(total_time, i);
             scene->lights[i].diffuse = (ColorRGBA){ c.red, c.green, c.blue, 1.0f };
         }
     }
 }
 
+bool has_animated_lights(const Scene* scene) {
+    for (int i = 0; i < scene->light_count; i++) {
+        if (scene->lights[i].enabled && is_animated_light(&scene->lights[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void adjust_brightness(Scene* scene, float amount) {
     float brightness;
     for (int i = 0; i < scene->light_count; i++) {
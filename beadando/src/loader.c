@@ -0,0 +1,225 @@
+#include "loader.h"
+#include "object.h"
+#include "texture.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double loader_ms(const AssetLoader* loader) {
+    return (double)(SDL_GetPerformanceCounter() - loader->start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void init_asset_loader(AssetLoader* loader, int thread_count) {
+    memset(loader, 0, sizeof(AssetLoader));
+
+    if (thread_count <= 0) {
+        thread_count = SDL_GetCPUCount() - 1;
+    }
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_LOADER_THREADS) thread_count = MAX_LOADER_THREADS;
+    loader->thread_count = thread_count;
+}
+
+static AssetJob* add_job(AssetLoader* loader, AssetJobType type) {
+    if (loader->job_count == loader->job_capacity) {
+        loader->job_capacity = loader->job_capacity > 0 ? loader->job_capacity * 2 : 32;
+        loader->jobs = realloc(loader->jobs, loader->job_capacity * sizeof(AssetJob));
+    }
+
+    AssetJob* job = &loader->jobs[loader->job_count++];
+    memset(job, 0, sizeof(AssetJob));
+    job->type = type;
+    return job;
+}
+
+void queue_texture_load(AssetLoader* loader, const char* path, GLuint* texture, Object* object) {
+    AssetJob* job = add_job(loader, ASSET_TEXTURE);
+    strncpy(job->path, path, sizeof(job->path) - 1);
+    job->texture = texture;
+    job->object = object;
+    *texture = 0;
+}
+
+void queue_model_load(AssetLoader* loader, const ObjectConfig* config, Object* object) {
+    AssetJob* job = add_job(loader, ASSET_MODEL);
+    snprintf(job->path, sizeof(job->path), "%s", config->model_path);
+    job->config = config;
+    job->object = object;
+}
+
+/**
+ * Claim and run the next job, returns false when every job was claimed.
+ */
+static bool run_next_job(AssetLoader* loader, int thread) {
+    SDL_LockMutex(loader->mutex);
+    int index = loader->next_job < loader->job_count ? loader->next_job++ : -1;
+    SDL_UnlockMutex(loader->mutex);
+    if (index < 0) return false;
+
+    AssetJob* job = &loader->jobs[index];
+    job->thread = thread;
+    job->start_ms = loader_ms(loader);
+    if (job->type == ASSET_TEXTURE) {
+        decode_texture(job->path, &job->image);
+    }
+    else {
+        load_and_prepare_model(job->object, job->config);
+    }
+    job->end_ms = loader_ms(loader);
+
+    SDL_LockMutex(loader->mutex);
+    loader->finished[loader->finished_count++] = job;
+    SDL_UnlockMutex(loader->mutex);
+    SDL_SemPost(loader->ready);
+    return true;
+}
+
+static int loader_worker(void* data) {
+    AssetLoader* loader = data;
+
+    SDL_LockMutex(loader->mutex);
+    int thread = ++loader->worker_count;
+    SDL_UnlockMutex(loader->mutex);
+
+    char name[32];
+    snprintf(name, sizeof(name), "Asset loader %d", thread);
+    trace_thread_name(name);
+
+    while (run_next_job(loader, thread)) {
+    }
+    trace_thread_exit();
+    return 0;
+}
+
+/**
+ * The rooms are needed for the first frame, the objects have placeholders until they arrive.
+ */
+static int get_job_rank(const AssetJob* job) {
+    if (job->type == ASSET_MODEL) return 1;
+    return job->object == NULL ? 0 : 2;
+}
+
+/**
+ * Order the jobs by rank, keeping the queue order within a rank.
+ */
+static void sort_jobs(AssetLoader* loader) {
+    AssetJob* sorted = malloc((loader->job_count > 0 ? loader->job_count : 1) * sizeof(AssetJob));
+    int count = 0;
+    for (int rank = 0; rank < 3; rank++) {
+        for (int i = 0; i < loader->job_count; i++) {
+            if (get_job_rank(&loader->jobs[i]) == rank) sorted[count++] = loader->jobs[i];
+        }
+    }
+    free(loader->jobs);
+    loader->jobs = sorted;
+    loader->job_capacity = loader->job_count;
+}
+
+void start_asset_loader(AssetLoader* loader) {
+    sort_jobs(loader);
+
+    loader->finished = calloc(loader->job_count > 0 ? loader->job_count : 1, sizeof(AssetJob*));
+    loader->mutex = SDL_CreateMutex();
+    loader->ready = SDL_CreateSemaphore(0);
+    loader->start = SDL_GetPerformanceCounter();
+
+    int started = 0;
+    for (int i = 0; i < loader->thread_count && i < loader->job_count; i++) {
+        loader->threads[started] = SDL_CreateThread(loader_worker, "asset_loader", loader);
+        if (loader->threads[started] == NULL) {
+            printf("[WARNING] Could not start an asset loader thread: %s\n", SDL_GetError());
+            break;
+        }
+        started++;
+    }
+    loader->thread_count = started;
+}
+
+/**
+ * Take a job after its post on the ready semaphore was consumed and upload its texture.
+ */
+static AssetJob* take_finished_job(AssetLoader* loader) {
+    SDL_LockMutex(loader->mutex);
+    AssetJob* job = loader->finished[loader->consumed_count++];
+    SDL_UnlockMutex(loader->mutex);
+
+    if (job->type == ASSET_TEXTURE) {
+        double start = loader_ms(loader);
+        *job->texture = upload_texture(&job->image);
+        loader->upload_ms += loader_ms(loader) - start;
+    }
+    return job;
+}
+
+AssetJob* wait_for_asset(AssetLoader* loader) {
+    if (!has_pending_assets(loader)) return NULL;
+
+    // Without workers the main thread does the jobs itself.
+    if (loader->thread_count == 0) {
+        run_next_job(loader, 0);
+    }
+
+    SDL_SemWait(loader->ready);
+    return take_finished_job(loader);
+}
+
+AssetJob* poll_asset(AssetLoader* loader) {
+    if (!has_pending_assets(loader)) return NULL;
+
+    if (loader->thread_count == 0) {
+        run_next_job(loader, 0);
+    }
+
+    if (SDL_SemTryWait(loader->ready) != 0) return NULL;
+    return take_finished_job(loader);
+}
+
+bool has_pending_assets(const AssetLoader* loader) {
+    return loader->consumed_count < loader->job_count;
+}
+
+void finish_asset_loader(AssetLoader* loader) {
+    double total_ms = loader_ms(loader);
+
+    if (loader->mutex != NULL) {
+        SDL_LockMutex(loader->mutex);
+        loader->next_job = loader->job_count;
+        SDL_UnlockMutex(loader->mutex);
+    }
+    for (int i = 0; i < loader->thread_count; i++) {
+        SDL_WaitThread(loader->threads[i], NULL);
+    }
+
+    // Models and textures prepared after the scene stopped waiting for them.
+    for (int i = loader->consumed_count; i < loader->finished_count; i++) {
+        AssetJob* job = loader->finished[i];
+        if (job->type == ASSET_MODEL) {
+            free_lod_chain(&job->object->lod);
+        }
+        else {
+            free_texture_image(&job->image);
+        }
+    }
+
+    double work_ms = 0.0;
+    printf("Startup timeline (ms):\n");
+    for (int i = 0; i < loader->finished_count; i++) {
+        const AssetJob* job = loader->finished[i];
+        work_ms += job->end_ms - job->start_ms;
+        printf("  %s %2d %8.1f - %8.1f  %-7s %s\n",
+            job->thread > 0 ? "worker" : "main  ", job->thread,
+            job->start_ms, job->end_ms,
+            job->type == ASSET_MODEL ? "model" : "texture", job->path);
+    }
+    printf("[INFO] Loaded %d assets in %.1f ms with %d worker threads on %d cores: "
+        "%.1f ms of parsing and decoding (%.1fx overlap), %.1f ms of texture uploads\n",
+        loader->job_count, total_ms, loader->thread_count, SDL_GetCPUCount(),
+        work_ms, total_ms > 0.0 ? work_ms / total_ms : 0.0, loader->upload_ms);
+
+    if (loader->mutex != NULL) SDL_DestroyMutex(loader->mutex);
+    if (loader->ready != NULL) SDL_DestroySemaphore(loader->ready);
+    free(loader->finished);
+    free(loader->jobs);
+    memset(loader, 0, sizeof(AssetLoader));
+}
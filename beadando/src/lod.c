@@ -0,0 +1,659 @@
+#include "lod.h"
+#include "mesh_optimizer.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Triangle count of each level relative to the full mesh.
+static const float LOD_RATIOS[MAX_LOD_LEVELS] = { 1.0f, 0.5f, 0.25f, 0.1f };
+
+// Screen height fraction below which each level is used.
+static const float LOD_SCREEN_SIZES[MAX_LOD_LEVELS] = { 1.0f, 0.25f, 0.12f, 0.05f };
+
+// Weight of the planes keeping open borders in place.
+#define BORDER_WEIGHT 1000.0
+
+/**
+ * Symmetric 4x4 error quadric: xx, xy, xz, xw, yy, yz, yw, zz, zw, ww.
+ */
+typedef struct Quadric {
+    double q[10];
+} Quadric;
+
+/**
+ * Edge collapse with its cost, valid while neither endpoint has changed.
+ */
+typedef struct Collapse {
+    double cost;
+    double target[3];
+    int a;
+    int b;
+    int a_version;
+    int b_version;
+} Collapse;
+
+typedef struct CollapseHeap {
+    Collapse* items;
+    int count;
+    int capacity;
+} CollapseHeap;
+
+typedef struct IntList {
+    int* items;
+    int count;
+    int capacity;
+} IntList;
+
+/**
+ * Edge of a triangle as a sorted position index pair.
+ */
+typedef struct Edge {
+    int a;
+    int b;
+    int triangle;
+} Edge;
+
+/**
+ * Working state of the simplifier on the welded positions.
+ */
+typedef struct Simplifier {
+    int position_count;
+    double (*positions)[3];
+    Quadric* quadrics;
+    int* versions;
+    bool* is_removed;
+    IntList* triangles_of;
+    int* vertex_of;
+    int* vertex_forward;
+
+    int triangle_count;
+    int (*triangles)[3];
+    bool* is_triangle_removed;
+
+    CollapseHeap heap;
+} Simplifier;
+
+static void push_int(IntList* list, int value) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 8;
+        list->items = realloc(list->items, list->capacity * sizeof(int));
+    }
+    list->items[list->count++] = value;
+}
+
+static void quadric_from_plane(Quadric* quadric, double a, double b, double c, double d, double weight) {
+    quadric->q[0] = a * a * weight;
+    quadric->q[1] = a * b * weight;
+    quadric->q[2] = a * c * weight;
+    quadric->q[3] = a * d * weight;
+    quadric->q[4] = b * b * weight;
+    quadric->q[5] = b * c * weight;
+    quadric->q[6] = b * d * weight;
+    quadric->q[7] = c * c * weight;
+    quadric->q[8] = c * d * weight;
+    quadric->q[9] = d * d * weight;
+}
+
+static void quadric_add(Quadric* quadric, const Quadric* other) {
+    for (int i = 0; i < 10; i++) {
+        quadric->q[i] += other->q[i];
+    }
+}
+
+static double quadric_error(const Quadric* quadric, const double p[3]) {
+    const double* q = quadric->q;
+    double x = p[0], y = p[1], z = p[2];
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+         + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+         + q[7] * z * z + 2 * q[8] * z
+         + q[9];
+}
+
+/**
+ * Solve the gradient of the quadric for the point of minimal error, fails when the system is near singular.
+ */
+static bool quadric_optimum(const Quadric* quadric, double out[3]) {
+    const double* q = quadric->q;
+    double a00 = q[0], a01 = q[1], a02 = q[2];
+    double a11 = q[4], a12 = q[5], a22 = q[7];
+    double b0 = -q[3], b1 = -q[6], b2 = -q[8];
+
+    double c00 = a11 * a22 - a12 * a12;
+    double c01 = a02 * a12 - a01 * a22;
+    double c02 = a01 * a12 - a02 * a11;
+    double det = a00 * c00 + a01 * c01 + a02 * c02;
+
+    double scale = fabs(a00) + fabs(a11) + fabs(a22);
+    if (fabs(det) <= 1e-12 * scale * scale * scale || scale == 0.0) {
+        return false;
+    }
+
+    double c11 = a00 * a22 - a02 * a02;
+    double c12 = a01 * a02 - a00 * a12;
+    double c22 = a00 * a11 - a01 * a01;
+
+    out[0] = (c00 * b0 + c01 * b1 + c02 * b2) / det;
+    out[1] = (c01 * b0 + c11 * b1 + c12 * b2) / det;
+    out[2] = (c02 * b0 + c12 * b1 + c22 * b2) / det;
+    return true;
+}
+
+static void cross(const double u[3], const double v[3], double out[3]) {
+    out[0] = u[1] * v[2] - u[2] * v[1];
+    out[1] = u[2] * v[0] - u[0] * v[2];
+    out[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+static void triangle_normal(const double* p0, const double* p1, const double* p2, double out[3]) {
+    double u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double v[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    cross(u, v, out);
+}
+
+static void heap_push(CollapseHeap* heap, const Collapse* collapse) {
+    if (heap->count == heap->capacity) {
+        heap->capacity = heap->capacity > 0 ? heap->capacity * 2 : 256;
+        heap->items = realloc(heap->items, heap->capacity * sizeof(Collapse));
+    }
+
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->items[parent].cost <= collapse->cost) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = *collapse;
+}
+
+static Collapse heap_pop(CollapseHeap* heap) {
+    Collapse top = heap->items[0];
+    Collapse last = heap->items[--heap->count];
+
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->items[child + 1].cost < heap->items[child].cost) {
+            child++;
+        }
+        if (last.cost <= heap->items[child].cost) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) {
+        heap->items[i] = last;
+    }
+    return top;
+}
+
+static void push_collapse(Simplifier* s, int a, int b) {
+    Collapse collapse;
+    Quadric quadric = s->quadrics[a];
+    quadric_add(&quadric, &s->quadrics[b]);
+
+    const double* pa = s->positions[a];
+    const double* pb = s->positions[b];
+    double midpoint[3] = { (pa[0] + pb[0]) * 0.5, (pa[1] + pb[1]) * 0.5, (pa[2] + pb[2]) * 0.5 };
+    double edge_sq = (pb[0] - pa[0]) * (pb[0] - pa[0]) + (pb[1] - pa[1]) * (pb[1] - pa[1]) + (pb[2] - pa[2]) * (pb[2] - pa[2]);
+
+    double optimum[3];
+    bool has_optimum = quadric_optimum(&quadric, optimum);
+    if (has_optimum) {
+        // Nearly flat neighbourhoods can put the optimum far away from the edge.
+        double dx = optimum[0] - midpoint[0], dy = optimum[1] - midpoint[1], dz = optimum[2] - midpoint[2];
+        has_optimum = dx * dx + dy * dy + dz * dz <= 4.0 * edge_sq;
+    }
+
+    const double* candidates[4] = { pa, pb, midpoint, optimum };
+    int candidate_count = has_optimum ? 4 : 3;
+
+    collapse.cost = INFINITY;
+    for (int i = 0; i < candidate_count; i++) {
+        double error = quadric_error(&quadric, candidates[i]);
+        if (error < collapse.cost) {
+            collapse.cost = error;
+            memcpy(collapse.target, candidates[i], sizeof(collapse.target));
+        }
+    }
+
+    // Prefer short edges where the error is the same, e.g. on flat areas.
+    collapse.cost = fmax(collapse.cost, 0.0) + edge_sq * 1e-6;
+    collapse.a = a;
+    collapse.b = b;
+    collapse.a_version = s->versions[a];
+    collapse.b_version = s->versions[b];
+    heap_push(&s->heap, &collapse);
+}
+
+static bool triangle_has(const int triangle[3], int position) {
+    return triangle[0] == position || triangle[1] == position || triangle[2] == position;
+}
+
+/**
+ * Check whether moving the position to the target flips a triangle not shared with the other endpoint.
+ */
+static bool collapse_flips(const Simplifier* s, int position, int other, const double target[3]) {
+    const IntList* list = &s->triangles_of[position];
+    for (int i = 0; i < list->count; i++) {
+        int t = list->items[i];
+        if (s->is_triangle_removed[t]) continue;
+
+        const int* triangle = s->triangles[t];
+        if (triangle_has(triangle, other)) continue;
+
+        const double* p[3];
+        const double* moved[3];
+        for (int k = 0; k < 3; k++) {
+            p[k] = s->positions[triangle[k]];
+            moved[k] = triangle[k] == position ? target : p[k];
+        }
+
+        double before[3], after[3];
+        triangle_normal(p[0], p[1], p[2], before);
+        triangle_normal(moved[0], moved[1], moved[2], after);
+        if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Move b into a, dropping the triangles of the edge and keeping only live triangles around a.
+ */
+static int collapse_edge(Simplifier* s, const Collapse* collapse) {
+    int a = collapse->a;
+    int b = collapse->b;
+    int removed_triangles = 0;
+    IntList* list_a = &s->triangles_of[a];
+    IntList* list_b = &s->triangles_of[b];
+
+    for (int i = 0; i < list_b->count; i++) {
+        int t = list_b->items[i];
+        if (s->is_triangle_removed[t]) continue;
+
+        int* triangle = s->triangles[t];
+        if (triangle_has(triangle, a)) {
+            s->is_triangle_removed[t] = true;
+            removed_triangles++;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (triangle[k] == b) triangle[k] = a;
+        }
+        push_int(list_a, t);
+    }
+
+    int live = 0;
+    for (int i = 0; i < list_a->count; i++) {
+        if (!s->is_triangle_removed[list_a->items[i]]) {
+            list_a->items[live++] = list_a->items[i];
+        }
+    }
+    list_a->count = live;
+
+    free(list_b->items);
+    memset(list_b, 0, sizeof(IntList));
+
+    // Away from texture and normal seams a position has one vertex, the corners of b can switch to it.
+    if (s->vertex_of[a] >= 0 && s->vertex_of[b] >= 0) {
+        s->vertex_forward[s->vertex_of[b]] = s->vertex_of[a];
+    }
+    else {
+        s->vertex_of[a] = -1;
+    }
+
+    memcpy(s->positions[a], collapse->target, sizeof(s->positions[a]));
+    quadric_add(&s->quadrics[a], &s->quadrics[b]);
+    s->is_removed[b] = true;
+    s->versions[a]++;
+
+    for (int i = 0; i < list_a->count; i++) {
+        const int* triangle = s->triangles[list_a->items[i]];
+        for (int k = 0; k < 3; k++) {
+            if (triangle[k] != a) push_collapse(s, a, triangle[k]);
+        }
+    }
+
+    return removed_triangles;
+}
+
+static unsigned int hash_position(const float position[3]) {
+    unsigned int bits[3];
+    memcpy(bits, position, sizeof(bits));
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < 3; i++) {
+        hash = (hash ^ bits[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Share one position between the vertices which only differ in their normal or texture coordinates.
+ */
+static int* weld_positions(const Mesh* mesh, Simplifier* s) {
+    int* position_of = malloc(mesh->vertex_count * sizeof(int));
+    int capacity = 16;
+    while (capacity < mesh->vertex_count * 2) {
+        capacity *= 2;
+    }
+    int* table = malloc(capacity * sizeof(int));
+    memset(table, -1, capacity * sizeof(int));
+
+    s->positions = malloc(mesh->vertex_count * sizeof(*s->positions));
+    s->position_count = 0;
+
+    for (int i = 0; i < mesh->vertex_count; i++) {
+        const float* position = mesh->vertices[i].position;
+        unsigned int slot = hash_position(position) & (capacity - 1);
+        while (table[slot] >= 0 && memcmp(mesh->vertices[table[slot]].position, position, sizeof(float) * 3) != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (table[slot] < 0) {
+            table[slot] = i;
+            for (int k = 0; k < 3; k++) {
+                s->positions[s->position_count][k] = position[k];
+            }
+            position_of[i] = s->position_count++;
+        }
+        else {
+            position_of[i] = position_of[table[slot]];
+        }
+    }
+
+    free(table);
+    return position_of;
+}
+
+static int compare_edges(const void* x, const void* y) {
+    const Edge* e = x;
+    const Edge* f = y;
+    if (e->a != f->a) return e->a < f->a ? -1 : 1;
+    if (e->b != f->b) return e->b < f->b ? -1 : 1;
+    return 0;
+}
+
+static void add_border_quadric(Simplifier* s, const Edge* edge) {
+    const int* triangle = s->triangles[edge->triangle];
+    const double* pa = s->positions[edge->a];
+    const double* pb = s->positions[edge->b];
+    double normal[3], direction[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+    double plane[3];
+    Quadric quadric;
+
+    triangle_normal(s->positions[triangle[0]], s->positions[triangle[1]], s->positions[triangle[2]], normal);
+    cross(direction, normal, plane);
+
+    double length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    if (length <= 0.0) return;
+    for (int k = 0; k < 3; k++) {
+        plane[k] /= length;
+    }
+
+    double d = -(plane[0] * pa[0] + plane[1] * pa[1] + plane[2] * pa[2]);
+    double edge_sq = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+    quadric_from_plane(&quadric, plane[0], plane[1], plane[2], d, BORDER_WEIGHT * edge_sq);
+    quadric_add(&s->quadrics[edge->a], &quadric);
+    quadric_add(&s->quadrics[edge->b], &quadric);
+}
+
+/**
+ * Area weighted plane quadrics of the faces and the border constraints, then the initial edge costs.
+ */
+static void init_simplifier(Simplifier* s) {
+    int edge_count = 0;
+    Edge* edges = malloc(s->triangle_count * 3 * sizeof(Edge));
+
+    for (int t = 0; t < s->triangle_count; t++) {
+        if (s->is_triangle_removed[t]) continue;
+
+        const int* triangle = s->triangles[t];
+        double normal[3];
+        Quadric quadric;
+
+        triangle_normal(s->positions[triangle[0]], s->positions[triangle[1]], s->positions[triangle[2]], normal);
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0) {
+            const double* p0 = s->positions[triangle[0]];
+            double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+            double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+            quadric_from_plane(&quadric, a, b, c, d, length * 0.5);
+            for (int k = 0; k < 3; k++) {
+                quadric_add(&s->quadrics[triangle[k]], &quadric);
+            }
+        }
+
+        for (int k = 0; k < 3; k++) {
+            int a = triangle[k], b = triangle[(k + 1) % 3];
+            edges[edge_count++] = (Edge){ a < b ? a : b, a < b ? b : a, t };
+            push_int(&s->triangles_of[a], t);
+        }
+    }
+
+    qsort(edges, edge_count, sizeof(Edge), compare_edges);
+
+    for (int i = 0; i < edge_count;) {
+        int j = i + 1;
+        while (j < edge_count && compare_edges(&edges[i], &edges[j]) == 0) {
+            j++;
+        }
+        if (j - i == 1) {
+            add_border_quadric(s, &edges[i]);
+        }
+        i = j;
+    }
+
+    for (int i = 0; i < edge_count;) {
+        int j = i + 1;
+        while (j < edge_count && compare_edges(&edges[i], &edges[j]) == 0) {
+            j++;
+        }
+        push_collapse(s, edges[i].a, edges[i].b);
+        i = j;
+    }
+
+    free(edges);
+}
+
+static void free_simplifier(Simplifier* s) {
+    for (int i = 0; i < s->position_count; i++) {
+        free(s->triangles_of[i].items);
+    }
+    free(s->triangles_of);
+    free(s->positions);
+    free(s->quadrics);
+    free(s->versions);
+    free(s->is_removed);
+    free(s->vertex_of);
+    free(s->vertex_forward);
+    free(s->triangles);
+    free(s->is_triangle_removed);
+    free(s->heap.items);
+}
+
+void simplify_mesh(const Mesh* source, Mesh* result, int target_triangles) {
+    Simplifier s;
+    memset(&s, 0, sizeof(Simplifier));
+
+    int* position_of = weld_positions(source, &s);
+    s.quadrics = calloc(s.position_count, sizeof(Quadric));
+    s.versions = calloc(s.position_count, sizeof(int));
+    s.is_removed = calloc(s.position_count, sizeof(bool));
+    s.triangles_of = calloc(s.position_count, sizeof(IntList));
+
+    s.vertex_of = malloc(s.position_count * sizeof(int));
+    s.vertex_forward = malloc(source->vertex_count * sizeof(int));
+    memset(s.vertex_forward, -1, source->vertex_count * sizeof(int));
+    for (int p = 0; p < s.position_count; p++) {
+        s.vertex_of[p] = -2;
+    }
+    for (int i = 0; i < source->vertex_count; i++) {
+        int p = position_of[i];
+        s.vertex_of[p] = s.vertex_of[p] == -2 || s.vertex_of[p] == i ? i : -1;
+    }
+
+    s.triangle_count = source->index_count / 3;
+    s.triangles = malloc(s.triangle_count * sizeof(*s.triangles));
+    s.is_triangle_removed = calloc(s.triangle_count, sizeof(bool));
+    for (int t = 0; t < s.triangle_count; t++) {
+        int* triangle = s.triangles[t];
+        for (int k = 0; k < 3; k++) {
+            triangle[k] = position_of[source->indices[t * 3 + k]];
+        }
+        s.is_triangle_removed[t] = triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2];
+    }
+
+    init_simplifier(&s);
+
+    int live_triangles = 0;
+    for (int t = 0; t < s.triangle_count; t++) {
+        if (!s.is_triangle_removed[t]) live_triangles++;
+    }
+
+    while (live_triangles > target_triangles && s.heap.count > 0) {
+        Collapse collapse = heap_pop(&s.heap);
+        if (s.is_removed[collapse.a] || s.is_removed[collapse.b]) continue;
+        if (s.versions[collapse.a] != collapse.a_version || s.versions[collapse.b] != collapse.b_version) continue;
+        if (collapse_flips(&s, collapse.a, collapse.b, collapse.target)) continue;
+        if (collapse_flips(&s, collapse.b, collapse.a, collapse.target)) continue;
+
+        live_triangles -= collapse_edge(&s, &collapse);
+    }
+
+    // Seam corners keep their normals and texture coordinates, only their positions move.
+    int* remap = malloc(source->vertex_count * sizeof(int));
+    memset(remap, -1, source->vertex_count * sizeof(int));
+    result->vertices = malloc(source->vertex_count * sizeof(MeshVertex));
+    result->indices = malloc(live_triangles * 3 * sizeof(GLuint));
+    result->vertex_count = 0;
+    result->index_count = 0;
+
+    for (int t = 0; t < s.triangle_count; t++) {
+        if (s.is_triangle_removed[t]) continue;
+
+        for (int k = 0; k < 3; k++) {
+            int vertex = source->indices[t * 3 + k];
+            while (s.vertex_forward[vertex] >= 0) {
+                vertex = s.vertex_forward[vertex];
+            }
+            if (remap[vertex] < 0) {
+                MeshVertex* out = &result->vertices[result->vertex_count];
+                *out = source->vertices[vertex];
+                for (int c = 0; c < 3; c++) {
+                    out->position[c] = (float)s.positions[s.triangles[t][k]][c];
+                }
+                remap[vertex] = result->vertex_count++;
+            }
+            result->indices[result->index_count++] = remap[vertex];
+        }
+    }
+
+    free(remap);
+    free(position_of);
+    free_simplifier(&s);
+}
+
+void build_lod_chain(LodChain* lod, Mesh* mesh) {
+    memset(lod, 0, sizeof(LodChain));
+
+    lod->levels[0] = *mesh;
+    memset(mesh, 0, sizeof(Mesh));
+    lod->triangle_counts[0] = lod->levels[0].index_count / 3;
+    lod->level_count = 1;
+
+    float radius_sq = 0.0f;
+    for (int i = 0; i < lod->levels[0].vertex_count; i++) {
+        const float* p = lod->levels[0].vertices[i].position;
+        radius_sq = fmaxf(radius_sq, p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    }
+    lod->radius = sqrtf(radius_sq);
+
+    int full_triangles = lod->triangle_counts[0];
+    for (int level = 1; level < MAX_LOD_LEVELS; level++) {
+        int previous = lod->triangle_counts[level - 1];
+        int target = (int)(full_triangles * LOD_RATIOS[level]);
+        if (previous < LOD_MIN_TRIANGLES || target < LOD_MIN_TRIANGLES / 2) break;
+
+        Mesh* mesh = &lod->levels[level];
+        simplify_mesh(&lod->levels[0], mesh, target);
+
+        // Stop when the simplifier got stuck, the level would not be worth a switch.
+        int triangles = mesh->index_count / 3;
+        if (triangles > previous * 0.8f) {
+            free_mesh(mesh);
+            break;
+        }
+
+        // The simplifier keeps the order of the full mesh, the removed triangles leave holes in it.
+        optimize_vertex_cache(mesh);
+        optimize_vertex_fetch(mesh);
+
+        lod->triangle_counts[level] = triangles;
+        lod->level_count++;
+    }
+}
+
+float projected_screen_size(const Camera* camera, Vec3 center, float radius) {
+    float distance = vec3_length(vec3_substract(center, camera->position));
+    if (distance <= radius) {
+        return 1.0f;
+    }
+
+    float half_height = distance * tanf(degree_to_radian(camera->fov) * 0.5f);
+    return radius / half_height;
+}
+
+int select_lod_level(LodChain* lod, float screen_size) {
+    int level = lod->current;
+
+    while (level + 1 < lod->level_count && screen_size < LOD_SCREEN_SIZES[level + 1] * (1.0f - LOD_HYSTERESIS)) {
+        level++;
+    }
+    while (level > 0 && screen_size > LOD_SCREEN_SIZES[level] * (1.0f + LOD_HYSTERESIS)) {
+        level--;
+    }
+
+    lod->current = level;
+    return level;
+}
+
+size_t get_lod_chain_cpu_memory(const LodChain* lod) {
+    size_t bytes = 0;
+    for (int i = 0; i < lod->level_count; i++) {
+        bytes += lod->levels[i].vertex_count * sizeof(MeshVertex) + lod->levels[i].index_count * sizeof(GLuint);
+    }
+    return bytes;
+}
+
+size_t get_lod_chain_memory(const LodChain* lod) {
+    return get_lod_chain_cpu_memory(lod) + lod->display_list_bytes;
+}
+
+size_t trim_lod_chain(LodChain* lod) {
+    size_t bytes = get_lod_chain_cpu_memory(lod);
+    for (int i = 0; i < lod->level_count; i++) {
+        if (lod->mapping.data == NULL) {
+            free_mesh(&lod->levels[i]);
+        }
+        memset(&lod->levels[i], 0, sizeof(Mesh));
+    }
+    unmap_file(&lod->mapping);
+    return bytes;
+}
+
+void free_lod_chain(LodChain* lod) {
+    for (int i = 0; i < lod->level_count; i++) {
+        if (lod->display_lists[i] != 0) {
+            glDeleteLists(lod->display_lists[i], 1);
+        }
+        if (lod->mapping.data == NULL) {
+            free_mesh(&lod->levels[i]);
+        }
+    }
+    unmap_file(&lod->mapping);
+    lod->level_count = 0;
+    lod->display_list_bytes = 0;
+}
@@ -1,4 +1,8 @@
 #include "app.h"
+#include "bake.h"
+#include "benchmark.h"
+#include "config_bundle.h"
+#include "profiler.h"
 
 #include <stdio.h>
 
@@ -6,17 +10,43 @@
  * Main function
  */
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
     App app;
+    AppOptions options;
 
-    init_app(&app, 1200, 1000);
+    parse_app_options(&options, argc, argv);
+    if (options.trace_path != NULL) {
+        start_trace(options.trace_path, options.trace_frames);
+    }
+    if (options.obj_bench_path != NULL) {
+        run_obj_benchmark(options.obj_bench_path);
+        return 0;
+    }
+    if (options.config_bench_path != NULL) {
+        run_config_benchmark(options.config_bench_path);
+        return 0;
+    }
+    if (options.bake) {
+        bool is_baked = bake_object_meshes("config/object_config.json");
+        is_baked = bake_textures("config/room_config.json", "config/object_config.json") && is_baked;
+        is_baked = compile_config_bundle("config/room_config.json", "config/object_config.json",
+            "config/light_config.json") && is_baked;
+        finish_trace();
+        return is_baked ? 0 : 1;
+    }
+
+    TRACE_ZONE("Init app", init_app(&app, 1200, 1000, &options));
     while (app.is_running) {
-        handle_app_events(&app);
+        PROFILE(PROFILE_EVENTS, handle_app_events(&app));
+        if (is_app_idle(&app)) {
+            idle_app(&app);
+            continue;
+        }
         update_app(&app);
         render_app(&app);
+        wait_for_next_frame(&app.pacer);
     }
     destroy_app(&app);
+    finish_trace();
 
     return 0;
 }
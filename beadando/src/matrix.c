@@ -0,0 +1,231 @@
+#include "matrix.h"
+#include <math.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+void mat4_identity(Mat4* out) {
+    memset(out->m, 0, sizeof(out->m));
+    out->m[0] = 1.0f;
+    out->m[5] = 1.0f;
+    out->m[10] = 1.0f;
+    out->m[15] = 1.0f;
+}
+
+void mat4_translation(Mat4* out, Vec3 offset) {
+    mat4_identity(out);
+    out->m[12] = offset.x;
+    out->m[13] = offset.y;
+    out->m[14] = offset.z;
+}
+
+void mat4_from_quat(Mat4* out, Quat q, Vec3 translation) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    float* m = out->m;
+    m[0] = 1.0f - 2.0f * (yy + zz);
+    m[1] = 2.0f * (xy + wz);
+    m[2] = 2.0f * (xz - wy);
+    m[3] = 0.0f;
+    m[4] = 2.0f * (xy - wz);
+    m[5] = 1.0f - 2.0f * (xx + zz);
+    m[6] = 2.0f * (yz + wx);
+    m[7] = 0.0f;
+    m[8] = 2.0f * (xz + wy);
+    m[9] = 2.0f * (yz - wx);
+    m[10] = 1.0f - 2.0f * (xx + yy);
+    m[11] = 0.0f;
+    m[12] = translation.x;
+    m[13] = translation.y;
+    m[14] = translation.z;
+    m[15] = 1.0f;
+}
+
+void mat4_perspective(Mat4* out, float fov, float aspect_ratio, float near_plane, float far_plane) {
+    float f = 1.0f / tanf(degree_to_radian(fov) * 0.5f);
+
+    memset(out->m, 0, sizeof(out->m));
+    out->m[0] = f / aspect_ratio;
+    out->m[5] = f;
+    out->m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+    out->m[11] = -1.0f;
+    out->m[14] = 2.0f * far_plane * near_plane / (near_plane - far_plane);
+}
+
+void mat4_look_at(Mat4* out, Vec3 eye, Vec3 target, Vec3 up) {
+    Vec3 f = vec3_substract(target, eye);
+    vec3_normalize(&f);
+    Vec3 s = { f.y * up.z - f.z * up.y, f.z * up.x - f.x * up.z, f.x * up.y - f.y * up.x };
+    vec3_normalize(&s);
+    Vec3 u = { s.y * f.z - s.z * f.y, s.z * f.x - s.x * f.z, s.x * f.y - s.y * f.x };
+
+    float* m = out->m;
+    m[0] = s.x;  m[4] = s.y;  m[8] = s.z;
+    m[1] = u.x;  m[5] = u.y;  m[9] = u.z;
+    m[2] = -f.x; m[6] = -f.y; m[10] = -f.z;
+    m[3] = 0.0f; m[7] = 0.0f; m[11] = 0.0f;
+    m[12] = -vec3_dot(s, eye);
+    m[13] = -vec3_dot(u, eye);
+    m[14] = vec3_dot(f, eye);
+    m[15] = 1.0f;
+}
+
+/**
+ * Column j of a * b is the combination of the columns of a weighted by column j of b.
+ */
+static inline __m128 combine_columns(const __m128 a[4], const float* b) {
+    __m128 r = _mm_mul_ps(a[0], _mm_set1_ps(b[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(a[1], _mm_set1_ps(b[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(a[2], _mm_set1_ps(b[2])));
+    return _mm_add_ps(r, _mm_mul_ps(a[3], _mm_set1_ps(b[3])));
+}
+
+static inline void load_columns(__m128 columns[4], const Mat4* m) {
+    for (int i = 0; i < 4; i++) {
+        columns[i] = _mm_load_ps(&m->m[i * 4]);
+    }
+}
+
+void mat4_multiply(Mat4* out, const Mat4* a, const Mat4* b) {
+    __m128 columns[4];
+    __m128 result[4];
+    load_columns(columns, a);
+    for (int j = 0; j < 4; j++) {
+        result[j] = combine_columns(columns, &b->m[j * 4]);
+    }
+    for (int j = 0; j < 4; j++) {
+        _mm_store_ps(&out->m[j * 4], result[j]);
+    }
+}
+
+void mat4_multiply_batch(Mat4* out, const Mat4* a, const Mat4* b, int count) {
+    __m128 columns[4];
+    load_columns(columns, a);
+    for (int i = 0; i < count; i++) {
+        __m128 result[4];
+        for (int j = 0; j < 4; j++) {
+            result[j] = combine_columns(columns, &b[i].m[j * 4]);
+        }
+        for (int j = 0; j < 4; j++) {
+            _mm_store_ps(&out[i].m[j * 4], result[j]);
+        }
+    }
+}
+
+Vec4 mat4_transform(const Mat4* m, Vec4 v) {
+    __m128 columns[4];
+    load_columns(columns, m);
+    float in[4] = { v.x, v.y, v.z, v.w };
+
+    Vec4 result;
+    _mm_storeu_ps(&result.x, combine_columns(columns, in));
+    return result;
+}
+
+void mat4_transform_points(const Mat4* m, const Vec3* points, Vec4* out, int count) {
+    __m128 columns[4];
+    load_columns(columns, m);
+    for (int i = 0; i < count; i++) {
+        float in[4] = { points[i].x, points[i].y, points[i].z, 1.0f };
+        _mm_storeu_ps(&out[i].x, combine_columns(columns, in));
+    }
+}
+
+bool mat4_inverse(Mat4* out, const Mat4* matrix) {
+    const float* m = matrix->m;
+    float inv[16];
+
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15]
+           + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15]
+           - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15]
+           + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14]
+            - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15]
+           - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15]
+           + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15]
+           - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14]
+            + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15]
+           + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15]
+           - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15]
+            + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14]
+            - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11]
+           - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11]
+           + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11]
+            - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10]
+            + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (fabsf(det) < EPSILON) {
+        return false;
+    }
+
+    __m128 scale = _mm_set1_ps(1.0f / det);
+    for (int i = 0; i < 4; i++) {
+        _mm_store_ps(&out->m[i * 4], _mm_mul_ps(_mm_loadu_ps(&inv[i * 4]), scale));
+    }
+    return true;
+}
+
+bool mat4_normal_matrix(float out[9], const Mat4* matrix) {
+    const float* m = matrix->m;
+    Vec3 a = { m[0], m[1], m[2] };
+    Vec3 b = { m[4], m[5], m[6] };
+    Vec3 c = { m[8], m[9], m[10] };
+
+    // The columns of the inverse transpose are the cross products of the columns over the determinant.
+    Vec3 bc = { b.y * c.z - b.z * c.y, b.z * c.x - b.x * c.z, b.x * c.y - b.y * c.x };
+    Vec3 ca = { c.y * a.z - c.z * a.y, c.z * a.x - c.x * a.z, c.x * a.y - c.y * a.x };
+    Vec3 ab = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+
+    float det = vec3_dot(a, bc);
+    if (fabsf(det) < EPSILON) {
+        return false;
+    }
+
+    float inv_det = 1.0f / det;
+    const Vec3 columns[3] = { bc, ca, ab };
+    for (int i = 0; i < 3; i++) {
+        out[i * 3] = columns[i].x * inv_det;
+        out[i * 3 + 1] = columns[i].y * inv_det;
+        out[i * 3 + 2] = columns[i].z * inv_det;
+    }
+    return true;
+}
+
+Quat quat_from_axis_angle(Vec3 axis, float angle) {
+    float half = degree_to_radian(angle) * 0.5f;
+    float s = sinf(half);
+    return (Quat){ axis.x * s, axis.y * s, axis.z * s, cosf(half) };
+}
+
+Quat quat_multiply(Quat a, Quat b) {
+    return (Quat){
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+}
+
+Quat quat_normalize(Quat q) {
+    float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (length < EPSILON) {
+        return (Quat){ 0.0f, 0.0f, 0.0f, 1.0f };
+    }
+    return (Quat){ q.x / length, q.y / length, q.z / length, q.w / length };
+}
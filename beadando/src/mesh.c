@@ -0,0 +1,104 @@
+#include "mesh.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Open addressing table from (vertex, texture, normal) index triples to mesh vertices.
+ */
+typedef struct FacePointMap {
+    FacePoint* keys;
+    int* values;
+    int capacity;
+} FacePointMap;
+
+static unsigned int hash_face_point(const FacePoint* point) {
+    unsigned int hash = 2166136261u;
+    hash = (hash ^ (unsigned int)point->vertex_index) * 16777619u;
+    hash = (hash ^ (unsigned int)point->texture_index) * 16777619u;
+    hash = (hash ^ (unsigned int)point->normal_index) * 16777619u;
+    return hash;
+}
+
+static int find_or_add_face_point(FacePointMap* map, const FacePoint* point, int next_value) {
+    unsigned int slot = hash_face_point(point) & (map->capacity - 1);
+    while (map->values[slot] >= 0) {
+        const FacePoint* key = &map->keys[slot];
+        if (key->vertex_index == point->vertex_index &&
+            key->texture_index == point->texture_index &&
+            key->normal_index == point->normal_index) {
+            return map->values[slot];
+        }
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    map->keys[slot] = *point;
+    map->values[slot] = next_value;
+    return next_value;
+}
+
+static void set_mesh_vertex(MeshVertex* vertex, const Model* model, const FacePoint* point) {
+    const Vertex* position = &model->vertices[point->vertex_index];
+    const Vertex* normal = &model->normals[point->normal_index];
+    const TextureVertex* uv = &model->texture_vertices[point->texture_index];
+
+    vertex->position[0] = (float)position->x;
+    vertex->position[1] = (float)position->y;
+    vertex->position[2] = (float)position->z;
+    vertex->normal[0] = (float)normal->x;
+    vertex->normal[1] = (float)normal->y;
+    vertex->normal[2] = (float)normal->z;
+    // Flipped like draw_model, OBJ texture coordinates start at the bottom.
+    vertex->uv[0] = (float)uv->u;
+    vertex->uv[1] = 1.0f - (float)uv->v;
+}
+
+void mesh_from_model(Mesh* mesh, const Model* model) {
+    int corner_count = model->n_triangles * 3;
+    FacePointMap map;
+
+    mesh->vertices = malloc(corner_count * sizeof(MeshVertex));
+    mesh->indices = malloc(corner_count * sizeof(GLuint));
+    mesh->vertex_count = 0;
+    mesh->index_count = 0;
+
+    map.capacity = 16;
+    while (map.capacity < corner_count * 2) {
+        map.capacity *= 2;
+    }
+    map.keys = malloc(map.capacity * sizeof(FacePoint));
+    map.values = malloc(map.capacity * sizeof(int));
+    memset(map.values, -1, map.capacity * sizeof(int));
+
+    for (int i = 0; i < model->n_triangles; i++) {
+        for (int k = 0; k < 3; k++) {
+            const FacePoint* point = &model->triangles[i].points[k];
+            int index = find_or_add_face_point(&map, point, mesh->vertex_count);
+            if (index == mesh->vertex_count) {
+                set_mesh_vertex(&mesh->vertices[mesh->vertex_count++], model, point);
+            }
+            mesh->indices[mesh->index_count++] = index;
+        }
+    }
+
+    free(map.keys);
+    free(map.values);
+}
+
+void draw_mesh(const Mesh* mesh) {
+    glBegin(GL_TRIANGLES);
+    for (int i = 0; i < mesh->index_count; i++) {
+        const MeshVertex* vertex = &mesh->vertices[mesh->indices[i]];
+        glNormal3fv(vertex->normal);
+        glTexCoord2fv(vertex->uv);
+        glVertex3fv(vertex->position);
+    }
+    glEnd();
+}
+
+void free_mesh(Mesh* mesh) {
+    free(mesh->vertices);
+    free(mesh->indices);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+    mesh->vertex_count = 0;
+    mesh->index_count = 0;
+}
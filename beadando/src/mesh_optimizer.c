@@ -0,0 +1,244 @@
+#include "mesh_optimizer.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Adding zero turns -0 into +0, so the two compare equal bitwise.
+ */
+static void canonicalize_vertex(MeshVertex* vertex) {
+    float* values = (float*)vertex;
+    for (int i = 0; i < (int)(sizeof(MeshVertex) / sizeof(float)); i++) {
+        values[i] += 0.0f;
+    }
+}
+
+static unsigned int hash_vertex(const MeshVertex* vertex) {
+    unsigned int bits[sizeof(MeshVertex) / sizeof(unsigned int)];
+    memcpy(bits, vertex, sizeof(bits));
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < (int)(sizeof(bits) / sizeof(bits[0])); i++) {
+        hash = (hash ^ bits[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int weld_mesh_vertices(Mesh* mesh) {
+    int capacity = 16;
+    while (capacity < mesh->vertex_count * 2) {
+        capacity *= 2;
+    }
+    int* slots = malloc(capacity * sizeof(int));
+    int* remap = malloc((mesh->vertex_count > 0 ? mesh->vertex_count : 1) * sizeof(int));
+    memset(slots, -1, capacity * sizeof(int));
+
+    int welded = 0;
+    for (int i = 0; i < mesh->vertex_count; i++) {
+        MeshVertex* vertex = &mesh->vertices[i];
+        canonicalize_vertex(vertex);
+
+        unsigned int slot = hash_vertex(vertex) & (capacity - 1);
+        while (slots[slot] >= 0 && memcmp(&mesh->vertices[slots[slot]], vertex, sizeof(MeshVertex)) != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (slots[slot] < 0) {
+            slots[slot] = i;
+        }
+        else {
+            welded++;
+        }
+        remap[i] = slots[slot];
+    }
+
+    for (int i = 0; i < mesh->index_count; i++) {
+        mesh->indices[i] = (GLuint)remap[mesh->indices[i]];
+    }
+
+    free(slots);
+    free(remap);
+    return welded;
+}
+
+/**
+ * Score of a vertex by its position in the LRU cache and the count of its triangles not yet emitted.
+ * The last triangle's vertices get a fixed score, so the next triangle does not just reuse all three of them.
+ */
+static float vertex_score(int cache_position, int live_triangles) {
+    if (live_triangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        score = cache_position < 3 ? 0.75f
+            : powf(1.0f - (float)(cache_position - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+    // Vertices with few triangles left are preferred, finishing them frees up the cache.
+    return score + 2.0f / sqrtf((float)live_triangles);
+}
+
+static void remove_live_triangle(int* triangles, int* live, int triangle) {
+    for (int i = 0; i < *live; i++) {
+        if (triangles[i] == triangle) {
+            triangles[i] = triangles[--(*live)];
+            return;
+        }
+    }
+}
+
+void optimize_vertex_cache(Mesh* mesh) {
+    int triangle_count = mesh->index_count / 3;
+    int vertex_count = mesh->vertex_count;
+    if (triangle_count == 0) return;
+
+    // The triangles of each vertex, the live ones are kept at the start of its range.
+    int* live = calloc(vertex_count, sizeof(int));
+    int* offsets = malloc((vertex_count + 1) * sizeof(int));
+    int* adjacency = malloc(triangle_count * 3 * sizeof(int));
+    int* cache_position = malloc(vertex_count * sizeof(int));
+    float* scores = malloc(vertex_count * sizeof(float));
+    bool* is_emitted = calloc(triangle_count, sizeof(bool));
+    GLuint* result = malloc(triangle_count * 3 * sizeof(GLuint));
+
+    for (int i = 0; i < triangle_count * 3; i++) {
+        live[mesh->indices[i]]++;
+    }
+    offsets[0] = 0;
+    for (int v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+        cache_position[v] = offsets[v];
+    }
+    for (int i = 0; i < triangle_count * 3; i++) {
+        adjacency[cache_position[mesh->indices[i]]++] = i / 3;
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        cache_position[v] = -1;
+        scores[v] = vertex_score(-1, live[v]);
+    }
+
+    int cache[VERTEX_CACHE_SIZE + 3];
+    int cache_count = 0;
+    int best = -1;
+    int next_unemitted = 0;
+
+    for (int emitted = 0; emitted < triangle_count; emitted++) {
+        // With no candidate in the cache the order continues from the first triangle not emitted yet.
+        if (best < 0) {
+            while (is_emitted[next_unemitted]) next_unemitted++;
+            best = next_unemitted;
+        }
+
+        const GLuint* triangle = &mesh->indices[best * 3];
+        memcpy(&result[emitted * 3], triangle, 3 * sizeof(GLuint));
+        is_emitted[best] = true;
+
+        int new_cache[VERTEX_CACHE_SIZE + 3];
+        int new_count = 0;
+        for (int k = 0; k < 3; k++) {
+            int v = (int)triangle[k];
+            remove_live_triangle(&adjacency[offsets[v]], &live[v], best);
+            // Degenerate triangles repeat a vertex, it takes one cache entry.
+            bool is_repeated = false;
+            for (int j = 0; j < new_count; j++) {
+                if (new_cache[j] == v) is_repeated = true;
+            }
+            if (!is_repeated) new_cache[new_count++] = v;
+        }
+        for (int i = 0; i < cache_count; i++) {
+            int v = cache[i];
+            if (v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2]) {
+                new_cache[new_count++] = v;
+            }
+        }
+
+        // The vertices pushed past the end of the cache are rescored too, then the best triangle is chosen.
+        for (int i = 0; i < new_count; i++) {
+            int v = new_cache[i];
+            cache_position[v] = i < VERTEX_CACHE_SIZE ? i : -1;
+            scores[v] = vertex_score(cache_position[v], live[v]);
+        }
+
+        best = -1;
+        float best_score = -1.0f;
+        for (int i = 0; i < new_count && i < VERTEX_CACHE_SIZE; i++) {
+            int v = new_cache[i];
+            for (int j = 0; j < live[v]; j++) {
+                int t = adjacency[offsets[v] + j];
+                const GLuint* candidate = &mesh->indices[t * 3];
+                float score = scores[candidate[0]] + scores[candidate[1]] + scores[candidate[2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = new_count < VERTEX_CACHE_SIZE ? new_count : VERTEX_CACHE_SIZE;
+        memcpy(cache, new_cache, cache_count * sizeof(int));
+    }
+
+    free(mesh->indices);
+    mesh->indices = result;
+
+    free(live);
+    free(offsets);
+    free(adjacency);
+    free(cache_position);
+    free(scores);
+    free(is_emitted);
+}
+
+void optimize_vertex_fetch(Mesh* mesh) {
+    int* remap = malloc((mesh->vertex_count > 0 ? mesh->vertex_count : 1) * sizeof(int));
+    MeshVertex* vertices = malloc((mesh->vertex_count > 0 ? mesh->vertex_count : 1) * sizeof(MeshVertex));
+    memset(remap, -1, mesh->vertex_count * sizeof(int));
+
+    int vertex_count = 0;
+    for (int i = 0; i < mesh->index_count; i++) {
+        int v = (int)mesh->indices[i];
+        if (remap[v] < 0) {
+            remap[v] = vertex_count;
+            vertices[vertex_count++] = mesh->vertices[v];
+        }
+        mesh->indices[i] = (GLuint)remap[v];
+    }
+
+    free(remap);
+    free(mesh->vertices);
+    mesh->vertices = realloc(vertices, (vertex_count > 0 ? vertex_count : 1) * sizeof(MeshVertex));
+    mesh->vertex_count = vertex_count;
+}
+
+float calculate_acmr(const Mesh* mesh, int cache_size) {
+    int triangle_count = mesh->index_count / 3;
+    if (triangle_count == 0) return 0.0f;
+
+    // A vertex is in the FIFO while fewer than cache_size misses happened since it was loaded.
+    int* loaded_at = calloc(mesh->vertex_count > 0 ? mesh->vertex_count : 1, sizeof(int));
+    int time = cache_size + 1;
+    int misses = 0;
+    for (int i = 0; i < mesh->index_count; i++) {
+        int v = (int)mesh->indices[i];
+        if (time - loaded_at[v] > cache_size) {
+            loaded_at[v] = time++;
+            misses++;
+        }
+    }
+
+    free(loaded_at);
+    return (float)misses / triangle_count;
+}
+
+void optimize_mesh(Mesh* mesh, MeshOptimizationStats* stats) {
+    MeshOptimizationStats local;
+    if (stats == NULL) stats = &local;
+
+    stats->vertex_count_before = mesh->vertex_count;
+    stats->acmr_before = calculate_acmr(mesh, ACMR_CACHE_SIZE);
+
+    weld_mesh_vertices(mesh);
+    optimize_vertex_cache(mesh);
+    optimize_vertex_fetch(mesh);
+
+    stats->vertex_count_after = mesh->vertex_count;
+    stats->acmr_after = calculate_acmr(mesh, ACMR_CACHE_SIZE);
+}
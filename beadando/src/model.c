@@ -1,37 +1,21 @@
 #include "model.h"
 #include <GL/gl.h>
 #include <math.h>
-
-void vertex_normalize(Vertex* v) {
-    double len = sqrt(v->x*v->x + v->y*v->y + v->z*v->z);
-    if (len > 1e-6) {
-        v->x /= len;
-        v->y /= len;
-        v->z /= len;
-    }
-}
-
-void scale_model(Model* model, Vec3 scale) {
-    for (int i = 1; i <= model->n_vertices; ++i) {
-        model->vertices[i].x *= scale.x;
-        model->vertices[i].y *= scale.y;
-        model->vertices[i].z *= scale.z;
-    }
-
-    float inv_x = 1.0f / scale.x;
-    float inv_y = 1.0f / scale.y;
-    float inv_z = 1.0f / scale.z;
-
-    for (int i = 1; i <= model->n_normals; ++i) {
-        Vertex* n = &model->normals[i];
-        n->x *= inv_x;
-        n->y *= inv_y;
-        n->z *= inv_z;
-        vertex_normalize(n);
-    }
+#include <string.h>
+#include <xmmintrin.h>
+
+static void rotate_vector(double* v, double cx, double sx, double cy, double sy, double cz, double sz) {
+    double x = v[0], y = v[1], z = v[2];
+    double y1 = y * cx - z * sx, z1 = y * sx + z * cx;
+    double x2 = x * cy + z1 * sy, z2 = -x * sy + z1 * cy;
+    double x3 = x2 * cz - y1 * sz, y3 = x2 * sz + y1 * cz;
+    v[0] = x3; v[1] = y3; v[2] = z2;
 }
 
-void rotate_model(Model* model, Vec3 rotation) {
+/**
+ * Columns of the rotation around the x, then y, then z axis, in degrees.
+ */
+static void rotation_columns(Vec3 rotation, double columns[3][3]) {
     double rx = degree_to_radian(rotation.x),
            ry = degree_to_radian(rotation.y),
            rz = degree_to_radian(rotation.z);
@@ -39,61 +23,136 @@ void rotate_model(Model* model, Vec3 rotation) {
     double cy = cos(ry), sy = sin(ry);
     double cz = cos(rz), sz = sin(rz);
 
-    for (int i = 1; i <= model->n_vertices; ++i) {
-        Vertex* v = &model->vertices[i];
-        double x = v->x, y = v->y, z = v->z;
-        double y1 = y * cx - z * sx, z1 = y * sx + z * cx;
-        double x2 = x * cy + z1 * sy, z2 = -x * sy + z1 * cy;
-        double x3 = x2 * cz - y1 * sz, y3 = x2 * sz + y1 * cz;
-        v->x = x3; v->y = y3; v->z = z2;
+    for (int i = 0; i < 3; i++) {
+        columns[i][0] = i == 0;
+        columns[i][1] = i == 1;
+        columns[i][2] = i == 2;
+        rotate_vector(columns[i], cx, sx, cy, sy, cz, sz);
     }
+}
 
-    for (int i = 1; i <= model->n_normals; ++i) {
-        Vertex* n = &model->normals[i];
-        double x = n->x, y = n->y, z = n->z;
-        double y1 = y * cx - z * sx, z1 = y * sx + z * cx;
-        double x2 = x * cy + z1 * sy, z2 = -x * sy + z1 * cy;
-        double x3 = x2 * cz - y1 * sz, y3 = x2 * sz + y1 * cz;
-        n->x = x3; n->y = y3; n->z = z2;
-        vertex_normalize(n);
+/**
+ * The 3x3 matrices and the translation of the vertex transform, each element broadcast to the four lanes.
+ */
+typedef struct MeshTransform {
+    __m128 position[9];
+    __m128 translation[3];
+    __m128 normal[9];
+} MeshTransform;
+
+/**
+ * Transform four vertices, transposed into x, y, z registers. Only the first count vertices extend the bounds.
+ */
+static void transform_vertices(MeshVertex* v, const MeshTransform* t, int count, __m128* lower, __m128* upper) {
+    __m128 p0 = _mm_loadu_ps(v[0].position), p1 = _mm_loadu_ps(v[1].position);
+    __m128 p2 = _mm_loadu_ps(v[2].position), p3 = _mm_loadu_ps(v[3].position);
+    __m128 q0 = _mm_loadu_ps(&v[0].normal[1]), q1 = _mm_loadu_ps(&v[1].normal[1]);
+    __m128 q2 = _mm_loadu_ps(&v[2].normal[1]), q3 = _mm_loadu_ps(&v[3].normal[1]);
+    // After the transposes p0, p1, p2, p3 hold x, y, z and the normal x, q0 and q1 the normal y and z.
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+    _MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+
+    const __m128* a = t->position;
+    __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], p0), _mm_mul_ps(a[3], p1)), _mm_add_ps(_mm_mul_ps(a[6], p2), t->translation[0]));
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[1], p0), _mm_mul_ps(a[4], p1)), _mm_add_ps(_mm_mul_ps(a[7], p2), t->translation[1]));
+    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[2], p0), _mm_mul_ps(a[5], p1)), _mm_add_ps(_mm_mul_ps(a[8], p2), t->translation[2]));
+
+    const __m128* n = t->normal;
+    __m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], p3), _mm_mul_ps(n[3], q0)), _mm_mul_ps(n[6], q1));
+    __m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[1], p3), _mm_mul_ps(n[4], q0)), _mm_mul_ps(n[7], q1));
+    __m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[2], p3), _mm_mul_ps(n[5], q0)), _mm_mul_ps(n[8], q1));
+
+    // Degenerate normals are kept as they are instead of dividing by zero.
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+    __m128 is_long = _mm_cmpgt_ps(length, _mm_set1_ps(1e-6f));
+    __m128 scale = _mm_or_ps(_mm_and_ps(is_long, _mm_div_ps(_mm_set1_ps(1.0f), length)),
+        _mm_andnot_ps(is_long, _mm_set1_ps(1.0f)));
+    nx = _mm_mul_ps(nx, scale);
+    ny = _mm_mul_ps(ny, scale);
+    nz = _mm_mul_ps(nz, scale);
+
+    // Lanes past the count and vertices with an infinite or NaN coordinate do not count in the bounds.
+    __m128 infinity = _mm_set1_ps(INFINITY);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 lanes = _mm_cmplt_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps((float)count));
+    __m128 is_finite = _mm_and_ps(_mm_and_ps(lanes, _mm_cmplt_ps(_mm_andnot_ps(sign, x), infinity)),
+        _mm_and_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, y), infinity), _mm_cmplt_ps(_mm_andnot_ps(sign, z), infinity)));
+    __m128 coordinates[3] = { x, y, z };
+    for (int c = 0; c < 3; c++) {
+        lower[c] = _mm_min_ps(lower[c], _mm_or_ps(_mm_and_ps(is_finite, coordinates[c]), _mm_andnot_ps(is_finite, infinity)));
+        upper[c] = _mm_max_ps(upper[c], _mm_or_ps(_mm_and_ps(is_finite, coordinates[c]), _mm_andnot_ps(is_finite, _mm_xor_ps(infinity, sign))));
     }
+
+    _MM_TRANSPOSE4_PS(x, y, z, nx);
+    _MM_TRANSPOSE4_PS(ny, nz, q2, q3);
+    _mm_storeu_ps(v[0].position, x);
+    _mm_storeu_ps(v[1].position, y);
+    _mm_storeu_ps(v[2].position, z);
+    _mm_storeu_ps(v[3].position, nx);
+    _mm_storeu_ps(&v[0].normal[1], ny);
+    _mm_storeu_ps(&v[1].normal[1], nz);
+    _mm_storeu_ps(&v[2].normal[1], q2);
+    _mm_storeu_ps(&v[3].normal[1], q3);
 }
 
-void calculate_mesh_aabb(const Model* model, Vec3* out_min, Vec3* out_max) {
-    if (!model || model->n_vertices == 0) {
-        *out_min = *out_max = (Vec3){ 0, 0, 0 };
-        return;
-    }
+static float min_lane(__m128 v) {
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    return fminf(fminf(lanes[0], lanes[1]), fminf(lanes[2], lanes[3]));
+}
 
-    Vertex v0 = model->vertices[1];
-    out_min->x = out_max->x = v0.x;
-    out_min->y = out_max->y = v0.y;
-    out_min->z = out_max->z = v0.z;
+static float max_lane(__m128 v) {
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    return fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+}
 
-    for (int i = 2; i <= model->n_vertices; ++i) {
-        Vertex v = model->vertices[i];
-        if (!isfinite(v.x) || !isfinite(v.y) || !isfinite(v.z)) {
-            continue;
+void transform_mesh(Mesh* mesh, Vec3 center, Vec3 scale, Vec3 rotation, Vec3* aabb_min, Vec3* aabb_max) {
+    double columns[3][3];
+    rotation_columns(rotation, columns);
+
+    // Positions go through rotation * scale after the centering, normals through rotation / scale.
+    float scales[3] = { scale.x, scale.y, scale.z };
+    float centers[3] = { center.x, center.y, center.z };
+    float translation[3] = { 0.0f, 0.0f, 0.0f };
+    MeshTransform t;
+    for (int j = 0; j < 3; j++) {
+        for (int i = 0; i < 3; i++) {
+            float element = (float)(columns[j][i] * scales[j]);
+            t.position[j * 3 + i] = _mm_set1_ps(element);
+            t.normal[j * 3 + i] = _mm_set1_ps((float)(columns[j][i] / scales[j]));
+            translation[i] -= element * centers[j];
         }
-        
-        if (v.x < out_min->x) out_min->x = v.x;
-        if (v.y < out_min->y) out_min->y = v.y;
-        if (v.z < out_min->z) out_min->z = v.z;
-
-        if (v.x > out_max->x) out_max->x = v.x;
-        if (v.y > out_max->y) out_max->y = v.y;
-        if (v.z > out_max->z) out_max->z = v.z;
     }
-}
+    for (int i = 0; i < 3; i++) {
+        t.translation[i] = _mm_set1_ps(translation[i]);
+    }
 
-Vec3 mesh_half_extents(const Model* model) {
-    Vec3 min, max;
-    calculate_mesh_aabb(model, &min, &max);
-    return (Vec3){
-        fmaxf((max.x - min.x)*0.5f, 0.01f),
-        fmaxf((max.y - min.y)*0.5f, 0.01f),
-        fmaxf((max.z - min.z)*0.5f, 0.01f)
-    };
+    __m128 lower[3], upper[3];
+    for (int c = 0; c < 3; c++) {
+        lower[c] = _mm_set1_ps(INFINITY);
+        upper[c] = _mm_set1_ps(-INFINITY);
+    }
+
+    int full_count = mesh->vertex_count & ~3;
+    for (int i = 0; i < full_count; i += 4) {
+        transform_vertices(&mesh->vertices[i], &t, 4, lower, upper);
+    }
+
+    // The last vertices are padded to a full block on the stack.
+    int rest = mesh->vertex_count - full_count;
+    if (rest > 0) {
+        MeshVertex block[4] = { 0 };
+        memcpy(block, &mesh->vertices[full_count], rest * sizeof(MeshVertex));
+        transform_vertices(block, &t, rest, lower, upper);
+        memcpy(&mesh->vertices[full_count], block, rest * sizeof(MeshVertex));
+    }
+
+    *aabb_min = (Vec3){ min_lane(lower[0]), min_lane(lower[1]), min_lane(lower[2]) };
+    *aabb_max = (Vec3){ max_lane(upper[0]), max_lane(upper[1]), max_lane(upper[2]) };
+    if (aabb_min->x > aabb_max->x) {
+        *aabb_min = *aabb_max = (Vec3){ 0, 0, 0 };
+    }
 }
 
 void set_material(const Material* material) {
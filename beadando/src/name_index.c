@@ -0,0 +1,80 @@
+#include "name_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FNV_OFFSET_BASIS 0x811c9dc5u
+#define FNV_PRIME 0x01000193u
+
+static uint32_t hash_name(const char* name) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (const unsigned char* c = (const unsigned char*)name; *c != '\0'; c++) {
+        hash = (hash ^ *c) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Slot holding the name, or the empty slot where it would go.
+ */
+static NameIndexSlot* find_slot(const NameIndex* index, const char* name, uint32_t hash) {
+    int mask = index->capacity - 1;
+    for (int i = (int)(hash & (uint32_t)mask);; i = (i + 1) & mask) {
+        NameIndexSlot* slot = &index->slots[i];
+        if (slot->name == NULL) return slot;
+        if (slot->hash == hash && strcmp(slot->name, name) == 0) return slot;
+    }
+}
+
+static void allocate_slots(NameIndex* index, int capacity) {
+    index->slots = calloc(capacity, sizeof(NameIndexSlot));
+    index->capacity = capacity;
+    index->count = 0;
+}
+
+void init_name_index(NameIndex* index, int expected_count) {
+    // At most half full, so the probe sequences stay short.
+    int capacity = 16;
+    while (capacity < expected_count * 2) {
+        capacity *= 2;
+    }
+    allocate_slots(index, capacity);
+}
+
+static void grow_name_index(NameIndex* index) {
+    NameIndexSlot* old_slots = index->slots;
+    int old_capacity = index->capacity;
+
+    allocate_slots(index, old_capacity * 2);
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_slots[i].name != NULL) {
+            *find_slot(index, old_slots[i].name, old_slots[i].hash) = old_slots[i];
+            index->count++;
+        }
+    }
+    free(old_slots);
+}
+
+void add_name(NameIndex* index, const char* name, int value) {
+    if ((index->count + 1) * 2 > index->capacity) {
+        grow_name_index(index);
+    }
+
+    uint32_t hash = hash_name(name);
+    NameIndexSlot* slot = find_slot(index, name, hash);
+    if (slot->name != NULL) return;
+
+    *slot = (NameIndexSlot){ name, hash, value };
+    index->count++;
+}
+
+int find_name(const NameIndex* index, const char* name) {
+    if (index->slots == NULL || name == NULL) return -1;
+
+    const NameIndexSlot* slot = find_slot(index, name, hash_name(name));
+    return slot->name != NULL ? slot->value : -1;
+}
+
+void free_name_index(NameIndex* index) {
+    free(index->slots);
+    memset(index, 0, sizeof(NameIndex));
+}
@@ -0,0 +1,535 @@
+#include "obj_loader.h"
+#include "filemap.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Zero based position, texture and normal index of a face corner, -1 when missing.
+ */
+typedef struct ObjCorner {
+    int position;
+    int uv;
+    int normal;
+} ObjCorner;
+
+typedef struct ObjCounts {
+    int positions;
+    int uvs;
+    int normals;
+    int triangles;
+} ObjCounts;
+
+/**
+ * Arrays of the whole file, every chunk writes its own range.
+ */
+typedef struct ObjData {
+    float* positions;
+    float* uvs;
+    float* normals;
+    ObjCorner* corners;
+    ObjCounts totals;
+} ObjData;
+
+/**
+ * Line aligned part of the file with its element counts and the index of its first elements in the whole file.
+ */
+typedef struct ObjChunk {
+    const char* begin;
+    const char* end;
+    ObjCounts counts;
+    ObjCounts first;
+    ObjData* data;
+    Vec3 aabb_min;
+    Vec3 aabb_max;
+} ObjChunk;
+
+typedef enum ObjLineType {
+    OBJ_LINE_OTHER,
+    OBJ_LINE_POSITION,
+    OBJ_LINE_UV,
+    OBJ_LINE_NORMAL,
+    OBJ_LINE_FACE
+} ObjLineType;
+
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) p++;
+    return p;
+}
+
+static inline const char* next_line(const char* p, const char* end) {
+    const char* newline = memchr(p, '\n', end - p);
+    return newline != NULL ? newline + 1 : end;
+}
+
+/**
+ * Decimal float with optional sign, fraction and exponent, the first 19 significant digits are kept.
+ */
+static const char* parse_float(const char* p, const char* end, float* out) {
+    p = skip_blanks(p, end);
+
+    bool is_negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        is_negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    for (; p < end && is_digit(*p); p++) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa != 0) digits++;
+        }
+        else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool is_negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            is_negative_exponent = *q == '-';
+            q++;
+        }
+        if (q < end && is_digit(*q)) {
+            int value = 0;
+            for (; q < end && is_digit(*q); q++) {
+                if (value < 10000) value = value * 10 + (*q - '0');
+            }
+            exponent += is_negative_exponent ? -value : value;
+            p = q;
+        }
+    }
+
+    double value = (double)mantissa;
+    if (mantissa != 0) {
+        while (exponent > 22) {
+            value *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22) {
+            value /= 1e22;
+            exponent += 22;
+        }
+        value = exponent >= 0 ? value * POWERS_OF_TEN[exponent] : value / POWERS_OF_TEN[-exponent];
+    }
+
+    *out = (float)(is_negative ? -value : value);
+    return p;
+}
+
+static const char* parse_int(const char* p, const char* end, int* out) {
+    bool is_negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        is_negative = *p == '-';
+        p++;
+    }
+
+    int value = 0;
+    for (; p < end && is_digit(*p); p++) {
+        value = value * 10 + (*p - '0');
+    }
+    *out = is_negative ? -value : value;
+    return p;
+}
+
+/**
+ * Identify the line by its keyword and move p after it.
+ */
+static ObjLineType classify_line(const char** p, const char* end) {
+    const char* q = skip_blanks(*p, end);
+    if (end - q < 2) return OBJ_LINE_OTHER;
+
+    ObjLineType type = OBJ_LINE_OTHER;
+    int length = 1;
+    if (q[0] == 'v') {
+        if (is_blank(q[1])) {
+            type = OBJ_LINE_POSITION;
+        }
+        else if (end - q > 2 && is_blank(q[2])) {
+            length = 2;
+            if (q[1] == 't') type = OBJ_LINE_UV;
+            if (q[1] == 'n') type = OBJ_LINE_NORMAL;
+        }
+    }
+    else if (q[0] == 'f' && is_blank(q[1])) {
+        type = OBJ_LINE_FACE;
+    }
+
+    *p = q + length;
+    return type;
+}
+
+static int count_face_corners(const char* p, const char* end) {
+    int count = 0;
+    while (true) {
+        p = skip_blanks(p, end);
+        if (p >= end || *p == '\n' || *p == '#') break;
+        count++;
+        while (p < end && !is_blank(*p) && *p != '\n') p++;
+    }
+    return count;
+}
+
+static int resolve_index(int index, int defined_count) {
+    if (index > 0) return index - 1;
+    if (index < 0) return defined_count + index;
+    return -1;
+}
+
+/**
+ * Parse a v, v/vt, v//vn or v/vt/vn token, relative indices count back from the elements defined so far.
+ */
+static const char* parse_corner(const char* p, const char* end, const ObjCounts* defined, ObjCorner* corner) {
+    int position = 0, uv = 0, normal = 0;
+
+    p = parse_int(p, end, &position);
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/') {
+            p = parse_int(p, end, &uv);
+        }
+        if (p < end && *p == '/') {
+            p = parse_int(p + 1, end, &normal);
+        }
+    }
+    while (p < end && !is_blank(*p) && *p != '\n') p++;
+
+    corner->position = resolve_index(position, defined->positions);
+    corner->uv = resolve_index(uv, defined->uvs);
+    corner->normal = resolve_index(normal, defined->normals);
+    return p;
+}
+
+static int count_chunk(void* data) {
+    ObjChunk* chunk = data;
+
+    for (const char* p = chunk->begin; p < chunk->end; p = next_line(p, chunk->end)) {
+        const char* q = p;
+        switch (classify_line(&q, chunk->end)) {
+        case OBJ_LINE_POSITION:
+            chunk->counts.positions++;
+            break;
+        case OBJ_LINE_UV:
+            chunk->counts.uvs++;
+            break;
+        case OBJ_LINE_NORMAL:
+            chunk->counts.normals++;
+            break;
+        case OBJ_LINE_FACE: {
+            int corners = count_face_corners(q, chunk->end);
+            if (corners >= 3) chunk->counts.triangles += corners - 2;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Write the fan triangles of a face and return its corner count.
+ */
+static int parse_face(const char* p, const char* end, const ObjCounts* defined, ObjCorner* triangles) {
+    ObjCorner first, previous, corner;
+    int corner_count = 0;
+
+    while (true) {
+        p = skip_blanks(p, end);
+        if (p >= end || *p == '\n' || *p == '#') break;
+
+        p = parse_corner(p, end, defined, &corner);
+        if (corner_count == 0) {
+            first = corner;
+        }
+        else if (corner_count >= 2) {
+            // Fan triangulation around the first corner.
+            int triangle = corner_count - 2;
+            triangles[triangle * 3] = first;
+            triangles[triangle * 3 + 1] = previous;
+            triangles[triangle * 3 + 2] = corner;
+        }
+        previous = corner;
+        corner_count++;
+    }
+    return corner_count;
+}
+
+static int parse_chunk(void* data) {
+    ObjChunk* chunk = data;
+    ObjData* out = chunk->data;
+    ObjCounts defined = chunk->first;
+
+    chunk->aabb_min = (Vec3){ INFINITY, INFINITY, INFINITY };
+    chunk->aabb_max = (Vec3){ -INFINITY, -INFINITY, -INFINITY };
+
+    for (const char* p = chunk->begin; p < chunk->end; p = next_line(p, chunk->end)) {
+        const char* q = p;
+        switch (classify_line(&q, chunk->end)) {
+        case OBJ_LINE_POSITION: {
+            float* v = &out->positions[defined.positions++ * 3];
+            q = parse_float(q, chunk->end, &v[0]);
+            q = parse_float(q, chunk->end, &v[1]);
+            parse_float(q, chunk->end, &v[2]);
+            if (isfinite(v[0]) && isfinite(v[1]) && isfinite(v[2])) {
+                chunk->aabb_min = vec3_min(chunk->aabb_min, (Vec3){ v[0], v[1], v[2] });
+                chunk->aabb_max = vec3_max(chunk->aabb_max, (Vec3){ v[0], v[1], v[2] });
+            }
+            break;
+        }
+        case OBJ_LINE_UV: {
+            float* uv = &out->uvs[defined.uvs++ * 2];
+            q = parse_float(q, chunk->end, &uv[0]);
+            parse_float(q, chunk->end, &uv[1]);
+            break;
+        }
+        case OBJ_LINE_NORMAL: {
+            float* n = &out->normals[defined.normals++ * 3];
+            q = parse_float(q, chunk->end, &n[0]);
+            q = parse_float(q, chunk->end, &n[1]);
+            parse_float(q, chunk->end, &n[2]);
+            break;
+        }
+        case OBJ_LINE_FACE: {
+            int corners = parse_face(q, chunk->end, &defined, &out->corners[defined.triangles * 3]);
+            if (corners >= 3) defined.triangles += corners - 2;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Run the function on every chunk, the first one on the calling thread.
+ */
+static void run_chunks(ObjChunk* chunks, int chunk_count, SDL_ThreadFunction function) {
+    SDL_Thread* threads[OBJ_MAX_THREADS] = { NULL };
+
+    for (int i = 1; i < chunk_count; i++) {
+        threads[i] = SDL_CreateThread(function, "obj_loader", &chunks[i]);
+        if (threads[i] == NULL) {
+            function(&chunks[i]);
+        }
+    }
+    function(&chunks[0]);
+    for (int i = 1; i < chunk_count; i++) {
+        if (threads[i] != NULL) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+}
+
+static int split_into_chunks(const char* text, size_t size, int max_threads, ObjChunk* chunks, ObjData* data) {
+    int chunk_count = SDL_GetCPUCount();
+    if (chunk_count > max_threads) chunk_count = max_threads;
+    if (chunk_count > OBJ_MAX_THREADS) chunk_count = OBJ_MAX_THREADS;
+    if ((size_t)chunk_count > size / OBJ_MIN_CHUNK_SIZE) chunk_count = (int)(size / OBJ_MIN_CHUNK_SIZE);
+    if (chunk_count < 1) chunk_count = 1;
+
+    const char* end = text + size;
+    const char* begin = text;
+    for (int i = 0; i < chunk_count; i++) {
+        const char* split = (i == chunk_count - 1) ? end : text + size / chunk_count * (i + 1);
+        if (split < begin) split = begin;
+        if (split < end) split = next_line(split, end);
+
+        memset(&chunks[i], 0, sizeof(ObjChunk));
+        chunks[i].begin = begin;
+        chunks[i].end = split;
+        chunks[i].data = data;
+        begin = split;
+    }
+    return chunk_count;
+}
+
+/**
+ * Open addressing table from corners to mesh vertices.
+ */
+typedef struct CornerMap {
+    ObjCorner* keys;
+    int* values;
+    unsigned int mask;
+    int count;
+} CornerMap;
+
+static unsigned int hash_corner(const ObjCorner* corner) {
+    unsigned int hash = 2166136261u;
+    hash = (hash ^ (unsigned int)corner->position) * 16777619u;
+    hash = (hash ^ (unsigned int)corner->uv) * 16777619u;
+    hash = (hash ^ (unsigned int)corner->normal) * 16777619u;
+    return hash;
+}
+
+static void init_corner_map(CornerMap* map, unsigned int capacity) {
+    map->mask = capacity - 1;
+    map->count = 0;
+    map->keys = malloc(capacity * sizeof(ObjCorner));
+    map->values = malloc(capacity * sizeof(int));
+    memset(map->values, -1, capacity * sizeof(int));
+}
+
+static unsigned int find_corner_slot(const CornerMap* map, const ObjCorner* corner) {
+    unsigned int slot = hash_corner(corner) & map->mask;
+    while (map->values[slot] >= 0) {
+        const ObjCorner* key = &map->keys[slot];
+        if (key->position == corner->position && key->uv == corner->uv && key->normal == corner->normal) {
+            break;
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    return slot;
+}
+
+static void grow_corner_map(CornerMap* map) {
+    CornerMap old = *map;
+    init_corner_map(map, (old.mask + 1) * 2);
+    for (unsigned int i = 0; i <= old.mask; i++) {
+        if (old.values[i] < 0) continue;
+        unsigned int slot = find_corner_slot(map, &old.keys[i]);
+        map->keys[slot] = old.keys[i];
+        map->values[slot] = old.values[i];
+    }
+    map->count = old.count;
+    free(old.keys);
+    free(old.values);
+}
+
+static void set_mesh_vertex(MeshVertex* vertex, const ObjData* data, const ObjCorner* corner) {
+    memset(vertex, 0, sizeof(MeshVertex));
+    if (corner->position >= 0 && corner->position < data->totals.positions) {
+        memcpy(vertex->position, &data->positions[corner->position * 3], sizeof(vertex->position));
+    }
+    if (corner->normal >= 0 && corner->normal < data->totals.normals) {
+        memcpy(vertex->normal, &data->normals[corner->normal * 3], sizeof(vertex->normal));
+    }
+    if (corner->uv >= 0 && corner->uv < data->totals.uvs) {
+        vertex->uv[0] = data->uvs[corner->uv * 2];
+        vertex->uv[1] = data->uvs[corner->uv * 2 + 1];
+    }
+    // Flipped like mesh_from_model, OBJ texture coordinates start at the bottom.
+    vertex->uv[1] = 1.0f - vertex->uv[1];
+}
+
+static void build_indexed_mesh(Mesh* mesh, const ObjData* data) {
+    int corner_count = data->totals.triangles * 3;
+
+    mesh->vertices = malloc((corner_count > 0 ? corner_count : 1) * sizeof(MeshVertex));
+    mesh->indices = malloc((corner_count > 0 ? corner_count : 1) * sizeof(GLuint));
+    mesh->vertex_count = 0;
+    mesh->index_count = corner_count;
+
+    // Most files share about one vertex per position, the table grows when they do not.
+    int expected = data->totals.positions;
+    if (expected < data->totals.uvs) expected = data->totals.uvs;
+    if (expected < data->totals.normals) expected = data->totals.normals;
+    if (expected > corner_count) expected = corner_count;
+    unsigned int capacity = 16;
+    while (capacity < (unsigned int)expected * 2) {
+        capacity *= 2;
+    }
+
+    CornerMap map;
+    init_corner_map(&map, capacity);
+
+    for (int i = 0; i < corner_count; i++) {
+        const ObjCorner* corner = &data->corners[i];
+        unsigned int slot = find_corner_slot(&map, corner);
+        int index = map.values[slot];
+        if (index < 0) {
+            index = mesh->vertex_count++;
+            map.keys[slot] = *corner;
+            map.values[slot] = index;
+            set_mesh_vertex(&mesh->vertices[index], data, corner);
+
+            if (++map.count * 2 > (int)map.mask + 1) {
+                grow_corner_map(&map);
+            }
+        }
+        mesh->indices[i] = (GLuint)index;
+    }
+
+    free(map.keys);
+    free(map.values);
+    mesh->vertices = realloc(mesh->vertices, (mesh->vertex_count > 0 ? mesh->vertex_count : 1) * sizeof(MeshVertex));
+}
+
+bool load_obj_mesh(const char* path, int max_threads, Mesh* mesh, Vec3* aabb_min, Vec3* aabb_max) {
+    memset(mesh, 0, sizeof(Mesh));
+    *aabb_min = *aabb_max = (Vec3){ 0.0f, 0.0f, 0.0f };
+
+    MappedFile file;
+    if (!map_file(&file, path)) {
+        printf("[ERROR] Cannot open model %s\n", path);
+        return false;
+    }
+
+    ObjData data;
+    ObjChunk chunks[OBJ_MAX_THREADS];
+    memset(&data, 0, sizeof(data));
+    int chunk_count = split_into_chunks(file.data, file.size, max_threads, chunks, &data);
+
+    // The first pass counts, so the second one can write straight into the final arrays.
+    run_chunks(chunks, chunk_count, count_chunk);
+    for (int i = 0; i < chunk_count; i++) {
+        chunks[i].first = data.totals;
+        data.totals.positions += chunks[i].counts.positions;
+        data.totals.uvs += chunks[i].counts.uvs;
+        data.totals.normals += chunks[i].counts.normals;
+        data.totals.triangles += chunks[i].counts.triangles;
+    }
+
+    data.positions = malloc((data.totals.positions + 1) * 3 * sizeof(float));
+    data.uvs = malloc((data.totals.uvs + 1) * 2 * sizeof(float));
+    data.normals = malloc((data.totals.normals + 1) * 3 * sizeof(float));
+    data.corners = malloc((data.totals.triangles + 1) * 3 * sizeof(ObjCorner));
+    run_chunks(chunks, chunk_count, parse_chunk);
+    unmap_file(&file);
+
+    if (data.totals.positions > 0) {
+        *aabb_min = chunks[0].aabb_min;
+        *aabb_max = chunks[0].aabb_max;
+        for (int i = 1; i < chunk_count; i++) {
+            *aabb_min = vec3_min(*aabb_min, chunks[i].aabb_min);
+            *aabb_max = vec3_max(*aabb_max, chunks[i].aabb_max);
+        }
+    }
+
+    build_indexed_mesh(mesh, &data);
+
+    free(data.positions);
+    free(data.uvs);
+    free(data.normals);
+    free(data.corners);
+    return true;
+}
@@ -1,8 +1,13 @@
 #include "object.h"
 #include "scene.h"
+#include "bake.h"
+#include "mesh_optimizer.h"
+#include "obj_loader.h"
+#include <math.h>
 #include <string.h>
 #include <stdio.h>
 #include "physics.h"
+#include "trace.h"
 #include "utils.h"
 
 void add_object(Scene* scene, ObjectConfig* config) {
@@ -14,57 +19,155 @@ void add_object(Scene* scene, ObjectConfig* config) {
     obj->is_static = config->is_static;
     obj->is_interacted = false;
     obj->in_extraction = false;
+    obj->static_batch = -1;
     obj->value = config->value;
     obj->material = scene->material;
     strncpy(obj->name, config->name, sizeof(obj->name) - 1);
+    add_name(&scene->object_index, obj->name, obj->id);
     obj->rotation = config->rotation;
-    load_and_prepare_model(obj, config);
 
+    // The placeholder box stands here until the model arrives.
     Room* room = find_room_by_name(scene, config->room_name);
+    obj->room_id = room->id;
     obj->position = calculate_world_position(room, config);
-    obj->position = constrain_to_room(obj->position, room, mesh_half_extents(&obj->model));
 
-    if (config->texture_path[0] != '\0') {
-        obj->texture_id = load_texture(config->texture_path);
-    }
-    else {
+    if (config->texture_path[0] == '\0') {
         printf("[WARNING]: No texture set for object '%s'.\n", obj->name);
-        obj->texture_id = 0;
     }
+    obj->texture_id = 0;
 
     scene->object_count++;
     printf("Added object %d: %s\n", obj->id, obj->name);
 }
 
-void load_and_prepare_model(Object* obj, ObjectConfig* config) {
-    load_model(&obj->model, config->model_path);
+void queue_object_assets(Object* obj, const ObjectConfig* config, AssetLoader* loader) {
+    queue_model_load(loader, config, obj);
+    obj->pending_assets = 1;
+
+    if (config->texture_path[0] != '\0') {
+        queue_texture_load(loader, config->texture_path, &obj->texture_id, obj);
+        obj->pending_assets++;
+    }
+}
+
+void release_object_assets(Object* obj) {
+    if (!obj->is_static) {
+        // ODE stores the quaternion as w, x, y, z.
+        const dReal* q = dBodyGetQuaternion(obj->physics_body.body);
+        obj->orientation = (Quat){ (float)q[1], (float)q[2], (float)q[3], (float)q[0] };
+        physics_get_position(&obj->physics_body, &obj->position);
+    }
+    physics_destroy_body(&obj->physics_body);
+
+    free_lod_chain(&obj->lod);
+    memset(&obj->lod, 0, sizeof(LodChain));
+    if (obj->texture_id != 0) {
+        glDeleteTextures(1, &obj->texture_id);
+        obj->texture_id = 0;
+    }
+
+    obj->static_batch = -1;
+    obj->memory_bytes = 0;
+    obj->is_loaded = false;
+    obj->is_evicted = true;
+}
+
+void place_object(Scene* scene, Object* obj, const ObjectConfig* config) {
+    Room* room = find_room_by_name(scene, config->room_name);
+    obj->position = calculate_world_position(room, config);
+    obj->position = constrain_to_room(obj->position, room, object_half_extents(obj));
+}
+
+void prepare_object_mesh(const ObjectConfig* config, int max_threads, LodChain* lod, Vec3* aabb_min, Vec3* aabb_max) {
+    Mesh mesh;
+    Vec3 mesh_min, mesh_max;
+    TRACE_ZONE("Parse OBJ", load_obj_mesh(config->model_path, max_threads, &mesh, &mesh_min, &mesh_max));
+
+    // The bounding box is kept by the object and the baked mesh, it is not recomputed later.
+    Vec3 scale = config->scale.x > 0 ? config->scale : (Vec3){ 1.0f, 1.0f, 1.0f };
+    TRACE_ZONE("Transform mesh", transform_mesh(&mesh, vec3_scale(vec3_add(mesh_min, mesh_max), 0.5f), scale,
+        config->rotation, aabb_min, aabb_max));
+
+    MeshOptimizationStats stats;
+    TRACE_ZONE("Optimize mesh", optimize_mesh(&mesh, &stats));
+    printf("[INFO] Optimized %s: %d -> %d vertices, ACMR %.3f -> %.3f\n", config->model_path,
+        stats.vertex_count_before, stats.vertex_count_after, stats.acmr_before, stats.acmr_after);
+
+    TRACE_ZONE("Build LOD chain", build_lod_chain(lod, &mesh));
+}
+
+void load_and_prepare_model(Object* obj, const ObjectConfig* config) {
+    trace_begin("Load model");
+    bool is_baked;
+    TRACE_ZONE("Map baked mesh", is_baked = load_baked_mesh(config, &obj->lod, &obj->aabb_min, &obj->aabb_max));
+    if (!is_baked) {
+        // The loader pool already runs a worker per core, so the OBJ is parsed on the calling worker only.
+        prepare_object_mesh(config, 1, &obj->lod, &obj->aabb_min, &obj->aabb_max);
+        TRACE_ZONE("Bake mesh", save_baked_mesh(config, &obj->lod, obj->aabb_min, obj->aabb_max));
+    }
+    trace_end();
 
-    Vec3 mesh_min, mesh_max, center;
-    calculate_mesh_aabb(&obj->model, &mesh_min, &mesh_max);
-    center = vec3_scale(vec3_add(mesh_min, mesh_max), 0.5f);
-    for (int i = 1; i <= obj->model.n_vertices; ++i) {
-        obj->model.vertices[i].x -= center.x;
-        obj->model.vertices[i].y -= center.y;
-        obj->model.vertices[i].z -= center.z;
+    printf("[INFO] LOD chain of %s:", obj->name);
+    for (int i = 0; i < obj->lod.level_count; i++) {
+        printf(" %d", obj->lod.triangle_counts[i]);
     }
+    printf(" triangles%s\n", obj->lod.mapping.data != NULL ? " (baked)" : "");
+}
+
+Vec3 object_half_extents(const Object* obj) {
+    return (Vec3){
+        fmaxf((obj->aabb_max.x - obj->aabb_min.x) * 0.5f, 0.01f),
+        fmaxf((obj->aabb_max.y - obj->aabb_min.y) * 0.5f, 0.01f),
+        fmaxf((obj->aabb_max.z - obj->aabb_min.z) * 0.5f, 0.01f)
+    };
+}
+
+void update_object_lods(Scene* scene, const Camera* camera) {
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (!obj->is_active || !obj->is_loaded) continue;
 
-    if (config->scale.x > 0) {
-        scale_model(&obj->model, config->scale);
+        float screen_size = projected_screen_size(camera, obj->position, obj->lod.radius);
+        select_lod_level(&obj->lod, screen_size);
     }
-    if (config->rotation.x || config->rotation.y || config->rotation.z) {
-        rotate_model(&obj->model, config->rotation);
+}
+
+void update_object_matrices(Scene* scene, const Camera* camera) {
+    get_view_matrix(camera, &scene->view_matrix);
+
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (obj->is_static || !obj->is_active || !obj->is_loaded) continue;
+
+        // ODE stores the quaternion as w, x, y, z.
+        const dReal* q = dBodyGetQuaternion(obj->physics_body.body);
+        Quat rotation = { (float)q[1], (float)q[2], (float)q[3], (float)q[0] };
+        mat4_from_quat(&scene->model_matrices[i], rotation, obj->position);
     }
+
+    mat4_multiply_batch(scene->modelview_matrices, &scene->view_matrix, scene->model_matrices, scene->object_count);
 }
 
 void sync_physics_transforms(Scene* scene) {
     for (int i = 0; i < scene->object_count; ++i) {
         Object* object = &scene->objects[i];
 
-        if (object->is_static) continue;
+        if (object->is_static || !object->is_loaded) continue;
 
         physics_get_position(&object->physics_body, &object->position);
         physics_get_rotation(&object->physics_body, &object->rotation);
+        object->physics_body.is_sleeping = !dBodyIsEnabled(object->physics_body.body);
+    }
+}
+
+int count_awake_objects(const Scene* scene) {
+    int awake = 0;
+    for (int i = 0; i < scene->object_count; ++i) {
+        const Object* object = &scene->objects[i];
+        if (object->is_static || !object->is_active || !object->is_loaded) continue;
+        if (!object->physics_body.is_sleeping) awake++;
     }
+    return awake;
 }
 
 int select_object_at(Scene* scene, Camera* cam, int mx, int my, float* out_distance) {
@@ -86,7 +189,7 @@ int select_object_at(Scene* scene, Camera* cam, int mx, int my, float* out_dista
     float best = FLT_MAX;
     for (int i = 0; i < scene->object_count; ++i) {
         Object* obj = &scene->objects[i];
-        if (!obj->is_active || obj->is_static) continue;
+        if (!obj->is_active || obj->is_static || !obj->is_loaded) continue;
 
         float t;
         if (ray_intersect_obb(cam->position, dir, &obj->physics_body, &t) && t < best) {
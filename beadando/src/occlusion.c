@@ -0,0 +1,338 @@
+#include "occlusion.h"
+#include "scene.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+// Vertex of a clipped polygon: x, y, z, w in clip space.
+typedef struct ClipVertex {
+    float v[4];
+} ClipVertex;
+
+// Vertex of a triangle in the depth buffer: x, y in pixels, 1/w as depth.
+typedef struct ScreenVertex {
+    float x;
+    float y;
+    float depth;
+} ScreenVertex;
+
+static void transform_point(const Mat4* m, const float p[3], float out[4]) {
+    Vec4 clip = mat4_transform(m, (Vec4){ p[0], p[1], p[2], 1.0f });
+    out[0] = clip.x;
+    out[1] = clip.y;
+    out[2] = clip.z;
+    out[3] = clip.w;
+}
+
+/**
+ * Clip a polygon to the near plane (w >= CAMERA_NEAR_PLANE), one plane is enough as the rest is handled by the bounds.
+ */
+static int clip_to_near_plane(const ClipVertex* in, int count, ClipVertex* out) {
+    int out_count = 0;
+    for (int i = 0; i < count; i++) {
+        const ClipVertex* a = &in[i];
+        const ClipVertex* b = &in[(i + 1) % count];
+        float da = a->v[3] - CAMERA_NEAR_PLANE;
+        float db = b->v[3] - CAMERA_NEAR_PLANE;
+
+        if (da >= 0.0f) {
+            out[out_count++] = *a;
+        }
+        if ((da >= 0.0f) != (db >= 0.0f)) {
+            float t = da / (da - db);
+            ClipVertex* v = &out[out_count++];
+            for (int k = 0; k < 4; k++) {
+                v->v[k] = a->v[k] + (b->v[k] - a->v[k]) * t;
+            }
+        }
+    }
+    return out_count;
+}
+
+static ScreenVertex to_screen(const ClipVertex* clip) {
+    float inv_w = 1.0f / clip->v[3];
+    return (ScreenVertex){
+        (clip->v[0] * inv_w * 0.5f + 0.5f) * OCCLUSION_WIDTH,
+        (clip->v[1] * inv_w * 0.5f + 0.5f) * OCCLUSION_HEIGHT,
+        inv_w
+    };
+}
+
+/**
+ * Rasterize a triangle four pixels at a time, keeping the nearest (largest) 1/w at the covered pixel centers.
+ */
+static void rasterize_triangle(float* depth, ScreenVertex v0, ScreenVertex v1, ScreenVertex v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (fabsf(area) < 1e-6f) return;
+    if (area < 0.0f) {
+        ScreenVertex t = v1;
+        v1 = v2;
+        v2 = t;
+        area = -area;
+    }
+
+    int min_x = (int)fmaxf(floorf(fminf(v0.x, fminf(v1.x, v2.x))), 0.0f);
+    int max_x = (int)fminf(ceilf(fmaxf(v0.x, fmaxf(v1.x, v2.x))), OCCLUSION_WIDTH - 1);
+    int min_y = (int)fmaxf(floorf(fminf(v0.y, fminf(v1.y, v2.y))), 0.0f);
+    int max_y = (int)fminf(ceilf(fmaxf(v0.y, fmaxf(v1.y, v2.y))), OCCLUSION_HEIGHT - 1);
+    if (min_x > max_x || min_y > max_y) return;
+
+    // Edge functions E = A x + B y + C, positive inside, each weighting the opposite vertex.
+    const ScreenVertex* from[3] = { &v1, &v2, &v0 };
+    const ScreenVertex* to[3] = { &v2, &v0, &v1 };
+    float a[3], b[3], c[3];
+    for (int i = 0; i < 3; i++) {
+        a[i] = from[i]->y - to[i]->y;
+        b[i] = to[i]->x - from[i]->x;
+        c[i] = -(a[i] * from[i]->x + b[i] * from[i]->y);
+    }
+
+    float inv_area = 1.0f / area;
+    float depth_a = (a[0] * v0.depth + a[1] * v1.depth + a[2] * v2.depth) * inv_area;
+    float depth_b = (b[0] * v0.depth + b[1] * v1.depth + b[2] * v2.depth) * inv_area;
+    float depth_c = (c[0] * v0.depth + c[1] * v1.depth + c[2] * v2.depth) * inv_area;
+
+    int start_x = min_x & ~3;
+    __m128 lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 x0 = _mm_add_ps(_mm_set1_ps((float)start_x), lanes);
+
+    __m128 edge_a[3], edge_step[3];
+    for (int i = 0; i < 3; i++) {
+        edge_a[i] = _mm_set1_ps(a[i]);
+        edge_step[i] = _mm_set1_ps(a[i] * 4.0f);
+    }
+    __m128 depth_step = _mm_set1_ps(depth_a * 4.0f);
+
+    for (int y = min_y; y <= max_y; y++) {
+        float py = y + 0.5f;
+        __m128 edge[3];
+        for (int i = 0; i < 3; i++) {
+            edge[i] = _mm_add_ps(_mm_mul_ps(edge_a[i], x0), _mm_set1_ps(b[i] * py + c[i]));
+        }
+        __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depth_a), x0), _mm_set1_ps(depth_b * py + depth_c));
+
+        float* row = depth + y * OCCLUSION_WIDTH;
+        for (int x = start_x; x <= max_x; x += 4) {
+            __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)),
+                _mm_cmpge_ps(edge[2], zero));
+
+            if (_mm_movemask_ps(inside)) {
+                __m128 old = _mm_load_ps(row + x);
+                __m128 nearest = _mm_max_ps(old, z);
+                _mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+            }
+
+            for (int i = 0; i < 3; i++) {
+                edge[i] = _mm_add_ps(edge[i], edge_step[i]);
+            }
+            z = _mm_add_ps(z, depth_step);
+        }
+    }
+}
+
+static void rasterize_occluders(OcclusionCuller* culler) {
+    memset(culler->depth, 0, OCCLUSION_WIDTH * OCCLUSION_HEIGHT * sizeof(float));
+
+    for (int q = 0; q < culler->occluder_count; q++) {
+        const float* quad = &culler->occluders[q * 12];
+        ClipVertex corners[4];
+        ClipVertex clipped[5];
+        ScreenVertex screen[5];
+
+        for (int i = 0; i < 4; i++) {
+            transform_point(&culler->view_projection, &quad[i * 3], corners[i].v);
+        }
+
+        int count = clip_to_near_plane(corners, 4, clipped);
+        for (int i = 0; i < count; i++) {
+            screen[i] = to_screen(&clipped[i]);
+        }
+        for (int i = 2; i < count; i++) {
+            rasterize_triangle(culler->depth, screen[0], screen[i - 1], screen[i]);
+        }
+    }
+}
+
+static int occlusion_worker(void* data) {
+    OcclusionCuller* culler = data;
+    trace_thread_name("Occlusion");
+
+    while (true) {
+        SDL_SemWait(culler->start);
+        if (culler->is_quitting) break;
+
+        TRACE_ZONE("Rasterize occluders", rasterize_occluders(culler));
+        SDL_SemPost(culler->done);
+    }
+    trace_thread_exit();
+    return 0;
+}
+
+/**
+ * Check whether every pixel under the screen bounds of the box has a wall in front of its nearest corner.
+ */
+static bool is_box_occluded(const OcclusionCuller* culler, const Vec3 corners[8]) {
+    float min_x = INFINITY, min_y = INFINITY;
+    float max_x = -INFINITY, max_y = -INFINITY;
+    float nearest = 0.0f;
+    Vec4 points[8];
+    ClipVertex clip[8];
+    int behind_count = 0;
+
+    mat4_transform_points(&culler->view_projection, corners, points, 8);
+    for (int i = 0; i < 8; i++) {
+        clip[i] = (ClipVertex){ { points[i].x, points[i].y, points[i].z, points[i].w } };
+        if (clip[i].v[3] < CAMERA_NEAR_PLANE) behind_count++;
+    }
+
+    // Entirely behind the camera, or crossing the near plane and so too close to cull.
+    if (behind_count == 8) return true;
+    if (behind_count > 0) return false;
+
+    for (int i = 0; i < 8; i++) {
+        ScreenVertex s = to_screen(&clip[i]);
+        min_x = fminf(min_x, s.x);
+        max_x = fmaxf(max_x, s.x);
+        min_y = fminf(min_y, s.y);
+        max_y = fmaxf(max_y, s.y);
+        nearest = fmaxf(nearest, s.depth);
+    }
+
+    // Outside of the view frustum.
+    if (max_x < 0.0f || min_x > OCCLUSION_WIDTH || max_y < 0.0f || min_y > OCCLUSION_HEIGHT) {
+        return true;
+    }
+
+    // One pixel margin, the buffer only samples the pixel centers.
+    int x0 = (int)fmaxf(floorf(min_x) - 1.0f, 0.0f);
+    int x1 = (int)fminf(ceilf(max_x) + 1.0f, OCCLUSION_WIDTH - 1);
+    int y0 = (int)fmaxf(floorf(min_y) - 1.0f, 0.0f);
+    int y1 = (int)fminf(ceilf(max_y) + 1.0f, OCCLUSION_HEIGHT - 1);
+
+    __m128 object_depth = _mm_set1_ps(nearest);
+    __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 first = _mm_set1_ps((float)x0);
+    __m128 last = _mm_set1_ps((float)x1);
+
+    for (int y = y0; y <= y1; y++) {
+        const float* row = culler->depth + y * OCCLUSION_WIDTH;
+        for (int x = x0 & ~3; x <= x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 in_bounds = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+            __m128 is_farther = _mm_cmplt_ps(_mm_load_ps(row + x), object_depth);
+            if (_mm_movemask_ps(_mm_and_ps(in_bounds, is_farther))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool get_object_corners(Object* obj, Vec3 corners[8]) {
+    if (!obj->is_loaded) return false;
+    if (!obj->is_static) {
+        return physics_get_obb_corners(&obj->physics_body, corners);
+    }
+
+    // Static props have no body, their bounding sphere gives a conservative box.
+    float r = obj->lod.radius;
+    if (r <= 0.0f) return false;
+    for (int i = 0; i < 8; i++) {
+        corners[i] = (Vec3){
+            obj->position.x + ((i & 1) ? r : -r),
+            obj->position.y + ((i & 2) ? r : -r),
+            obj->position.z + ((i & 4) ? r : -r)
+        };
+    }
+    return true;
+}
+
+bool init_occlusion_culler(OcclusionCuller* culler, const Scene* scene) {
+    memset(culler, 0, sizeof(OcclusionCuller));
+
+    culler->occluders = malloc(scene->room_count * MAX_ROOM_QUADS * 12 * sizeof(float));
+    for (int i = 0; i < scene->room_count; i++) {
+        RoomQuad quads[MAX_ROOM_QUADS];
+        int quad_count = build_room_quads(&scene->rooms[i], scene, quads);
+        for (int q = 0; q < quad_count; q++) {
+            if (!quads[q].is_wall) continue;
+            memcpy(&culler->occluders[culler->occluder_count++ * 12], quads[q].vertices, 12 * sizeof(float));
+        }
+    }
+
+    culler->depth = _mm_malloc(OCCLUSION_WIDTH * OCCLUSION_HEIGHT * sizeof(float), 16);
+    culler->start = SDL_CreateSemaphore(0);
+    culler->done = SDL_CreateSemaphore(0);
+    if (culler->depth && culler->start && culler->done) {
+        culler->thread = SDL_CreateThread(occlusion_worker, "occlusion", culler);
+    }
+
+    if (!culler->thread) {
+        printf("[WARNING] Could not start the occlusion culling thread: %s\n", SDL_GetError());
+        return false;
+    }
+
+    printf("[INFO] Occlusion culling with %d wall quads\n", culler->occluder_count);
+    culler->is_ready = true;
+    culler->enabled = true;
+    return true;
+}
+
+void begin_occlusion_frame(OcclusionCuller* culler, const Camera* camera) {
+    if (!culler->is_ready || !culler->enabled || culler->is_pending) return;
+
+    Mat4 view, projection;
+    get_view_matrix(camera, &view);
+    get_projection_matrix(camera, &projection);
+    mat4_multiply(&culler->view_projection, &projection, &view);
+
+    culler->is_pending = true;
+    SDL_SemPost(culler->start);
+}
+
+void cull_occluded_objects(OcclusionCuller* culler, Scene* scene) {
+    if (!culler->is_pending) {
+        for (int i = 0; i < scene->object_count; i++) {
+            scene->objects[i].is_occluded = false;
+        }
+        return;
+    }
+
+    SDL_SemWait(culler->done);
+    culler->is_pending = false;
+
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        Vec3 corners[8];
+
+        obj->is_occluded = false;
+        if (!obj->is_active || !get_object_corners(obj, corners)) continue;
+
+        obj->is_occluded = is_box_occluded(culler, corners);
+        profiler.stats.occlusion_tested++;
+        if (obj->is_occluded) {
+            profiler.stats.occlusion_culled++;
+        }
+    }
+}
+
+void destroy_occlusion_culler(OcclusionCuller* culler) {
+    if (culler->thread) {
+        if (culler->is_pending) {
+            SDL_SemWait(culler->done);
+        }
+        culler->is_quitting = true;
+        SDL_SemPost(culler->start);
+        SDL_WaitThread(culler->thread, NULL);
+    }
+    if (culler->start) SDL_DestroySemaphore(culler->start);
+    if (culler->done) SDL_DestroySemaphore(culler->done);
+    if (culler->depth) _mm_free(culler->depth);
+    free(culler->occluders);
+    memset(culler, 0, sizeof(OcclusionCuller));
+}
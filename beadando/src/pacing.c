@@ -0,0 +1,119 @@
+#include "pacing.h"
+#include <stdio.h>
+#include <string.h>
+
+// Time left before the deadline that is spent spinning instead of sleeping.
+#define SPIN_MARGIN_MS 2
+
+static const char* PACING_NAMES[PACING_MODE_COUNT] = {
+    "vsync",
+    "adaptive",
+    "uncapped",
+    "limit"
+};
+
+void init_frame_pacer(FramePacer* pacer) {
+    pacer->mode = PACING_VSYNC;
+    pacer->target_fps = 60;
+    pacer->next_frame = 0;
+    pacer->idle_throttle = true;
+    pacer->had_activity = true;
+    pacer->quiet_frames = 0;
+}
+
+bool parse_frame_pacing(const char* name, FramePacing* mode) {
+    for (int i = 0; i < PACING_MODE_COUNT; i++) {
+        if (strcmp(name, PACING_NAMES[i]) == 0) {
+            *mode = (FramePacing)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* frame_pacing_name(FramePacing mode) {
+    return PACING_NAMES[mode];
+}
+
+void apply_frame_pacing(FramePacer* pacer, bool has_window) {
+    pacer->next_frame = 0;
+    if (!has_window) return;
+
+    switch (pacer->mode) {
+    case PACING_VSYNC:
+        if (SDL_GL_SetSwapInterval(1) != 0) {
+            printf("[WARNING] Could not enable VSync: %s\n", SDL_GetError());
+        }
+        break;
+    case PACING_ADAPTIVE_VSYNC:
+        // Late frames are presented immediately instead of waiting for the next refresh.
+        if (SDL_GL_SetSwapInterval(-1) != 0) {
+            printf("[WARNING] Adaptive VSync is not supported, using VSync.\n");
+            pacer->mode = PACING_VSYNC;
+            SDL_GL_SetSwapInterval(1);
+        }
+        break;
+    case PACING_UNCAPPED:
+    case PACING_LIMITED:
+        if (SDL_GL_SetSwapInterval(0) != 0) {
+            printf("[WARNING] Could not disable VSync: %s\n", SDL_GetError());
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (pacer->mode == PACING_LIMITED) {
+        printf("[INFO] Frame pacing: %s (%d fps)\n", frame_pacing_name(pacer->mode), pacer->target_fps);
+    }
+    else {
+        printf("[INFO] Frame pacing: %s\n", frame_pacing_name(pacer->mode));
+    }
+}
+
+void cycle_frame_pacing(FramePacer* pacer, bool has_window) {
+    pacer->mode = (FramePacing)((pacer->mode + 1) % PACING_MODE_COUNT);
+    apply_frame_pacing(pacer, has_window);
+}
+
+void wait_for_next_frame(FramePacer* pacer) {
+    if (pacer->mode != PACING_LIMITED || pacer->target_fps <= 0) return;
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 period = frequency / pacer->target_fps;
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    // Start over after a stall instead of rushing frames to catch up.
+    if (pacer->next_frame == 0 || now > pacer->next_frame + period) {
+        pacer->next_frame = now + period;
+        return;
+    }
+
+    // SDL_Delay is only millisecond accurate and may oversleep, the last part is spun.
+    while (now < pacer->next_frame) {
+        Uint64 remaining_ms = (pacer->next_frame - now) * 1000 / frequency;
+        if (remaining_ms > SPIN_MARGIN_MS) {
+            SDL_Delay((Uint32)(remaining_ms - SPIN_MARGIN_MS));
+        }
+        now = SDL_GetPerformanceCounter();
+    }
+
+    pacer->next_frame += period;
+}
+
+bool update_idle_state(FramePacer* pacer, bool is_active) {
+    if (!pacer->idle_throttle || is_active || pacer->had_activity) {
+        pacer->had_activity = false;
+        pacer->quiet_frames = 0;
+        return false;
+    }
+
+    // The first quiet frame is still drawn so that the settled state is presented.
+    pacer->quiet_frames++;
+    return pacer->quiet_frames > 1;
+}
+
+void wait_while_idle(FramePacer* pacer) {
+    SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+    pacer->next_frame = 0;
+}
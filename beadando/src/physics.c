@@ -66,6 +66,7 @@ static void near_callback(void* data, dGeomID o1, dGeomID o2) {
 
         dJointID c = dJointCreateContact(pw->world, pw->contact_group, &contact[i]);
         dJointAttach(c, b1, b2);
+        pw->contact_count++;
 
         PhysicsBody* pb1 = b1 ? (PhysicsBody*)dBodyGetData(b1) : NULL;
         PhysicsBody* pb2 = b2 ? (PhysicsBody*)dBodyGetData(b2) : NULL;
@@ -160,6 +161,14 @@ void physics_create_box(PhysicsWorld* pw, PhysicsBody* pb, double mass, Vec3 pos
     pb->is_active = true;
 }
 
+void physics_destroy_body(PhysicsBody* pb) {
+    if (pb->geom) dGeomDestroy(pb->geom);
+    if (pb->body) dBodyDestroy(pb->body);
+    pb->geom = NULL;
+    pb->body = NULL;
+    pb->is_active = false;
+}
+
 void physics_create_wall_filled(PhysicsWorld* pw, Vec3 center, Vec3 dim, Direction dir, float thickness) {
     float w = dim.x * 0.5f;
     float l = dim.y * 0.5f;
@@ -295,6 +304,8 @@ void physics_simulate(PhysicsWorld* pw, double elapsed) {
     int substeps = 2;
     double subdt = step / substeps;
 
+    pw->contact_count = 0;
+
     for (int i = 0; i < substeps; ++i) {
         dSpaceCollide(pw->space, pw, &near_callback);
         dWorldQuickStep(pw->world, subdt);
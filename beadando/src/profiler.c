@@ -0,0 +1,139 @@
+#include "profiler.h"
+#include "arena.h"
+#include "draw.h"
+#include <stdio.h>
+#include <string.h>
+
+Profiler profiler;
+
+static const char* SECTION_NAMES[PROFILE_SECTION_COUNT] = {
+    "Events",
+    "Camera",
+    "Physics",
+    "Sync",
+    "Extraction",
+    "Occlusion",
+    "Render",
+    "Swap"
+};
+
+void init_profiler() {
+    memset(&profiler, 0, sizeof(Profiler));
+    profiler.ticks_to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+    profiler.frame_start = SDL_GetPerformanceCounter();
+    profiler.frame_allocations_start = get_thread_heap_allocations();
+}
+
+void profiler_begin(ProfileSection section) {
+    profiler.section_start[section] = SDL_GetPerformanceCounter();
+}
+
+void profiler_end(ProfileSection section) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    profiler.section_ms[section] += (now - profiler.section_start[section]) * profiler.ticks_to_ms;
+    trace_record(SECTION_NAMES[section], profiler.section_start[section], now);
+}
+
+static void fold_history(const double* history, int count, double* average, double* max) {
+    double sum = 0.0;
+    *max = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += history[i];
+        if (history[i] > *max) *max = history[i];
+    }
+    *average = count > 0 ? sum / count : 0.0;
+}
+
+void profiler_end_frame() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    int index = profiler.history_index;
+
+    profiler.frame_history[index] = (now - profiler.frame_start) * profiler.ticks_to_ms;
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) {
+        profiler.section_history[s][index] = profiler.section_ms[s];
+        profiler.section_ms[s] = 0.0;
+    }
+
+    profiler.history_index = (index + 1) % PROFILER_HISTORY;
+    if (profiler.history_count < PROFILER_HISTORY) {
+        profiler.history_count++;
+    }
+
+    fold_history(profiler.frame_history, profiler.history_count, &profiler.frame_average, &profiler.frame_max);
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) {
+        fold_history(profiler.section_history[s], profiler.history_count,
+            &profiler.section_average[s], &profiler.section_max[s]);
+    }
+
+    // Counted on the main thread only, the loader workers allocate while streaming.
+    long allocations = get_thread_heap_allocations();
+    profiler.stats.heap_allocations = allocations >= 0 ? allocations - profiler.frame_allocations_start : -1;
+    profiler.frame_allocations_start = allocations;
+
+    profiler.last_stats = profiler.stats;
+    memset(&profiler.stats, 0, sizeof(FrameStats));
+    trace_record("Frame", profiler.frame_start, now);
+    trace_end_frame();
+    profiler.frame_start = now;
+}
+
+static void draw_hud_line(GLuint charmap, const char* text, int line, float top) {
+    // draw_string expects a y-flipped space, like the manual.
+    draw_string(charmap, text, 0.5f, -(top - line - 1.5f), 1.0f);
+}
+
+void draw_profiler_hud(GLuint charmap, int width, int height) {
+    const float PIXELS_PER_LINE = 18.0f;
+    float right = width / PIXELS_PER_LINE;
+    float top = height / PIXELS_PER_LINE;
+    char text[96];
+    int line = 0;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_2D);
+    glColor3f(1.0f, 1.0f, 1.0f);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, right, 0.0, top, -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glScalef(1.0f, -1.0f, 1.0f);
+
+    double fps = profiler.frame_average > 0.0 ? 1000.0 / profiler.frame_average : 0.0;
+    snprintf(text, sizeof(text), "Frame      %6.2f ms  max %6.2f  (%.0f fps)",
+        profiler.frame_average, profiler.frame_max, fps);
+    draw_hud_line(charmap, text, line++, top);
+
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) {
+        snprintf(text, sizeof(text), "%-10s %6.2f ms  max %6.2f",
+            SECTION_NAMES[s], profiler.section_average[s], profiler.section_max[s]);
+        draw_hud_line(charmap, text, line++, top);
+    }
+
+    const FrameStats* stats = &profiler.last_stats;
+    snprintf(text, sizeof(text), "Bodies awake %d  Contacts %d", stats->awake_bodies, stats->contacts);
+    draw_hud_line(charmap, text, line++, top);
+    snprintf(text, sizeof(text), "Draw calls %d  Texture binds %d", stats->draw_calls, stats->texture_binds);
+    draw_hud_line(charmap, text, line++, top);
+    snprintf(text, sizeof(text), "Occlusion culled %d / %d", stats->occlusion_culled, stats->occlusion_tested);
+    draw_hud_line(charmap, text, line++, top);
+    snprintf(text, sizeof(text), "Object triangles %d  LOD %d/%d/%d/%d", stats->triangles,
+        stats->lod_objects[0], stats->lod_objects[1], stats->lod_objects[2], stats->lod_objects[3]);
+    draw_hud_line(charmap, text, line++, top);
+    if (stats->heap_allocations >= 0) {
+        snprintf(text, sizeof(text), "Heap allocations %ld  Frame arena %zu KB", stats->heap_allocations,
+            frame_arena.peak / 1024);
+        draw_hud_line(charmap, text, line++, top);
+    }
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
@@ -1,9 +1,12 @@
 #include "room.h"
 #include "scene.h"
+#include <math.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "draw.h"
 #include "physics.h"
+#include "trace.h"
 
 void add_room(Scene* scene, RoomConfig* config) {
     Room* room = &scene->rooms[scene->room_count];
@@ -11,6 +14,7 @@ void add_room(Scene* scene, RoomConfig* config) {
     strncpy(room->name, config->name, sizeof(room->name) - 1);
     room->dimension = config->dimension;
     room->position = (Vec3){ 0,0,0 };
+    add_name(&scene->room_index, room->name, room->id);
     
     for (int d = 0; d < DIR_COUNT; d++) {
         strncpy(room->connections[d].room,
@@ -20,33 +24,26 @@ void add_room(Scene* scene, RoomConfig* config) {
         room->connections[d].dir = config->connections[d].dir;
     }
 
-    if (config->floor_tex_path[0] != '\0') {
-        room->floor_tex = load_texture(config->floor_tex_path);
-    }
-    else {
+    if (config->floor_tex_path[0] == '\0') {
         printf("[WARNING]: No texture set for floor in room '%s'.\n", room->name);
-        room->floor_tex = 0;
     }
+    room->floor_tex = 0;
 
-    if (config->ceiling_tex_path[0] != '\0') {
-        room->ceiling_tex = load_texture(config->ceiling_tex_path);
-    }
-    else {
+    if (config->ceiling_tex_path[0] == '\0') {
         printf("[WARNING]: No texture set for ceiling in room '%s'.\n", room->name);
-        room->ceiling_tex = 0;
     }
+    room->ceiling_tex = 0;
 
-    if (config->wall_tex_path[0] != '\0') {
-        room->wall_tex = load_texture(config->wall_tex_path);
-    }
-    else {
+    if (config->wall_tex_path[0] == '\0') {
         printf("[WARNING]: No texture set for walls in room '%s'.\n", room->name);
-        room->wall_tex = 0;
     }
+    room->wall_tex = 0;
 
     room->wall_thickness = 0.1f;
     room->door_width = 1.5f;
     room->door_height = 2.0f;
+    room->residency = ROOM_UNLOADED;
+    room->memory_bytes = 0;
 
     scene->room_count++;
     printf("Added room %d: %s  (%.1f x %.1f x %.1f)\n",
@@ -56,7 +53,49 @@ void add_room(Scene* scene, RoomConfig* config) {
         room->dimension.z);
 }
 
-Vec3 calculate_world_position(Room* room, ObjectConfig* config) {
+void queue_room_textures(Room* room, const RoomConfig* config, AssetLoader* loader) {
+    if (config->floor_tex_path[0] != '\0') {
+        queue_texture_load(loader, config->floor_tex_path, &room->floor_tex, NULL);
+    }
+    if (config->ceiling_tex_path[0] != '\0') {
+        queue_texture_load(loader, config->ceiling_tex_path, &room->ceiling_tex, NULL);
+    }
+    if (config->wall_tex_path[0] != '\0') {
+        queue_texture_load(loader, config->wall_tex_path, &room->wall_tex, NULL);
+    }
+}
+
+void release_room_assets(Room* room) {
+    GLuint textures[3] = { room->floor_tex, room->ceiling_tex, room->wall_tex };
+    for (int i = 0; i < 3; i++) {
+        if (textures[i] != 0) glDeleteTextures(1, &textures[i]);
+    }
+    if (room->display_list != 0) {
+        glDeleteLists(room->display_list, 1);
+    }
+
+    room->floor_tex = 0;
+    room->ceiling_tex = 0;
+    room->wall_tex = 0;
+    room->display_list = 0;
+    room->display_list_binds = 0;
+    room->is_batched = false;
+    room->residency = ROOM_UNLOADED;
+    room->memory_bytes = 0;
+}
+
+int find_room_at(const Scene* scene, Vec3 position) {
+    for (int i = 0; i < scene->room_count; i++) {
+        const Room* room = &scene->rooms[i];
+        if (fabsf(position.x - room->position.x) <= room->dimension.x * 0.5f
+            && fabsf(position.y - room->position.y) <= room->dimension.y * 0.5f) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+Vec3 calculate_world_position(Room* room, const ObjectConfig* config) {
     float half_width = room->dimension.x * 0.5f;
     float half_length = room->dimension.y * 0.5f;
 
@@ -84,7 +123,7 @@ Vec3 constrain_to_room(Vec3 position, Room* room, Vec3 mesh_half_ext) {
     return position;
 }
 
-bool needs_connector(Room* room, Room* neighbor, Direction dir) {
+bool needs_connector(const Room* room, const Room* neighbor, Direction dir) {
     if (room->dimension.z > neighbor->dimension.z) {
         return true;
     }
@@ -96,6 +135,220 @@ bool needs_connector(Room* room, Room* neighbor, Direction dir) {
     return room->dimension.y > neighbor->dimension.y;
 }
 
+static void add_room_quad(RoomQuad* quads, int* count, GLuint texture, bool is_wall, float uv[4][2], float vertices[4][3]) {
+    RoomQuad* quad = &quads[(*count)++];
+    quad->texture = texture;
+    quad->is_wall = is_wall;
+    quad->normal[0] = 0.0f;
+    quad->normal[1] = 0.0f;
+    quad->normal[2] = 1.0f;
+    memcpy(quad->uv, uv, sizeof(quad->uv));
+    memcpy(quad->vertices, vertices, sizeof(quad->vertices));
+}
+
+int build_room_quads(const Room* room, const Scene* scene, RoomQuad quads[MAX_ROOM_QUADS]) {
+    int count = 0;
+    float w = room->dimension.x * 0.5f;
+    float l = room->dimension.y * 0.5f;
+    float h = room->dimension.z;
+    float px = room->position.x;
+    float py = room->position.y;
+    float pz = room->position.z;
+
+    float door_h = room->door_height;
+    float half_w = w * 0.5f;
+    float half_d = room->door_width * 0.5f;
+
+    float v1 = door_h / h;
+    float u1, u2;
+
+    float solid_uv[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+    float top_uv[4][2] = { {0, v1}, {1, v1}, {1, 1}, {0, 1} };
+
+    add_room_quad(quads, &count, room->floor_tex, false, solid_uv,
+        (float[4][3]) {
+            { px - w, py - l, pz },
+            { px + w, py - l, pz },
+            { px + w, py + l, pz },
+            { px - w, py + l, pz }
+    }
+    );
+
+    add_room_quad(quads, &count, room->ceiling_tex, false, solid_uv,
+        (float[4][3]) {
+            { px - w, py - l, pz + h },
+            { px + w, py - l, pz + h },
+            { px + w, py + l, pz + h },
+            { px - w, py + l, pz + h }
+    }
+    );
+
+    for (int d = 0; d < DIR_COUNT; d++) {
+        if (room->connections[d].room[0] == '\0') {
+            float vertices[4][3];
+
+            switch (d) {
+            case DIR_NORTH:
+                memcpy(vertices, (float[4][3]) {
+                    { px - w, py + l, pz },
+                    { px + w, py + l, pz },
+                    { px + w, py + l, pz + h },
+                    { px - w, py + l, pz + h }
+                }, sizeof(vertices));
+                break;
+            case DIR_EAST:
+                memcpy(vertices, (float[4][3]) {
+                    { px + w, py - l, pz },
+                    { px + w, py + l, pz },
+                    { px + w, py + l, pz + h },
+                    { px + w, py - l, pz + h }
+                }, sizeof(vertices));
+                break;
+            case DIR_SOUTH:
+                memcpy(vertices, (float[4][3]) {
+                    { px + w, py - l, pz },
+                    { px - w, py - l, pz },
+                    { px - w, py - l, pz + h },
+                    { px + w, py - l, pz + h }
+                }, sizeof(vertices));
+                break;
+            case DIR_WEST:
+                memcpy(vertices, (float[4][3]) {
+                    { px - w, py + l, pz },
+                    { px - w, py - l, pz },
+                    { px - w, py - l, pz + h },
+                    { px - w, py + l, pz + h }
+                }, sizeof(vertices));
+                break;
+            }
+
+            add_room_quad(quads, &count, room->wall_tex, true, solid_uv, vertices);
+        }
+        else {
+            int neighbor_idx = room->connections[d].id;
+            if (neighbor_idx < 0 || neighbor_idx >= scene->room_count) continue;
+
+            const Room* neighbor_room = &scene->rooms[neighbor_idx];
+            if (!needs_connector(room, neighbor_room, d)) continue;
+
+            if (d == DIR_NORTH || d == DIR_SOUTH) {
+                u1 = (half_w - half_d) / w;
+                u2 = (half_w + half_d) / w;
+            }
+            else {
+                u1 = (l - half_d) / (2 * l);
+                u2 = (l + half_d) / (2 * l);
+            }
+
+            float left_uv[4][2] = { {0, 0}, {u1, 0}, {u1, v1}, {0, v1} };
+            float right_uv[4][2] = { {u2, 0}, {1, 0}, {1, v1}, {u2, v1} };
+            float top_vertices[4][3];
+            float left_vertices[4][3];
+            float right_vertices[4][3];
+
+            switch (d) {
+            case DIR_NORTH:
+                memcpy(top_vertices, (float[4][3]) {
+                    { px - w, py + l, pz + door_h },
+                    { px + w, py + l, pz + door_h },
+                    { px + w, py + l, pz + h },
+                    { px - w, py + l, pz + h }
+                }, sizeof(top_vertices));
+
+                memcpy(left_vertices, (float[4][3]) {
+                    { px - w, py + l, pz },
+                    { px - half_d, py + l, pz },
+                    { px - half_d, py + l, pz + door_h },
+                    { px - w, py + l, pz + door_h }
+                }, sizeof(left_vertices));
+
+                memcpy(right_vertices, (float[4][3]) {
+                    { px + half_d, py + l, pz },
+                    { px + w, py + l, pz },
+                    { px + w, py + l, pz + door_h },
+                    { px + half_d, py + l, pz + door_h }
+                }, sizeof(right_vertices));
+                break;
+
+            case DIR_EAST:
+                memcpy(top_vertices, (float[4][3]) {
+                    { px + w, py - l, pz + door_h },
+                    { px + w, py + l, pz + door_h },
+                    { px + w, py + l, pz + h },
+                    { px + w, py - l, pz + h }
+                }, sizeof(top_vertices));
+
+                memcpy(left_vertices, (float[4][3]) {
+                    { px + w, py - l, pz },
+                    { px + w, py - half_d, pz },
+                    { px + w, py - half_d, pz + door_h },
+                    { px + w, py - l, pz + door_h }
+                }, sizeof(left_vertices));
+
+                memcpy(right_vertices, (float[4][3]) {
+                    { px + w, py + half_d, pz },
+                    { px + w, py + l, pz },
+                    { px + w, py + l, pz + door_h },
+                    { px + w, py + half_d, pz + door_h }
+                }, sizeof(right_vertices));
+                break;
+
+            case DIR_SOUTH:
+                memcpy(top_vertices, (float[4][3]) {
+                    { px + w, py - l, pz + door_h },
+                    { px - w, py - l, pz + door_h },
+                    { px - w, py - l, pz + h },
+                    { px + w, py - l, pz + h }
+                }, sizeof(top_vertices));
+
+                memcpy(left_vertices, (float[4][3]) {
+                    { px + w, py - l, pz },
+                    { px + half_d, py - l, pz },
+                    { px + half_d, py - l, pz + door_h },
+                    { px + w, py - l, pz + door_h }
+                }, sizeof(left_vertices));
+
+                memcpy(right_vertices, (float[4][3]) {
+                    { px - half_d, py - l, pz },
+                    { px - w, py - l, pz },
+                    { px - w, py - l, pz + door_h },
+                    { px - half_d, py - l, pz + door_h }
+                }, sizeof(right_vertices));
+                break;
+
+            case DIR_WEST:
+                memcpy(top_vertices, (float[4][3]) {
+                    { px - w, py + l, pz + door_h },
+                    { px - w, py - l, pz + door_h },
+                    { px - w, py - l, pz + h },
+                    { px - w, py + l, pz + h }
+                }, sizeof(top_vertices));
+
+                memcpy(left_vertices, (float[4][3]) {
+                    { px - w, py + l, pz },
+                    { px - w, py + half_d, pz },
+                    { px - w, py + half_d, pz + door_h },
+                    { px - w, py + l, pz + door_h }
+                }, sizeof(left_vertices));
+
+                memcpy(right_vertices, (float[4][3]) {
+                    { px - w, py - half_d, pz },
+                    { px - w, py - l, pz },
+                    { px - w, py - l, pz + door_h },
+                    { px - w, py - half_d, pz + door_h }
+                }, sizeof(right_vertices));
+                break;
+            }
+
+            add_room_quad(quads, &count, room->wall_tex, true, top_uv, top_vertices);
+            add_room_quad(quads, &count, room->wall_tex, true, left_uv, left_vertices);
+            add_room_quad(quads, &count, room->wall_tex, true, right_uv, right_vertices);
+        }
+    }
+
+    return count;
+}
+
 void place_rooms_by_connections(Scene* scene) {
     for (int i = 0; i < scene->room_count; i++) {
         Room* room = &scene->rooms[i];
@@ -103,16 +356,15 @@ void place_rooms_by_connections(Scene* scene) {
         for (int d = 0; d < DIR_COUNT; d++) {
             if (room->connections[d].room[0] == '\0') continue;
 
-            for (int j = 0; j < scene->room_count; j++) {
-                if (strcmp(scene->rooms[j].name, room->connections[d].room) == 0) {
-                    room->connections[d].id = j;
-                    break;
-                }
+            int connected = find_name(&scene->room_index, room->connections[d].room);
+            if (connected >= 0) {
+                room->connections[d].id = connected;
             }
         }
     }
 
-    RoomPlacement placement[MAX_ROOMS] = { {0} };
+    int slot_count = scene->room_count > 0 ? scene->room_count : 1;
+    RoomPlacement* placement = calloc(slot_count, sizeof(RoomPlacement));
     for (int i = 0; i < scene->room_count; ++i) {
         placement[i].idx = i;
         placement[i].placed = false;
@@ -120,21 +372,15 @@ void place_rooms_by_connections(Scene* scene) {
         placement[i].gy = 0;
     }
 
-    int start_idx = -1;
-    for (int i = 0; i < scene->room_count; ++i) {
-        if (strcmp(scene->rooms[i].name, "start_room") == 0) {
-            start_idx = i;
-            break;
-        }
-    }
-
+    int start_idx = find_name(&scene->room_index, "start_room");
     if (start_idx < 0) start_idx = 0;
 
     placement[start_idx].placed = true;
     placement[start_idx].gx = 0;
     placement[start_idx].gy = 0;
 
-    int queue[MAX_ROOMS], qh = 0, qt = 0;
+    int* queue = malloc(slot_count * sizeof(int));
+    int qh = 0, qt = 0;
     queue[qt++] = start_idx;
 
     while (qh < qt) {
@@ -173,6 +419,8 @@ void place_rooms_by_connections(Scene* scene) {
             }
         }
     }
+    free(placement);
+    free(queue);
 
     for (int i = 0; i < scene->room_count; ++i) {
         Room* room = &scene->rooms[i];
@@ -205,10 +453,18 @@ void place_rooms_by_connections(Scene* scene) {
                 );
             }
         }
+    }
+}
+
+void compile_room_display_lists(Scene* scene) {
+    trace_begin("Room display lists");
+    for (int i = 0; i < scene->room_count; ++i) {
+        if (scene->rooms[i].residency == ROOM_UNLOADED || scene->rooms[i].display_list != 0) continue;
 
         scene->rooms[i].display_list = glGenLists(1);
         glNewList(scene->rooms[i].display_list, GL_COMPILE);
-        draw_room(&scene->rooms[i], scene);
+        scene->rooms[i].display_list_binds = draw_room(&scene->rooms[i], scene);
         glEndList();
     }
+    trace_end();
 }
\ No newline at end of file
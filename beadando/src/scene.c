@@ -1,90 +1,267 @@
 #include "scene.h"
+#include "config_bundle.h"
 #include "draw.h"
-#include <obj/load.h>
-#include <obj/draw.h>
+#include "profiler.h"
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-void init_scene(Scene* scene) {
+/**
+ * Create the physics and display of an object once its model and texture are both in.
+ */
+static void finish_object_loading(Scene* scene, Object* obj) {
+    trace_begin("Object physics and display lists");
+    if (obj->is_static) {
+        create_static_physics_and_display(obj, scene);
+    } else {
+        create_dynamic_physics_and_display(obj, scene, scene->object_configs[obj->id].mass);
+    }
+    trace_end();
+
+    // An evicted prop was asleep, it continues exactly where it was left.
+    if (obj->is_evicted && !obj->is_static) {
+        dQuaternion q = { obj->orientation.w, obj->orientation.x, obj->orientation.y, obj->orientation.z };
+        dBodySetQuaternion(obj->physics_body.body, q);
+        dBodyDisable(obj->physics_body.body);
+        obj->physics_body.is_sleeping = true;
+    }
+
+    obj->memory_bytes = get_texture_memory(obj->texture_id) + get_lod_chain_memory(&obj->lod);
+    obj->is_evicted = false;
+    obj->is_loaded = true;
+}
+
+static void handle_loaded_asset(Scene* scene, AssetJob* job) {
+    Object* obj = job->object;
+    if (obj == NULL) return;
+
+    if (job->type == ASSET_MODEL && !obj->is_evicted) {
+        place_object(scene, obj, job->config);
+        if (scene->extraction.object != NULL && obj == scene->extraction.object[0]) {
+            set_extraction_zone(&scene->extraction, obj);
+        }
+    }
+
+    obj->pending_assets--;
+    if (obj->pending_assets == 0) {
+        finish_object_loading(scene, obj);
+    }
+}
+
+/**
+ * Join the loader and batch the rooms and static props that arrived after the first frame.
+ */
+static void complete_scene_loading(Scene* scene) {
+    finish_asset_loader(&scene->loader);
+    finish_room_streaming(scene);
+    scene->is_loading = false;
+
+    invalidate_static_world(&scene->static_world, scene);
+
+    // The size recorded when the display lists were compiled stays after trimming, so reloads are not counted twice.
+    size_t uploaded_bytes = 0, resident_bytes = 0;
+    for (int i = 0; i < scene->object_count; i++) {
+        const LodChain* lod = &scene->objects[i].lod;
+        size_t cpu_bytes = get_lod_chain_cpu_memory(lod);
+        resident_bytes += cpu_bytes;
+        uploaded_bytes += lod->display_list_bytes > cpu_bytes ? lod->display_list_bytes : cpu_bytes;
+    }
+    printf("[INFO] CPU mesh memory: %zu KB before trimming, %zu KB resident\n",
+        uploaded_bytes / 1024, resident_bytes / 1024);
+}
+
+void update_scene_loading(Scene* scene) {
+    if (scene->static_world.dirty_count > 0) {
+        TRACE_ZONE("Update static world", update_static_world(&scene->static_world, scene, SCENE_LOADING_BUDGET_MS));
+    }
+    if (!scene->is_loading) return;
+
+    trace_begin("Scene loading");
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = SDL_GetPerformanceFrequency() * SCENE_LOADING_BUDGET_MS / 1000;
+    AssetJob* job;
+    while (SDL_GetPerformanceCounter() - start < budget && (job = poll_asset(&scene->loader)) != NULL) {
+        handle_loaded_asset(scene, job);
+    }
+
+    if (!has_pending_assets(&scene->loader)) {
+        complete_scene_loading(scene);
+    }
+    trace_end();
+}
+
+void wait_for_scene_loading(Scene* scene) {
+    if (!scene->is_loading) return;
+
+    AssetJob* job;
+    while ((job = wait_for_asset(&scene->loader)) != NULL) {
+        handle_loaded_asset(scene, job);
+    }
+    complete_scene_loading(scene);
+    update_static_world(&scene->static_world, scene, 0);
+}
+
+void init_scene(Scene* scene, int load_threads, int stream_budget_mb) {
+    // Everything living as long as the scene comes from the arena and is freed at once by free_scene.
+    init_arena(&scene->arena, SCENE_ARENA_BLOCK_SIZE);
+
     scene->material.ambient = (ColorRGB){ 0.2, 0.2, 0.2 };
     scene->material.diffuse = (ColorRGB){ 0.8, 0.8, 0.8 };
     scene->material.specular = (ColorRGB){ 0.2, 0.2, 0.2 };
     scene->material.shininess = 20.0;
     set_material(&scene->material);
 
-    init_physics(&scene->physics_world);
+    TRACE_ZONE("Init physics", init_physics(&scene->physics_world));
+    scene->load_threads = load_threads;
+    scene->is_loading = false;
 
+    // The compiled bundle is copied from when it is up to date, the JSON files are parsed otherwise.
+    ConfigBundle bundle;
+    bool has_bundle = open_config_bundle(&bundle, "config/room_config.json", "config/object_config.json",
+        "config/light_config.json");
+    if (has_bundle) {
+        printf("[INFO] Reading the configs from %s\n", CONFIG_BUNDLE_PATH);
+    }
+
+    // The configs are kept for reloading the evicted rooms, the room and object at index i come from config i.
     int room_config_count = 0;
-    RoomConfig room_configs[MAX_ROOMS];
-    read_room_config("config/room_config.json", room_configs, &room_config_count);
-    print_room_configs(room_configs, room_config_count);
+    if (has_bundle) {
+        scene->room_configs = ARENA_ARRAY(&scene->arena, RoomConfig, bundle.header->room_count);
+        read_bundled_room_config(&bundle, scene->room_configs, &room_config_count);
+    }
+    else {
+        RoomConfig* room_configs = read_room_config("config/room_config.json", &room_config_count);
+        scene->room_configs = ARENA_ARRAY(&scene->arena, RoomConfig, room_config_count);
+        if (room_config_count > 0) memcpy(scene->room_configs, room_configs, room_config_count * sizeof(RoomConfig));
+        free(room_configs);
+    }
+    print_room_configs(scene->room_configs, room_config_count);
 
-    scene->rooms = calloc(room_config_count, sizeof(Room));
+    scene->rooms = ARENA_ARRAY(&scene->arena, Room, room_config_count);
     scene->room_count = 0;
+    init_name_index(&scene->room_index, room_config_count);
     for (int i = 0; i < room_config_count; i++) {
-        add_room(scene, &room_configs[i]);
+        add_room(scene, &scene->room_configs[i]);
     }
 
     place_rooms_by_connections(scene);
 
     int light_config_count = 0;
     Lighting light_configs[MAX_LIGHTS];
-    read_light_config("config/light_config.json", light_configs, &light_config_count);
+    if (has_bundle) {
+        read_bundled_light_config(&bundle, light_configs, &light_config_count);
+    }
+    else {
+        read_light_config("config/light_config.json", light_configs, &light_config_count);
+    }
 
-    scene->lights = calloc(light_config_count, sizeof(Lighting));
+    // Sized for the most the config can hold, so a reloaded config can add lights in place.
+    scene->lights = ARENA_ARRAY(&scene->arena, Lighting, MAX_LIGHTS);
     scene->light_count = 0;
+    init_name_index(&scene->light_index, light_config_count);
     for (int i = 0; i < light_config_count; i++) {
         add_light(scene, &light_configs[i]);
     }
 
     print_light_configs(scene->lights, scene->light_count);
 
-    int obj_config_count = 0;
-    ObjectConfig obj_configs[MAX_OBJECTS];
-    read_object_config("config/object_config.json", obj_configs, &obj_config_count);
-    print_object_configs(obj_configs, obj_config_count);
+    // The object arrays have headroom, so a reloaded config can add objects in place.
+    scene->object_config_count = 0;
+    if (has_bundle) {
+        scene->object_capacity = (int)bundle.header->object_count + OBJECT_RELOAD_HEADROOM;
+        scene->object_configs = ARENA_ARRAY(&scene->arena, ObjectConfig, scene->object_capacity);
+        read_bundled_object_config(&bundle, scene->object_configs, &scene->object_config_count);
+        close_config_bundle(&bundle);
+    }
+    else {
+        int object_config_count = 0;
+        ObjectConfig* object_configs = read_object_config("config/object_config.json", &object_config_count);
+        scene->object_capacity = object_config_count + OBJECT_RELOAD_HEADROOM;
+        scene->object_configs = ARENA_ARRAY(&scene->arena, ObjectConfig, scene->object_capacity);
+        memcpy(scene->object_configs, object_configs, object_config_count * sizeof(ObjectConfig));
+        scene->object_config_count = object_config_count;
+        free(object_configs);
+    }
+    print_object_configs(scene->object_configs, scene->object_config_count);
 
-    scene->objects = calloc(obj_config_count, sizeof(Object));
+    scene->objects = ARENA_ARRAY(&scene->arena, Object, scene->object_capacity);
     scene->object_count = 0;
     scene->selected_object_id = -1;
+    init_name_index(&scene->object_index, scene->object_config_count);
     
-    for (int i = 0; i < obj_config_count; i++) {
-        add_object(scene, &obj_configs[i]);
+    for (int i = 0; i < scene->object_config_count; i++) {
+        add_object(scene, &scene->object_configs[i]);
     }
-    
+
     init_extraction(scene);
 
-    for (int i = 0; i < scene->object_count; i++) {
-        ObjectConfig* config = find_object_config_by_name(obj_configs, obj_config_count, scene->objects[i].name);
-        if (config) {
-            if (scene->objects[i].is_static) {
-                create_static_physics_and_display(&scene->objects[i], scene);
-            } else {
-                create_dynamic_physics_and_display(&scene->objects[i], scene, config->mass);
-            }
-        }
+    // Static objects are translated in their display lists, so their model matrix stays the identity.
+    scene->model_matrices = ARENA_ARRAY(&scene->arena, Mat4, scene->object_capacity);
+    scene->modelview_matrices = ARENA_ARRAY(&scene->arena, Mat4, scene->object_capacity);
+    for (int i = 0; i < scene->object_capacity; i++) {
+        mat4_identity(&scene->model_matrices[i]);
     }
+    mat4_identity(&scene->view_matrix);
 
     physics_create_ground_plane(&scene->physics_world);
     dReal gravity[] = { 0.0, 0.0, -8.0 };
     physics_init_gravity(&scene->physics_world, gravity);
 
-    printf("Scene initialized with %d lights, %d objects in %d rooms\n",
-        scene->light_count, scene->object_count, scene->room_count);
+    // The first room is placed at the origin where the camera starts.
+    init_room_streamer(&scene->streamer, scene, 0, stream_budget_mb);
+    start_room_streaming(scene, STREAMING_PREFETCH_DISTANCE);
+
+    // Only the room textures are waited for, the objects are drawn as placeholders until they arrive.
+    int room_texture_count = 0;
+    for (int i = 0; i < scene->loader.job_count; i++) {
+        if (scene->loader.jobs[i].object == NULL) room_texture_count++;
+    }
+    trace_begin("Wait for room textures");
+    while (room_texture_count > 0) {
+        AssetJob* job = wait_for_asset(&scene->loader);
+        if (job == NULL) break;
+        if (job->type == ASSET_TEXTURE && job->object == NULL) {
+            room_texture_count--;
+        }
+        handle_loaded_asset(scene, job);
+    }
+    trace_end();
+
+    compile_room_display_lists(scene);
+    TRACE_ZONE("Build static world", build_static_world(&scene->static_world, scene));
+
+    printf("Scene initialized with %d lights, %d objects in %d rooms, %d assets still loading\n",
+        scene->light_count, scene->object_count, scene->room_count,
+        scene->loader.job_count - scene->loader.consumed_count);
 }
 
-void create_static_physics_and_display(Object* obj, Scene* scene) {
-    Vec3 mesh_min, mesh_max;
-    calculate_mesh_aabb(&obj->model, &mesh_min, &mesh_max);
-    obj->position.z = fmaxf(obj->position.z - mesh_min.z, 0.01f);
+/**
+ * Compile a display list for each level of detail, static objects are translated in the list.
+ */
+static void compile_object_display_lists(Object* obj, bool is_translated) {
+    obj->lod.display_list_bytes = get_lod_chain_cpu_memory(&obj->lod);
+    for (int i = 0; i < obj->lod.level_count; i++) {
+        obj->lod.display_lists[i] = glGenLists(1);
+        glNewList(obj->lod.display_lists[i], GL_COMPILE);
+        glBindTexture(GL_TEXTURE_2D, obj->texture_id);
+        if (is_translated) {
+            glPushMatrix();
+            glTranslatef(obj->position.x, obj->position.y, obj->position.z);
+        }
+        draw_mesh(&obj->lod.levels[i]);
+        if (is_translated) {
+            glPopMatrix();
+        }
+        glEndList();
+    }
+}
 
-    Vec3 mesh_half_ext = {
-        fmaxf((mesh_max.x - mesh_min.x) * 0.5f, 0.01f),
-        fmaxf((mesh_max.y - mesh_min.y) * 0.5f, 0.01f),
-        fmaxf((mesh_max.z - mesh_min.z) * 0.5f, 0.01f)
-    };
+void create_static_physics_and_display(Object* obj, Scene* scene) {
+    if (!obj->is_evicted) {
+        obj->position.z = fmaxf(obj->position.z - obj->aabb_min.z, 0.01f);
+    }
+    Vec3 mesh_half_ext = object_half_extents(obj);
 
     dGeomID geom = dCreateBox(scene->physics_world.space,
         mesh_half_ext.x * 2,
@@ -95,62 +272,42 @@ void create_static_physics_and_display(Object* obj, Scene* scene) {
     obj->physics_body.geom = geom;
     obj->physics_body.body = NULL;
 
-    obj->display_list = glGenLists(1);
-    glNewList(obj->display_list, GL_COMPILE);
-    glBindTexture(GL_TEXTURE_2D, obj->texture_id);
-    glPushMatrix();
-    glTranslatef(obj->position.x, obj->position.y, obj->position.z);
-    draw_model(&obj->model);
-    glPopMatrix();
-    glEndList();
+    compile_object_display_lists(obj, true);
+
+    // The static world is rebuilt from the levels whenever rooms come and go, without it they are not needed.
+    if (!gl_features.buffer_objects) {
+        trim_lod_chain(&obj->lod);
+    }
 }
 
 void create_dynamic_physics_and_display(Object* obj, Scene* scene, float mass) {
-    Vec3 mesh_min, mesh_max;
-    calculate_mesh_aabb(&obj->model, &mesh_min, &mesh_max);
-    obj->position.z = fmaxf(obj->position.z - mesh_min.z, 0.01f);
-
-    Vec3 mesh_half_ext = {
-        fmaxf((mesh_max.x - mesh_min.x) * 0.5f, 0.01f),
-        fmaxf((mesh_max.y - mesh_min.y) * 0.5f, 0.01f),
-        fmaxf((mesh_max.z - mesh_min.z) * 0.5f, 0.01f)
-    };
+    if (!obj->is_evicted) {
+        obj->position.z = fmaxf(obj->position.z - obj->aabb_min.z, 0.01f);
+    }
+    Vec3 mesh_half_ext = object_half_extents(obj);
     
     physics_create_box(&scene->physics_world, &obj->physics_body, mass, obj->position, mesh_half_ext);
     obj->physics_body.user_data = obj;
 
-    obj->display_list = glGenLists(1);
-    glNewList(obj->display_list, GL_COMPILE);
-    glBindTexture(GL_TEXTURE_2D, obj->texture_id);
-    draw_model(&obj->model);
-    glEndList();
+    compile_object_display_lists(obj, false);
+
+    // The body is a box around the bounds, so only the display lists need the mesh.
+    trim_lod_chain(&obj->lod);
 }
 
 Room* find_room_by_name(Scene* scene, const char* name) {
-    for (int i = 0; i < scene->room_count; i++) {
-        if (strcmp(scene->rooms[i].name, name) == 0) {
-            return &scene->rooms[i];
-        }
-    }
-    return NULL;
+    int index = find_name(&scene->room_index, name);
+    return index >= 0 ? &scene->rooms[index] : NULL;
 }
 
 Lighting* find_light_by_name(Scene* scene, const char* name) {
-    for (int i = 0; i < scene->light_count; i++) {
-        if (strcmp(scene->lights[i].name, name) == 0) {
-            return &scene->lights[i];
-        }
-    }
-    return NULL;
+    int index = find_name(&scene->light_index, name);
+    return index >= 0 ? &scene->lights[index] : NULL;
 }
 
 Object* find_object_by_name(Scene* scene, const char* name) {
-    for (int i = 0; i < scene->object_count; i++) {
-        if (strcmp(scene->objects[i].name, name) == 0) {
-            return &scene->objects[i];
-        }
-    }
-    return NULL;
+    int index = find_name(&scene->object_index, name);
+    return index >= 0 ? &scene->objects[index] : NULL;
 }
 
 Object* find_object_by_id(Scene* scene, int id) {
@@ -164,73 +321,126 @@ void update_scene(Scene* scene, double elapsed_time) {
     static float total_time = 0.0f;
     total_time += elapsed_time;
 
+    update_scene_loading(scene);
     update_lighting(scene, total_time);
-    physics_simulate(&scene->physics_world, elapsed_time);
-    sync_physics_transforms(scene);
-    update_extraction(scene);
+    PROFILE(PROFILE_PHYSICS, physics_simulate(&scene->physics_world, elapsed_time));
+    PROFILE(PROFILE_SYNC, sync_physics_transforms(scene));
+    PROFILE(PROFILE_EXTRACTION, update_extraction(scene));
+
+    profiler.stats.awake_bodies = count_awake_objects(scene);
+    profiler.stats.contacts = scene->physics_world.contact_count;
 }
 
-void render_scene(const Scene* scene) {
-    for (int i = 0; i < scene->light_count; i++) {
-        if (scene->lights[i].enabled) {
-            glEnable(GL_LIGHT0 + scene->lights[i].slot);
-            set_lighting(i, &scene->lights[i]);
+void apply_scene_lights(const Scene* scene, int first) {
+    for (int i = 0; i < MAX_LIGHTS; i++) {
+        int index = first + i;
+        if (index < scene->light_count && scene->lights[index].enabled) {
+            glEnable(GL_LIGHT0 + i);
+            set_lighting(i, &scene->lights[index]);
         }
         else {
-            glDisable(GL_LIGHT0 + scene->lights[i].slot);
+            glDisable(GL_LIGHT0 + i);
         }
     }
+}
 
+void draw_scene_geometry(const Scene* scene) {
+    if (scene->static_world.is_ready) {
+        set_material(&scene->material);
+        draw_static_world(&scene->static_world, scene);
+    }
     for (int i = 0; i < scene->room_count; i++) {
+        if (scene->rooms[i].display_list == 0 || (scene->static_world.is_ready && scene->rooms[i].is_batched)) continue;
         glCallList(scene->rooms[i].display_list);
+        profiler.stats.draw_calls++;
+        profiler.stats.texture_binds += scene->rooms[i].display_list_binds;
     }
 
-    draw_extraction_status(scene);
-
     for (int i = 0; i < scene->object_count; i++) {
         Object* obj = &scene->objects[i];
-        if (!obj->is_active) continue;
-        
+        if (!obj->is_active || obj->is_occluded || obj->static_batch >= 0) continue;
+
+        if (!obj->is_loaded) {
+            if (scene->rooms[obj->room_id].residency == ROOM_UNLOADED) continue;
+            set_material(&obj->material);
+            glLoadMatrixf(scene->view_matrix.m);
+            draw_placeholder_box(obj->position, PLACEHOLDER_HALF_SIZE);
+            profiler.stats.draw_calls++;
+            profiler.stats.texture_binds++;
+            continue;
+        }
+
+        int level = obj->lod.current;
+        GLuint display_list = obj->lod.display_lists[level];
+
         set_material(&obj->material);
+        profiler.stats.draw_calls++;
+        profiler.stats.texture_binds++;
+        profiler.stats.triangles += obj->lod.triangle_counts[level];
+        profiler.stats.lod_objects[level]++;
 
-        if (obj->is_static) {
-            glCallList(obj->display_list);
-        }
-        else {
-            const dReal* M = dBodyGetRotation(scene->objects[i].physics_body.body);
-            GLfloat mat[16] = {
-                (GLfloat)M[0], (GLfloat)M[4], (GLfloat)M[8],  0,
-                (GLfloat)M[1], (GLfloat)M[5], (GLfloat)M[9],  0,
-                (GLfloat)M[2], (GLfloat)M[6], (GLfloat)M[10], 0,
-                0,             0,             0,              1
-            };
+        glLoadMatrixf(scene->modelview_matrices[i].m);
+        glCallList(display_list);
+    }
 
-            glPushMatrix();
-            glTranslatef(
-                obj->position.x,
-                obj->position.y,
-                obj->position.z
-            );
-            glMultMatrixf(mat);
-
-            glCallList(obj->display_list);
-            glPopMatrix();
-        }
-        
-        if (scene->selected_object_id == obj->id) {
-            draw_bounding_box(&obj->physics_body);
+    glLoadMatrixf(scene->view_matrix.m);
+}
+
+void draw_scene_overlays(const Scene* scene) {
+    draw_extraction_status(scene);
+
+    Object* selected = find_object_by_id((Scene*)scene, scene->selected_object_id);
+    if (selected && selected->is_active) {
+        draw_bounding_box(&selected->physics_body);
+    }
+}
+
+void render_scene(const Scene* scene) {
+    if (scene->light_count <= MAX_LIGHTS) {
+        apply_scene_lights(scene, 0);
+        draw_scene_geometry(scene);
+    }
+    else {
+        // Fixed-function lighting is limited to MAX_LIGHTS, so accumulate the rest in additive passes.
+        const GLfloat no_ambient[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const GLfloat default_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+
+        for (int first = 0; first < scene->light_count; first += MAX_LIGHTS) {
+            if (first == MAX_LIGHTS) {
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                glLightModelfv(GL_LIGHT_MODEL_AMBIENT, no_ambient);
+            }
+            apply_scene_lights(scene, first);
+            draw_scene_geometry(scene);
         }
+
+        glLightModelfv(GL_LIGHT_MODEL_AMBIENT, default_ambient);
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
     }
+
+    draw_scene_overlays(scene);
 }
 
 void free_scene(Scene* scene) {
+    if (scene->is_loading) {
+        finish_asset_loader(&scene->loader);
+        scene->is_loading = false;
+    }
+    destroy_static_world(&scene->static_world);
+    free_name_index(&scene->room_index);
+    free_name_index(&scene->light_index);
+    free_name_index(&scene->object_index);
+
     if (scene->objects != NULL) {
         for (int i = 0; i < scene->object_count; i++) {
-            glDeleteLists(scene->objects[i].display_list, 1);
+            free_lod_chain(&scene->objects[i].lod);
             glDeleteTextures(1, &scene->objects[i].texture_id);
-            free_model(&scene->objects[i].model);
         }
-        free(scene->lights);
-        free(scene->objects);
     }
+    free_arena(&scene->arena);
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "shader.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+char* read_text_file(const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("[ERROR] Cannot open %s\n", filename);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char* data = malloc(len + 1);
+    if (!data) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read = fread(data, 1, len, fp);
+    data[read] = '\0';
+    fclose(fp);
+
+    return data;
+}
+
+static GLuint compile_shader(GLenum type, const char* filename) {
+    char* source = read_text_file(filename);
+    if (!source) return 0;
+
+    GLuint shader = glCreateShader(type);
+    const GLchar* sources[] = { source };
+    glShaderSource(shader, 1, sources, NULL);
+    glCompileShader(shader);
+    free(source);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("[ERROR] Failed to compile %s:\n%s\n", filename, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+GLuint load_shader_program(const char* vertex_path, const char* fragment_path) {
+    if (!gl_features.shaders) {
+        printf("[WARNING] Shaders are not supported by the OpenGL context.\n");
+        return 0;
+    }
+
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_path);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_path);
+    if (!vertex_shader || !fragment_shader) {
+        if (vertex_shader) glDeleteShader(vertex_shader);
+        if (fragment_shader) glDeleteShader(fragment_shader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        printf("[ERROR] Failed to link %s + %s:\n%s\n", vertex_path, fragment_path, log);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
@@ -0,0 +1,196 @@
+#include "streaming.h"
+#include "scene.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Breadth-first search over the connections from the current room, unreachable rooms get INT_MAX.
+ */
+static void update_room_distances(RoomStreamer* streamer, const Scene* scene) {
+    int* queue = streamer->queue;
+    int head = 0;
+    int tail = 0;
+
+    for (int i = 0; i < scene->room_count; i++) {
+        streamer->distances[i] = INT_MAX;
+    }
+    streamer->distances[streamer->current_room] = 0;
+    queue[tail++] = streamer->current_room;
+
+    while (head < tail) {
+        const Room* room = &scene->rooms[queue[head++]];
+        for (int d = 0; d < DIR_COUNT; d++) {
+            if (room->connections[d].room[0] == '\0') continue;
+
+            int next = room->connections[d].id;
+            if (next < 0 || next >= scene->room_count || streamer->distances[next] != INT_MAX) continue;
+
+            streamer->distances[next] = streamer->distances[room->id] + 1;
+            queue[tail++] = next;
+        }
+    }
+}
+
+void init_room_streamer(RoomStreamer* streamer, Scene* scene, int start_room, int budget_mb) {
+    streamer->current_room = start_room;
+    streamer->distances = ARENA_ARRAY(&scene->arena, int, scene->room_count > 0 ? scene->room_count : 1);
+    streamer->queue = ARENA_ARRAY(&scene->arena, int, scene->room_count > 0 ? scene->room_count : 1);
+    streamer->budget_bytes = (size_t)(budget_mb > 0 ? budget_mb : DEFAULT_STREAMING_BUDGET_MB) << 20;
+    streamer->is_budget_exceeded = false;
+    update_room_distances(streamer, scene);
+}
+
+bool start_room_streaming(Scene* scene, int max_distance) {
+    const RoomStreamer* streamer = &scene->streamer;
+    int room_count = 0;
+
+    for (int i = 0; i < scene->room_count; i++) {
+        if (scene->rooms[i].residency == ROOM_UNLOADED && streamer->distances[i] <= max_distance) {
+            room_count++;
+        }
+    }
+    if (room_count == 0) return false;
+
+    init_asset_loader(&scene->loader, scene->load_threads);
+    for (int i = 0; i < scene->room_count; i++) {
+        Room* room = &scene->rooms[i];
+        if (room->residency != ROOM_UNLOADED || streamer->distances[i] > max_distance) continue;
+
+        queue_room_textures(room, &scene->room_configs[i], &scene->loader);
+        room->residency = ROOM_LOADING;
+        printf("[INFO] Streaming in room %s (%d doors away)\n", room->name, streamer->distances[i]);
+    }
+
+    // The props go with the room they stand in, the awake ones were never released.
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (!obj->is_active || obj->is_loaded || obj->pending_assets > 0) continue;
+        if (scene->rooms[obj->room_id].residency != ROOM_LOADING) continue;
+
+        queue_object_assets(obj, &scene->object_configs[i], &scene->loader);
+    }
+
+    start_asset_loader(&scene->loader);
+    scene->is_loading = true;
+    return true;
+}
+
+void finish_room_streaming(Scene* scene) {
+    for (int i = 0; i < scene->room_count; i++) {
+        Room* room = &scene->rooms[i];
+        if (room->residency != ROOM_LOADING) continue;
+
+        room->residency = ROOM_RESIDENT;
+        room->memory_bytes = get_texture_memory(room->floor_tex)
+            + get_texture_memory(room->ceiling_tex)
+            + get_texture_memory(room->wall_tex);
+    }
+    compile_room_display_lists(scene);
+
+    printf("[INFO] Resident rooms and objects: %.1f MB of %.1f MB\n",
+        get_resident_memory(scene) / 1048576.0, scene->streamer.budget_bytes / 1048576.0);
+}
+
+size_t get_resident_memory(const Scene* scene) {
+    size_t bytes = 0;
+    for (int i = 0; i < scene->room_count; i++) {
+        bytes += scene->rooms[i].memory_bytes;
+    }
+    for (int i = 0; i < scene->object_count; i++) {
+        bytes += scene->objects[i].memory_bytes;
+    }
+    return bytes;
+}
+
+/**
+ * Release the room with the props standing in it, the awake and the selected ones stay loaded.
+ */
+static void evict_room(Scene* scene, Room* room) {
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (!obj->is_loaded || obj->room_id != room->id) continue;
+        if (!obj->is_static && (!obj->physics_body.is_sleeping || obj->id == scene->selected_object_id)) continue;
+
+        release_object_assets(obj);
+    }
+
+    printf("[INFO] Evicted room %s (%d doors away)\n", room->name, scene->streamer.distances[room->id]);
+    release_room_assets(room);
+}
+
+/**
+ * Evict the farthest resident rooms until the budget holds, the rooms next to the player are never evicted.
+ */
+static void enforce_streaming_budget(Scene* scene) {
+    RoomStreamer* streamer = &scene->streamer;
+    size_t resident_bytes = get_resident_memory(scene);
+    if (resident_bytes <= streamer->budget_bytes) return;
+
+    // The moved props belong to the room they are in now.
+    for (int i = 0; i < scene->object_count; i++) {
+        Object* obj = &scene->objects[i];
+        if (!obj->is_loaded || obj->is_static) continue;
+
+        int room = find_room_at(scene, obj->position);
+        if (room >= 0) obj->room_id = room;
+    }
+
+    bool is_evicted = false;
+    while (resident_bytes > streamer->budget_bytes) {
+        Room* farthest = NULL;
+        for (int i = 0; i < scene->room_count; i++) {
+            Room* room = &scene->rooms[i];
+            if (room->residency != ROOM_RESIDENT || streamer->distances[i] <= STREAMING_RESIDENT_DISTANCE) continue;
+            if (farthest == NULL || streamer->distances[i] > streamer->distances[farthest->id]) {
+                farthest = room;
+            }
+        }
+
+        if (farthest == NULL) {
+            if (!streamer->is_budget_exceeded) {
+                printf("[WARNING] The rooms next to the player need %.1f MB, over the %.1f MB streaming budget\n",
+                    resident_bytes / 1048576.0, streamer->budget_bytes / 1048576.0);
+            }
+            streamer->is_budget_exceeded = true;
+            break;
+        }
+
+        // Without room for the prefetched rooms they are only loaded once they are next to the player.
+        if (streamer->distances[farthest->id] <= STREAMING_PREFETCH_DISTANCE) {
+            streamer->is_budget_exceeded = true;
+        }
+        evict_room(scene, farthest);
+        resident_bytes = get_resident_memory(scene);
+        is_evicted = true;
+    }
+
+    // Only the batches of the evicted rooms and props are uploaded again, spread over the next frames.
+    if (is_evicted) {
+        invalidate_static_world(&scene->static_world, scene);
+    }
+}
+
+void update_room_streaming(Scene* scene, Vec3 player_position) {
+    RoomStreamer* streamer = &scene->streamer;
+
+    int room = find_room_at(scene, player_position);
+    if (room >= 0 && room != streamer->current_room) {
+        streamer->current_room = room;
+        streamer->is_budget_exceeded = false;
+        update_room_distances(streamer, scene);
+    }
+
+    // The loader writes the objects it prepares, nothing is evicted while it runs.
+    if (scene->is_loading) return;
+
+    enforce_streaming_budget(scene);
+    start_room_streaming(scene, streamer->is_budget_exceeded ? STREAMING_RESIDENT_DISTANCE : STREAMING_PREFETCH_DISTANCE);
+}
+
+void load_all_rooms(Scene* scene) {
+    wait_for_scene_loading(scene);
+    if (start_room_streaming(scene, INT_MAX)) {
+        wait_for_scene_loading(scene);
+    }
+}
@@ -1,31 +1,310 @@
 #include "texture.h"
+#include "bake.h"
+#include "dds.h"
+#include "gl_loader.h"
+#include "trace.h"
+#include <emmintrin.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+static GLuint upload_buffers[TEXTURE_UPLOAD_BUFFERS];
+static int next_upload_buffer = 0;
+
 GLuint load_texture(char* filename) {
+    TextureImage image;
+    decode_texture(filename, &image);
+    return upload_texture(&image);
+}
+
+static void copy_rows(const unsigned char* source, int pitch, unsigned char* target, int row_size, int height) {
+    for (int y = 0; y < height; y++) {
+        memcpy(target + (size_t)y * row_size, source + (size_t)y * pitch, row_size);
+    }
+}
+
+static void swap_red_blue_rows(const unsigned char* source, int pitch, unsigned char* target, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        const unsigned char* from = source + (size_t)y * pitch;
+        unsigned char* to = target + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++) {
+            to[x * 3] = from[x * 3 + 2];
+            to[x * 3 + 1] = from[x * 3 + 1];
+            to[x * 3 + 2] = from[x * 3];
+        }
+    }
+}
+
+/**
+ * Convert 32 bit rows into RGBA, swapping red and blue and forcing the alpha to opaque when asked.
+ * Four pixels go through SSE2 registers at a time, the bytes of a pixel are a little endian 32 bit word.
+ */
+static void swizzle_rows(const unsigned char* source, int pitch, unsigned char* target, int width, int height,
+    bool is_swapped, bool is_opaque) {
+    const __m128i green_alpha_mask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i red_blue_mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i alpha = _mm_set1_epi32(is_opaque ? (int)0xFF000000 : 0);
+
+    for (int y = 0; y < height; y++) {
+        const uint32_t* from = (const uint32_t*)(source + (size_t)y * pitch);
+        uint32_t* to = (uint32_t*)(target + (size_t)y * width * 4);
+        int x = 0;
+
+        for (; x + 4 <= width; x += 4) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(from + x));
+            if (is_swapped) {
+                __m128i red_blue = _mm_and_si128(pixels, red_blue_mask);
+                red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+                pixels = _mm_or_si128(_mm_and_si128(pixels, green_alpha_mask), red_blue);
+            }
+            _mm_storeu_si128((__m128i*)(to + x), _mm_or_si128(pixels, alpha));
+        }
+        for (; x < width; x++) {
+            uint32_t pixel = from[x];
+            if (is_swapped) {
+                pixel = (pixel & 0xFF00FF00u) | ((pixel & 0xFFu) << 16) | ((pixel >> 16) & 0xFFu);
+            }
+            to[x] = is_opaque ? pixel | 0xFF000000u : pixel;
+        }
+    }
+}
+
+/**
+ * Pack the pixels of a surface in the formats SDL_image returns directly, false for the rest.
+ */
+static bool pack_surface(const SDL_Surface* surface, TextureImage* image) {
+    const unsigned char* source = surface->pixels;
+    int width = surface->w;
+    int height = surface->h;
+
+    switch (surface->format->format) {
+    case SDL_PIXELFORMAT_RGB24:
+    case SDL_PIXELFORMAT_BGR24:
+        image->format = GL_RGB;
+        image->pixels = malloc((size_t)width * height * 3);
+        if (surface->format->format == SDL_PIXELFORMAT_RGB24) {
+            copy_rows(source, surface->pitch, image->pixels, width * 3, height);
+        }
+        else {
+            swap_red_blue_rows(source, surface->pitch, image->pixels, width, height);
+        }
+        return true;
+    case SDL_PIXELFORMAT_RGBA32:
+    case SDL_PIXELFORMAT_BGRA32:
+    case SDL_PIXELFORMAT_BGR888:
+    case SDL_PIXELFORMAT_RGB888:
+        image->format = GL_RGBA;
+        image->pixels = malloc((size_t)width * height * 4);
+        swizzle_rows(source, surface->pitch, image->pixels, width, height,
+            surface->format->format == SDL_PIXELFORMAT_BGRA32 || surface->format->format == SDL_PIXELFORMAT_RGB888,
+            surface->format->format == SDL_PIXELFORMAT_BGR888 || surface->format->format == SDL_PIXELFORMAT_RGB888);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool pack_locked_surface(SDL_Surface* surface, TextureImage* image) {
+    if (SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0) return false;
+    bool is_packed = pack_surface(surface, image);
+    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+    return is_packed;
+}
+
+bool decode_texture(const char* filename, TextureImage* image) {
+    const char* extension = strrchr(filename, '.');
+    if (extension != NULL && SDL_strcasecmp(extension, ".dds") == 0) {
+        if (!gl_features.texture_compression) {
+            printf("[ERROR] %s needs S3TC texture compression\n", filename);
+            memset(image, 0, sizeof(TextureImage));
+            return false;
+        }
+        bool is_read;
+        TRACE_ZONE("Read DDS", is_read = read_dds(filename, image, NULL));
+        return is_read;
+    }
+
+    bool is_decoded = false;
+    if (gl_features.texture_compression) {
+        TRACE_ZONE("Read baked texture", is_decoded = load_baked_texture(filename, image));
+    }
+    if (!is_decoded) {
+        TRACE_ZONE("Decode image", is_decoded = decode_image(filename, image));
+    }
+    return is_decoded;
+}
+
+bool decode_image(const char* filename, TextureImage* image) {
+    memset(image, 0, sizeof(TextureImage));
+
     SDL_Surface* surface = IMG_Load(filename);
     if (!surface) {
         printf("[ERROR] IMG_Load(\"%s\"): %s\n",
                 filename, IMG_GetError());
+        return false;
+    }
+
+    image->width = surface->w;
+    image->height = surface->h;
+    bool is_packed = pack_locked_surface(surface, image);
+
+    // Palettes, 16 bit and the other rare formats are converted by SDL first.
+    if (!is_packed) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        is_packed = converted != NULL && pack_locked_surface(converted, image);
+        SDL_FreeSurface(converted);
+    }
+    SDL_FreeSurface(surface);
+
+    if (!is_packed) {
+        printf("[ERROR] Unsupported pixel format in %s: %s\n", filename, SDL_GetError());
+        free_texture_image(image);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy the pixels into the next pixel buffer and leave it bound, returns 0 when it cannot be mapped.
+ */
+static GLuint stage_pixels(const TextureImage* image, size_t size) {
+    if (upload_buffers[0] == 0) {
+        glGenBuffers(TEXTURE_UPLOAD_BUFFERS, upload_buffers);
+    }
+    GLuint buffer = upload_buffers[next_upload_buffer];
+    next_upload_buffer = (next_upload_buffer + 1) % TEXTURE_UPLOAD_BUFFERS;
+
+    // Orphaning the old storage lets the driver finish the transfer from it in the background.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (mapped == NULL) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
         return 0;
     }
 
-    GLuint texture_name;
+    memcpy(mapped, image->pixels, size);
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+    return buffer;
+}
 
-    glGenTextures(1, &texture_name);
+/**
+ * Upload the stored mipmap levels as they are, the blocks need no conversion.
+ */
+static void upload_compressed_levels(const TextureImage* image) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->level_count - 1);
 
-    glBindTexture(GL_TEXTURE_2D, texture_name);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, surface->w, surface->h, 0, GL_RGB, GL_UNSIGNED_BYTE, (Pixel*)(surface->pixels));
+    const unsigned char* level = image->pixels;
+    int width = image->width, height = image->height;
+    for (int i = 0; i < image->level_count; i++) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, image->format, width, height, 0, (GLsizei)image->level_sizes[i], level);
+        level += image->level_sizes[i];
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
 
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+/**
+ * Define every level of the bound texture from the image, replacing what it held before.
+ */
+static void define_texture(TextureImage* image) {
+    size_t size = (size_t)image->width * image->height * (image->format == GL_RGBA ? 4 : 3);
 
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    SDL_FreeSurface(surface);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (!gl_features.generate_mipmap) {
+        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, image->is_compressed ? GL_FALSE : GL_TRUE);
+    }
+    if (image->is_compressed) {
+        upload_compressed_levels(image);
+        return;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+
+    // The RGB rows are tightly packed, not aligned to 4 bytes.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLuint buffer = gl_features.pixel_buffers ? stage_pixels(image, size) : 0;
+    glTexImage2D(GL_TEXTURE_2D, 0, image->format == GL_RGBA ? GL_RGBA8 : GL_RGB8,
+        image->width, image->height, 0, image->format, GL_UNSIGNED_BYTE,
+        buffer != 0 ? NULL : image->pixels);
+    if (buffer != 0) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (gl_features.generate_mipmap) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+GLuint upload_texture(TextureImage* image) {
+    if (image->pixels == NULL) {
+        return 0;
+    }
+
+    trace_begin("Upload texture");
+    GLuint texture_name;
+    glGenTextures(1, &texture_name);
+    glBindTexture(GL_TEXTURE_2D, texture_name);
+    define_texture(image);
+    free_texture_image(image);
+    trace_end();
 
     return texture_name;
 }
+
+void replace_texture(GLuint texture, TextureImage* image) {
+    if (texture != 0 && image->pixels != NULL) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        define_texture(image);
+    }
+    free_texture_image(image);
+}
+
+void free_texture_image(TextureImage* image) {
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+size_t get_texture_memory(GLuint texture) {
+    if (texture == 0) {
+        return 0;
+    }
+
+    GLint width = 0;
+    GLint height = 0;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    GLint is_compressed = GL_FALSE;
+    GLint compressed_size = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &is_compressed);
+    if (is_compressed) {
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (is_compressed) {
+        return (size_t)compressed_size * 4 / 3;
+    }
+
+    // Drivers keep RGB textures with four bytes per texel, the mipmaps add a third.
+    return (size_t)width * height * 4 * 4 / 3;
+}
+
+void destroy_texture_uploads(void) {
+    if (upload_buffers[0] != 0) {
+        glDeleteBuffers(TEXTURE_UPLOAD_BUFFERS, upload_buffers);
+        memset(upload_buffers, 0, sizeof(upload_buffers));
+    }
+}
@@ -0,0 +1,169 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Recording state shared by the threads.
+ */
+typedef struct Tracer {
+    SDL_atomic_t is_recording;
+    const char* path;
+    int frame_limit;
+    int frame_count;
+    Uint64 start;
+    double ticks_to_us;
+    TraceBuffer buffers[TRACE_MAX_THREADS];
+} Tracer;
+
+static Tracer tracer;
+
+// Claimed by each thread on its first zone, NULL after the buffers ran out.
+static _Thread_local TraceBuffer* thread_buffer;
+static _Thread_local bool has_thread_buffer;
+
+void start_trace(const char* path, int frame_count) {
+    memset(&tracer, 0, sizeof(Tracer));
+    tracer.path = path;
+    tracer.frame_limit = frame_count > 0 ? frame_count : DEFAULT_TRACE_FRAMES;
+    tracer.start = SDL_GetPerformanceCounter();
+    tracer.ticks_to_us = 1000000.0 / SDL_GetPerformanceFrequency();
+    SDL_AtomicSet(&tracer.is_recording, 1);
+
+    trace_thread_name("Main");
+}
+
+static TraceBuffer* get_thread_buffer(void) {
+    if (has_thread_buffer) return thread_buffer;
+    has_thread_buffer = true;
+
+    for (int t = 0; t < TRACE_MAX_THREADS; t++) {
+        TraceBuffer* buffer = &tracer.buffers[t];
+        if (!SDL_AtomicCAS(&buffer->is_claimed, 0, 1)) continue;
+
+        if (buffer->events == NULL) {
+            snprintf(buffer->thread_name, sizeof(buffer->thread_name), "Thread %d", t);
+            buffer->events = malloc(TRACE_BUFFER_EVENTS * sizeof(TraceEvent));
+        }
+        buffer->depth = 0;
+        thread_buffer = buffer;
+        return buffer;
+    }
+    return NULL;
+}
+
+void trace_thread_exit(void) {
+    if (thread_buffer != NULL) {
+        SDL_AtomicSet(&thread_buffer->is_claimed, 0);
+    }
+    thread_buffer = NULL;
+    has_thread_buffer = false;
+}
+
+void trace_thread_name(const char* name) {
+    if (!SDL_AtomicGet(&tracer.is_recording)) return;
+
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer != NULL) {
+        snprintf(buffer->thread_name, sizeof(buffer->thread_name), "%s", name);
+    }
+}
+
+void trace_begin(const char* name) {
+    if (!SDL_AtomicGet(&tracer.is_recording)) return;
+
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer == NULL || buffer->depth == TRACE_MAX_DEPTH) return;
+    buffer->open_names[buffer->depth] = name;
+    buffer->open_starts[buffer->depth] = SDL_GetPerformanceCounter();
+    buffer->depth++;
+}
+
+void trace_end(void) {
+    TraceBuffer* buffer = thread_buffer;
+    if (buffer == NULL || buffer->depth == 0) return;
+
+    buffer->depth--;
+    trace_record(buffer->open_names[buffer->depth], buffer->open_starts[buffer->depth], SDL_GetPerformanceCounter());
+}
+
+void trace_record(const char* name, Uint64 start, Uint64 end) {
+    if (!SDL_AtomicGet(&tracer.is_recording)) return;
+
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer == NULL) return;
+
+    int count = SDL_AtomicGet(&buffer->count);
+    if (count == TRACE_BUFFER_EVENTS) {
+        buffer->dropped++;
+        return;
+    }
+    buffer->events[count] = (TraceEvent){ name, start, end };
+    // The atomic store is a full barrier, the writer sees the event before the count.
+    SDL_AtomicSet(&buffer->count, count + 1);
+}
+
+/**
+ * Write the published events as Chrome trace events, one complete event per zone.
+ */
+static void write_trace(void) {
+    FILE* file = fopen(tracer.path, "w");
+    if (file == NULL) {
+        printf("[WARNING] Cannot write the trace %s\n", tracer.path);
+        return;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"beadando\"}}");
+
+    int event_count = 0, thread_count = 0, dropped = 0;
+    for (int t = 0; t < TRACE_MAX_THREADS; t++) {
+        TraceBuffer* buffer = &tracer.buffers[t];
+        int count = SDL_AtomicGet(&buffer->count);
+        if (count == 0) continue;
+
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            t + 1, buffer->thread_name);
+
+        for (int i = 0; i < count; i++) {
+            const TraceEvent* event = &buffer->events[i];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                event->name, t + 1,
+                (double)(event->start - tracer.start) * tracer.ticks_to_us,
+                (double)(event->end - event->start) * tracer.ticks_to_us);
+        }
+        event_count += count;
+        thread_count++;
+        dropped += buffer->dropped;
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("[INFO] Wrote %d trace events of %d threads to %s", event_count, thread_count, tracer.path);
+    if (dropped > 0) {
+        printf(", %d events dropped", dropped);
+    }
+    printf("\n");
+}
+
+void trace_end_frame(void) {
+    if (!SDL_AtomicGet(&tracer.is_recording)) return;
+
+    if (++tracer.frame_count == tracer.frame_limit) {
+        SDL_AtomicSet(&tracer.is_recording, 0);
+        write_trace();
+    }
+}
+
+void finish_trace(void) {
+    if (SDL_AtomicGet(&tracer.is_recording)) {
+        SDL_AtomicSet(&tracer.is_recording, 0);
+        write_trace();
+    }
+
+    for (int t = 0; t < TRACE_MAX_THREADS; t++) {
+        free(tracer.buffers[t].events);
+        tracer.buffers[t].events = NULL;
+    }
+}